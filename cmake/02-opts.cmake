@@ -21,6 +21,8 @@ checklib(WITH_XKB "pkg-config" xcb-xkb)
 checklib(WITH_XRM "pkg-config" xcb-xrm)
 checklib(WITH_XRANDR_MONITORS "pkg-config" "xcb-randr>=1.12")
 checklib(WITH_XCURSOR "pkg-config" "xcb-cursor")
+checklib(WITH_XSHM "pkg-config" xcb-shm)
+checklib(WITH_HARFBUZZ "pkg-config" harfbuzz)
 
 if(NOT DEFINED ENABLE_CCACHE AND CMAKE_BUILD_TYPE_UPPER MATCHES DEBUG)
   set(ENABLE_CCACHE ON)
@@ -48,8 +50,12 @@ option(WITH_XCOMPOSITE "xcb-composite support" ON)
 option(WITH_XKB "xcb-xkb support" ON)
 option(WITH_XRM "xcb-xrm support" ON)
 option(WITH_XCURSOR "xcb-cursor support" ON)
+option(WITH_XSHM "xcb-shm support" ON)
+
+option(WITH_HARFBUZZ "Text shaping using harfbuzz" ON)
 
 option(DEBUG_LOGGER "Trace logging" ON)
+option(DEBUG_ALLOCATIONS "Count heap allocations of traced stages" OFF)
 
 if(CMAKE_BUILD_TYPE_UPPER MATCHES DEBUG)
   option(DEBUG_LOGGER_VERBOSE "Trace logging (verbose)" OFF)
@@ -78,5 +84,7 @@ set(SETTING_PATH_MEMORY_INFO "/proc/meminfo"
   CACHE STRING "Path to file containing memory info")
 set(SETTING_PATH_MESSAGING_FIFO "/tmp/polybar_mqueue.%pid%"
   CACHE STRING "Path to file containing the current temperature")
+set(SETTING_PATH_MESSAGING_SOCKET "/tmp/polybar_ipc.%pid%.sock"
+  CACHE STRING "Path to the ipc socket")
 set(SETTING_PATH_TEMPERATURE_INFO "/sys/class/thermal/thermal_zone%zone%/temp"
   CACHE STRING "Path to file containing the current temperature")
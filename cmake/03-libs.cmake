@@ -23,6 +23,9 @@ querylib(WITH_XRANDR "pkg-config" xcb-randr libs dirs)
 querylib(WITH_XRANDR_MONITORS "pkg-config" "xcb-randr>=1.12" libs dirs)
 querylib(WITH_XRM "pkg-config" xcb-xrm libs dirs)
 querylib(WITH_XCURSOR "pkg-config" xcb-cursor libs dirs)
+querylib(WITH_XSHM "pkg-config" xcb-shm libs dirs)
+
+querylib(WITH_HARFBUZZ "pkg-config" harfbuzz libs dirs)
 
 # FreeBSD Support
 if(CMAKE_SYSTEM_NAME STREQUAL "FreeBSD")
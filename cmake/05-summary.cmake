@@ -36,9 +36,14 @@ colored_option("   xcb-composite" WITH_XCOMPOSITE)
 colored_option("   xcb-xkb" WITH_XKB)
 colored_option("   xcb-xrm" WITH_XRM)
 colored_option("   xcb-cursor" WITH_XCURSOR)
+colored_option("   xcb-shm" WITH_XSHM)
+
+message(STATUS " Font rendering:")
+colored_option("   harfbuzz" WITH_HARFBUZZ)
 
 message(STATUS " Log options:")
 colored_option("   Trace logging" DEBUG_LOGGER)
+colored_option("   Allocation counting" DEBUG_ALLOCATIONS)
 
 if(CMAKE_BUILD_TYPE_UPPER MATCHES DEBUG)
   message(STATUS " Debug options:")
@@ -19,10 +19,19 @@ if [ "$POLYBAR_BUILD_TYPE" == "minimal" ]; then
   "-DWITH_XKB=OFF"
   "-DWITH_XRANDR_MONITORS=OFF"
   "-DWITH_XCURSOR=OFF"
+  "-DWITH_XSHM=OFF"
+  "-DWITH_HARFBUZZ=OFF"
   "-DWITH_XRANDR=ON"
   )
 fi
 
+# Count allocations so that the tests can check the render loop doesn't allocate
+if [ "$POLYBAR_BUILD_TYPE" == "tests" ]; then
+  FLAGS=(
+  "-DDEBUG_ALLOCATIONS=ON"
+  )
+fi
+
 cmake \
   -DCMAKE_CXX_COMPILER="${CXX}" \
   -DCMAKE_CXX_FLAGS="${CXXFLAGS} -Werror" \
@@ -415,6 +415,7 @@ screenchange-reload = true
 ;compositing-foreground = source
 ;compositing-border = over
 ;pseudo-transparency = false
+;shm-presentation = false
 
 [global/wm]
 margin-top = 5
@@ -4,7 +4,6 @@
 #include <cstdlib>
 
 #include <arpa/inet.h>
-#include <ifaddrs.h>
 
 #include "common.hpp"
 #include "settings.hpp"
@@ -16,6 +15,7 @@
 #include <net/if.h>
 
 struct nl_msg;
+struct nl_sock;
 struct nlattr;
 #else
 #include <iwlib.h>
@@ -30,6 +30,8 @@ struct nlattr;
 #endif
 #endif
 
+struct nlmsghdr;
+
 POLYBAR_NS
 
 class file_descriptor;
@@ -53,7 +55,7 @@ namespace net {
     }
   };
 
-  using bytes_t = unsigned int;
+  using bytes_t = unsigned long long;
 
   struct link_activity {
     bytes_t transmitted{0};
@@ -90,12 +92,25 @@ namespace net {
     void check_tuntap_or_bridge();
     bool test_interface() const;
     string format_speedrate(float bytes_diff, int minwidth) const;
-    void query_ip6();
+
+    bool rtnl_request(unsigned short type, bool dump, bool accumulate);
+    bool rtnl_receive(unsigned int seq, bool accumulate);
+    void parse_link(const struct nlmsghdr* msg, bool reply, bool accumulate);
+    void parse_address(const struct nlmsghdr* msg);
+
+    bool ping_icmp(int timeout_ms) const;
+    bool ping_udp(int timeout_ms) const;
 
     const logger& m_log;
     unique_ptr<file_descriptor> m_socketfd;
+    unique_ptr<file_descriptor> m_rtnlfd;
     link_status m_status{};
     string m_interface;
+    unsigned int m_ifid{0};
+    unsigned int m_rtnl_seq{0};
+    unsigned int m_rtnl_portid{0};
+    unsigned char m_operstate{0};
+    bool m_addr_changed{true};
     bool m_tuntap{false};
     bool m_bridge{false};
     bool m_unknown_up{false};
@@ -123,7 +138,8 @@ namespace net {
 
   class wireless_network : public network {
    public:
-    wireless_network(string interface) : network(interface), m_ifid(if_nametoindex(interface.c_str())){};
+    explicit wireless_network(string interface) : network(interface) {}
+    ~wireless_network() override;
 
     bool query(bool accumulate = false) override;
     bool connected() const override;
@@ -134,6 +150,8 @@ namespace net {
    protected:
     static int scan_cb(struct nl_msg* msg, void* instance);
 
+    bool connect_nl80211();
+    void disconnect_nl80211();
     bool associated_or_joined(struct nlattr** bss);
     void parse_essid(struct nlattr** bss);
     void parse_frequency(struct nlattr** bss);
@@ -141,7 +159,8 @@ namespace net {
     void parse_signal(struct nlattr** bss);
 
    private:
-    unsigned int m_ifid{};
+    struct nl_sock* m_nl_sock{nullptr};
+    struct nl_msg* m_nl_msg{nullptr};
     string m_essid{};
     int m_frequency{};
     quality_range m_signalstrength{};
@@ -154,7 +173,7 @@ namespace net {
 
   class wireless_network : public network {
    public:
-    wireless_network(string interface) : network(interface) {}
+    explicit wireless_network(string interface) : network(interface) {}
 
     bool query(bool accumulate = false) override;
     bool connected() const override;
@@ -168,6 +187,7 @@ namespace net {
     void query_quality(const int& socket_fd);
 
    private:
+    unique_ptr<file_descriptor> m_iwsocket;
     shared_ptr<wireless_info> m_info{};
     string m_essid{};
     quality_range m_signalstrength{};
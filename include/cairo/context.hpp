@@ -146,63 +146,73 @@ namespace cairo {
       position(&x, &y);
 
       // Prioritize the preferred font
-      vector<shared_ptr<font>> fns(m_fonts.begin(), m_fonts.end());
-
-      if (t.font > 0 && t.font <= std::distance(fns.begin(), fns.end())) {
-        std::iter_swap(fns.begin(), fns.begin() + t.font - 1);
+      size_t preferred{0};
+      if (t.font > 0 && static_cast<size_t>(t.font) <= m_fonts.size()) {
+        preferred = t.font - 1;
       }
+      const auto font_at = [&](size_t i) -> font& {
+        return *m_fonts[i == 0 ? preferred : i == preferred ? 0 : i];
+      };
 
-      string utf8 = string(t.contents);
-      utils::unicode_charlist chars;
+      // The buffers are members so that their capacity is reused for every block
+      string& utf8{m_utf8};
+      string& subset{m_subset};
+      utils::unicode_charlist& chars{m_chars};
+
+      utf8.assign(*t.contents);
+      chars.clear();
       utils::utf8_to_ucs4((const unsigned char*)utf8.c_str(), chars);
 
       while (!chars.empty()) {
         auto remaining = chars.size();
-        for (auto&& f : fns) {
+        for (size_t i = 0; i < m_fonts.size(); i++) {
+          font& f = font_at(i);
           unsigned int matches = 0;
 
           // Match as many glyphs as possible if the default/preferred font
           // is being tested. Otherwise test one glyph at a time against
           // the remaining fonts. Roll back to the top of the font list
           // when a glyph has been found.
-          if (f == fns.front() && (matches = f->match(chars)) == 0) {
+          if (i == 0 && (matches = f.match(chars)) == 0) {
             continue;
-          } else if (f != fns.front() && (matches = f->match(chars.front())) == 0) {
+          } else if (i != 0 && (matches = f.match(chars.front())) == 0) {
             continue;
           }
 
-          string subset;
+          subset.clear();
           auto end = chars.begin();
           while (matches-- && end != chars.end()) {
-            subset += utf8.substr(end->offset, end->length);
+            subset.append(utf8, end->offset, end->length);
             end++;
           }
 
-          // Use the font
-          f->use();
-
           // Get subset extents
           cairo_text_extents_t extents;
-          f->textwidth(subset, &extents);
-
-          // Draw the background
-          if (t.bg_rect.h != 0.0) {
-            save();
-            cairo_set_operator(m_c, t.bg_operator);
-            *this << t.bg;
-            cairo_rectangle(m_c, t.bg_rect.x + *t.x_advance, t.bg_rect.y + *t.y_advance,
-                t.bg_rect.w + extents.x_advance, t.bg_rect.h);
-            cairo_fill(m_c);
-            restore();
+          f.textwidth(subset, &extents);
+
+          if (!t.measure_only) {
+            // Use the font
+            f.use();
+
+            // Draw the background
+            if (t.bg_rect.h != 0.0) {
+              save();
+              cairo_set_operator(m_c, t.bg_operator);
+              *this << t.bg;
+              cairo_rectangle(m_c, t.bg_rect.x + *t.x_advance, t.bg_rect.y + *t.y_advance,
+                  t.bg_rect.w + extents.x_advance, t.bg_rect.h);
+              cairo_fill(m_c);
+              restore();
+            }
+
+            // Render subset
+            auto fontextents = f.extents();
+            f.render(subset, x, y - (fontextents.descent / 2 - fontextents.height / 4) + f.offset());
+
+            // Get updated position
+            position(&x, nullptr);
           }
 
-          // Render subset
-          auto fontextents = f->extents();
-          f->render(subset, x, y - (fontextents.descent / 2 - fontextents.height / 4) + f->offset());
-
-          // Get updated position
-          position(&x, nullptr);
-
           // Increase position
           *t.x_advance += extents.x_advance;
           *t.y_advance += extents.y_advance;
@@ -217,9 +227,11 @@ namespace cairo {
           continue;
         }
 
-        char unicode[6]{'\0'};
-        utils::ucs4_to_utf8(unicode, chars.begin()->codepoint);
-        m_log.warn("Dropping unmatched character %s (U+%04x) in '%s'", unicode, chars.begin()->codepoint, t.contents);
+        if (!t.measure_only) {
+          char unicode[6]{'\0'};
+          utils::ucs4_to_utf8(unicode, chars.begin()->codepoint);
+          m_log.warn("Dropping unmatched character %s (U+%04x) in '%s'", unicode, chars.begin()->codepoint, *t.contents);
+        }
         utf8.erase(chars.begin()->offset, chars.begin()->length);
         for (auto&& c : chars) {
           c.offset -= chars.begin()->length;
@@ -351,6 +363,9 @@ namespace cairo {
     cairo_t* m_c;
     const logger& m_log;
     vector<shared_ptr<font>> m_fonts;
+    string m_utf8;
+    string m_subset;
+    utils::unicode_charlist m_chars;
     std::deque<pair<double, double>> m_points;
     int m_activegroups{0};
   };
@@ -2,6 +2,8 @@
 
 #include <cairo/cairo-ft.h>
 
+#include <unordered_map>
+
 #include "cairo/types.hpp"
 #include "cairo/utils.hpp"
 #include "common.hpp"
@@ -11,6 +13,11 @@
 #include "utils/scope.hpp"
 #include "utils/string.hpp"
 
+#if WITH_HARFBUZZ
+#include <hb-ft.h>
+#include <hb.h>
+#endif
+
 POLYBAR_NS
 
 namespace cairo {
@@ -87,6 +94,11 @@ namespace cairo {
     }
 
     ~font_fc() override {
+#if WITH_HARFBUZZ
+      if (m_buffer != nullptr) {
+        hb_buffer_destroy(m_buffer);
+      }
+#endif
       if (m_scaled != nullptr) {
         cairo_scaled_font_destroy(m_scaled);
       }
@@ -188,14 +200,14 @@ namespace cairo {
     }
 
     size_t match(utils::unicode_character& character) override {
-      auto lock = make_unique<utils::ft_face_lock>(m_scaled);
-      auto face = static_cast<FT_Face>(*lock);
+      utils::ft_face_lock lock(m_scaled);
+      auto face = static_cast<FT_Face>(lock);
       return FT_Get_Char_Index(face, character.codepoint) ? 1 : 0;
     }
 
     size_t match(utils::unicode_charlist& charlist) override {
-      auto lock = make_unique<utils::ft_face_lock>(m_scaled);
-      auto face = static_cast<FT_Face>(*lock);
+      utils::ft_face_lock lock(m_scaled);
+      auto face = static_cast<FT_Face>(lock);
       size_t available_chars = 0;
       for (auto&& c : charlist) {
         if (FT_Get_Char_Index(face, c.codepoint)) {
@@ -209,65 +221,164 @@ namespace cairo {
     }
 
     size_t render(const string& text, double x = 0.0, double y = 0.0) override {
+      const shaped_run& run = shape(text);
+
+      if (run.bytes) {
+        m_glyphs.assign(run.glyphs.begin(), run.glyphs.end());
+        for (auto&& glyph : m_glyphs) {
+          glyph.x += x;
+          glyph.y += y;
+        }
+
+        cairo_show_glyphs(m_cairo, m_glyphs.data(), m_glyphs.size());
+        cairo_move_to(m_cairo, x + run.extents.x_advance, 0.0);
+      }
+
+      return run.bytes;
+    }
+
+    void textwidth(const string& text, cairo_text_extents_t* extents) override {
+      *extents = shape(text).extents;
+    }
+
+   protected:
+    /**
+     * \brief Glyphs of a piece of text, positioned relative to the origin
+     */
+    struct shaped_run {
+      vector<cairo_glyph_t> glyphs;
+      cairo_text_extents_t extents{};
+
+      /**
+       * Number of leading bytes of the text covered by the glyphs, the text
+       * is cut off at the first character the font has no glyph for
+       */
+      size_t bytes{0};
+    };
+
+    /**
+     * Get the shaped glyphs for the given text
+     *
+     * The same strings are drawn on almost every frame, so the results are
+     * cached and rendering only has to offset and blit the glyphs
+     */
+    const shaped_run& shape(const string& text) {
+      auto it = m_runs.find(text);
+      if (it != m_runs.end()) {
+        return it->second;
+      }
+
+      // Dynamic text (clocks, titles) keeps adding new runs
+      if (m_runs.size() >= MAX_CACHED_RUNS) {
+        m_runs.clear();
+      }
+
+      shaped_run run = shape_text(text);
+      if (run.bytes && run.bytes < text.size()) {
+        size_t bytes = run.bytes;
+        run = shape_text(text.substr(0, bytes));
+        run.bytes = bytes;
+      }
+
+      return m_runs.emplace(text, move(run)).first->second;
+    }
+
+#if WITH_HARFBUZZ
+    /**
+     * Shape the text using harfbuzz, which takes care of ligatures, combining
+     * marks and complex scripts
+     */
+    shaped_run shape_text(const string& text) {
+      if (m_buffer == nullptr) {
+        m_buffer = hb_buffer_create();
+      }
+
+      hb_buffer_reset(m_buffer);
+      hb_buffer_add_utf8(m_buffer, text.data(), text.size(), 0, text.size());
+      hb_buffer_guess_segment_properties(m_buffer);
+
+      {
+        // The face is sized to the scaled font while it is locked
+        utils::ft_face_lock lock(m_scaled);
+        hb_font_t* font = hb_ft_font_create_referenced(static_cast<FT_Face>(lock));
+        hb_shape(font, m_buffer, nullptr, 0);
+        hb_font_destroy(font);
+      }
+
+      unsigned int count;
+      const hb_glyph_info_t* infos = hb_buffer_get_glyph_infos(m_buffer, &count);
+      const hb_glyph_position_t* positions = hb_buffer_get_glyph_positions(m_buffer, &count);
+
+      shaped_run run;
+      run.bytes = text.size();
+      run.glyphs.reserve(count);
+
+      // Positions are in 26.6 fixed point
+      double pen_x{0.0};
+      double pen_y{0.0};
+      for (unsigned int i = 0; i < count; i++) {
+        if (infos[i].codepoint == 0) {
+          run.bytes = std::min<size_t>(run.bytes, infos[i].cluster);
+        }
+
+        cairo_glyph_t glyph;
+        glyph.index = infos[i].codepoint;
+        glyph.x = pen_x + positions[i].x_offset / 64.0;
+        glyph.y = pen_y - positions[i].y_offset / 64.0;
+        run.glyphs.emplace_back(glyph);
+
+        pen_x += positions[i].x_advance / 64.0;
+        pen_y -= positions[i].y_advance / 64.0;
+      }
+
+      cairo_scaled_font_glyph_extents(m_scaled, run.glyphs.data(), run.glyphs.size(), &run.extents);
+      run.extents.x_advance = pen_x;
+      run.extents.y_advance = pen_y;
+
+      return run;
+    }
+#else
+    /**
+     * Convert the text to glyphs using cairo's simple (unshaped) mapping
+     */
+    shaped_run shape_text(const string& text) {
       cairo_glyph_t* glyphs{nullptr};
       cairo_text_cluster_t* clusters{nullptr};
       cairo_text_cluster_flags_t cf{};
       int nglyphs = 0, nclusters = 0;
 
-      string utf8 = string(text);
       auto status = cairo_scaled_font_text_to_glyphs(
-          m_scaled, x, y, utf8.c_str(), utf8.size(), &glyphs, &nglyphs, &clusters, &nclusters, &cf);
+          m_scaled, 0.0, 0.0, text.c_str(), text.size(), &glyphs, &nglyphs, &clusters, &nclusters, &cf);
 
       if (status != CAIRO_STATUS_SUCCESS) {
         throw application_error(sstream() << "cairo_scaled_font_text_to_glyphs()" << cairo_status_to_string(status));
       }
 
-      size_t bytes = 0;
-      for (int g = 0; g < nglyphs; g++) {
-        if (glyphs[g].index) {
-          bytes += clusters[g].num_bytes;
-        } else {
-          break;
-        }
-      }
-
-      if (bytes && bytes < text.size()) {
-        cairo_glyph_free(glyphs);
-        cairo_text_cluster_free(clusters);
-
-        utf8 = text.substr(0, bytes);
-        auto status = cairo_scaled_font_text_to_glyphs(
-            m_scaled, x, y, utf8.c_str(), utf8.size(), &glyphs, &nglyphs, &clusters, &nclusters, &cf);
+      shaped_run run;
+      run.glyphs.assign(glyphs, glyphs + nglyphs);
 
-        if (status != CAIRO_STATUS_SUCCESS) {
-          throw application_error(sstream() << "cairo_scaled_font_text_to_glyphs()" << cairo_status_to_string(status));
+      int glyph = 0;
+      for (int c = 0; c < nclusters; c++) {
+        bool found = true;
+        for (int g = glyph; g < glyph + clusters[c].num_glyphs; g++) {
+          found = found && glyphs[g].index != 0;
         }
+        if (!found) {
+          break;
+        }
+        run.bytes += clusters[c].num_bytes;
+        glyph += clusters[c].num_glyphs;
       }
 
-      if (bytes) {
-        // auto lock = make_unique<utils::device_lock>(cairo_surface_get_device(cairo_get_target(m_cairo)));
-        // if (lock.get()) {
-        //   cairo_glyph_path(m_cairo, glyphs, nglyphs);
-        // }
-
-        cairo_text_extents_t extents{};
-        cairo_scaled_font_glyph_extents(m_scaled, glyphs, nglyphs, &extents);
-        cairo_show_text_glyphs(m_cairo, utf8.c_str(), utf8.size(), glyphs, nglyphs, clusters, nclusters, cf);
-        cairo_fill(m_cairo);
-        cairo_move_to(m_cairo, x + extents.x_advance, 0.0);
-      }
+      cairo_scaled_font_glyph_extents(m_scaled, glyphs, nglyphs, &run.extents);
 
       cairo_glyph_free(glyphs);
       cairo_text_cluster_free(clusters);
 
-      return bytes;
-    }
-
-    void textwidth(const string& text, cairo_text_extents_t* extents) override {
-      cairo_scaled_font_text_extents(m_scaled, text.c_str(), extents);
+      return run;
     }
+#endif
 
-   protected:
     string property(string&& property) const {
       FcChar8* file;
       if (FcPatternGetString(m_pattern, property.c_str(), 0, &file) == FcResultMatch) {
@@ -292,10 +403,32 @@ namespace cairo {
     }
 
    private:
+    static constexpr size_t MAX_CACHED_RUNS{512};
+
     cairo_scaled_font_t* m_scaled{nullptr};
     FcPattern* m_pattern{nullptr};
+
+    std::unordered_map<string, shaped_run> m_runs;
+
+    // Scratch buffer for the positioned glyphs of the run being rendered
+    vector<cairo_glyph_t> m_glyphs;
+
+#if WITH_HARFBUZZ
+    hb_buffer_t* m_buffer{nullptr};
+#endif
   };
 
+  /**
+   * Fontconfig matches of previous runs
+   *
+   * Matching against all installed fonts is slow. Call save() on it once
+   * all fonts are loaded.
+   */
+  inline utils::font_cache& font_match_cache() {
+    static utils::font_cache cache{utils::font_cache::default_path()};
+    return cache;
+  }
+
   /**
    * Match and create font from given fontconfig pattern
    */
@@ -312,22 +445,29 @@ namespace cairo {
       FcFini();
     });
 
-    auto pattern = FcNameParse((FcChar8*)fontname.c_str());
+    auto& cache = font_match_cache();
+    FcPattern* match = cache.get(fontname, dpi_x, dpi_y);
 
-    if(!pattern) {
-      logger::make().err("Could not parse font \"%s\"", fontname);
-      throw application_error("Could not parse font \"" + fontname + "\"");
-    }
+    if (match == nullptr) {
+      auto pattern = FcNameParse((FcChar8*)fontname.c_str());
 
-    FcDefaultSubstitute(pattern);
-    FcConfigSubstitute(nullptr, pattern, FcMatchPattern);
+      if(!pattern) {
+        logger::make().err("Could not parse font \"%s\"", fontname);
+        throw application_error("Could not parse font \"" + fontname + "\"");
+      }
 
-    FcResult result;
-    FcPattern* match = FcFontMatch(nullptr, pattern, &result);
-    FcPatternDestroy(pattern);
+      FcDefaultSubstitute(pattern);
+      FcConfigSubstitute(nullptr, pattern, FcMatchPattern);
 
-    if (match == nullptr) {
-      throw application_error("Could not load font \"" + fontname + "\"");
+      FcResult result;
+      match = FcFontMatch(nullptr, pattern, &result);
+      FcPatternDestroy(pattern);
+
+      if (match == nullptr) {
+        throw application_error("Could not load font \"" + fontname + "\"");
+      }
+
+      cache.put(fontname, dpi_x, dpi_y, match);
     }
 
 #ifdef DEBUG_FONTCONFIG
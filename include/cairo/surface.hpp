@@ -71,6 +71,18 @@ namespace cairo {
       cairo_xcb_surface_set_drawable(m_s, d, w, h);
     }
   };
+
+  /**
+   * \brief Surface backed by client side memory
+   */
+  class image_surface : public surface {
+   public:
+    explicit image_surface(cairo_format_t format, int w, int h) : surface(cairo_image_surface_create(format, w, h)) {}
+    explicit image_surface(unsigned char* data, cairo_format_t format, int w, int h, int stride)
+        : surface(cairo_image_surface_create_for_data(data, format, w, h, stride)) {}
+
+    ~image_surface() override {}
+  };
 }
 
 POLYBAR_NS_END
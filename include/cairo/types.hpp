@@ -56,13 +56,15 @@ namespace cairo {
   };
   struct textblock {
     alignment align;
-    string contents;
+    const string* contents;
     int font;
     unsigned int bg;
     cairo_operator_t bg_operator;
     rect bg_rect;
     double *x_advance;
     double *y_advance;
+    // Only advance, without drawing anything
+    bool measure_only;
   };
 }
 
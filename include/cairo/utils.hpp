@@ -1,7 +1,8 @@
 #pragma once
 
 #include <cairo/cairo-ft.h>
-#include <list>
+#include <vector>
+#include <map>
 
 #include "common.hpp"
 
@@ -38,6 +39,38 @@ namespace cairo {
       FT_Face m_face;
     };
 
+    /**
+     * \brief Fontconfig match results persisted across restarts
+     *
+     * Entries are stored together with a stamp of the fontconfig configuration
+     * and the font directories, they are dropped as soon as any of those
+     * changes. New entries are only written by save(), or on destruction.
+     */
+    class font_cache {
+     public:
+      explicit font_cache(string path);
+      ~font_cache();
+
+      FcPattern* get(const string& pattern, double dpi_x, double dpi_y);
+      void put(const string& pattern, double dpi_x, double dpi_y, FcPattern* match);
+      void save();
+
+      static string default_path();
+
+     protected:
+      static string make_key(const string& pattern, double dpi_x, double dpi_y);
+      static string make_stamp();
+
+      void load();
+
+     private:
+      string m_path;
+      string m_stamp;
+      bool m_loaded{false};
+      bool m_dirty{false};
+      std::map<string, string> m_entries;
+    };
+
     /**
      * \brief Unicode character containing converted codepoint
      * and details on where its position in the source string
@@ -48,7 +81,7 @@ namespace cairo {
       int offset;
       int length;
     };
-    using unicode_charlist = std::list<unicode_character>;
+    using unicode_charlist = std::vector<unicode_character>;
 
     /**
      * \see <cairo/cairo.h>
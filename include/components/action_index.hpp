@@ -0,0 +1,49 @@
+#pragma once
+
+#include "common.hpp"
+#include "components/types.hpp"
+
+POLYBAR_NS
+
+/**
+ * Immutable lookup structure for the action blocks of a rendered frame
+ *
+ * The bar is cut at every start and end position of the completed actions,
+ * each resulting region knows which actions cover it. Finding the actions
+ * under the pointer is then a binary search over the regions.
+ *
+ * The renderer publishes a new index after every frame, readers keep the
+ * shared pointer they got for as long as they need it. An index that is no
+ * longer published nor held by any reader may be rebuilt with assign(),
+ * which reuses its storage.
+ */
+class action_index {
+ public:
+  struct region {
+    int start;
+    int end;
+    // Covering actions, in the order they were opened
+    vector<size_t> actions;
+    bool click{false};
+    bool scroll{false};
+  };
+
+  action_index() = default;
+  explicit action_index(const vector<action_block>& actions);
+
+  void assign(const action_block* actions, size_t count);
+
+  const region* find(int x) const;
+  const action_block* find(mousebtn button, int x) const;
+
+  bool has_double_click() const;
+
+ private:
+  vector<action_block> m_actions;
+  vector<region> m_regions;
+  // Scratch buffer for the region boundaries
+  vector<int> m_bounds;
+  bool m_doubleclick{false};
+};
+
+POLYBAR_NS_END
@@ -6,11 +6,13 @@
 #include <thread>
 
 #include "common.hpp"
+#include "components/action_index.hpp"
 #include "components/types.hpp"
 #include "errors.hpp"
 #include "events/signal_fwd.hpp"
 #include "events/signal_receiver.hpp"
 #include "utils/math.hpp"
+#include "utils/trace.hpp"
 #include "settings.hpp"
 #include "x11/types.hpp"
 #include "x11/window.hpp"
@@ -66,6 +68,7 @@ class bar : public xpp::event::sink<evt::button_press, evt::expose, evt::propert
   ~bar();
 
   const bar_settings settings() const;
+  taskqueue& tasks() const;
 
   void parse(string&& data, bool force = false);
 
@@ -82,6 +85,8 @@ class bar : public xpp::event::sink<evt::button_press, evt::expose, evt::propert
   void reconfigure_wm_hints();
   void broadcast_visibility();
   void subthread();
+  void draw_pending();
+  bool draw(string&& data, bool force);
   void redraw();
 
   void handle(const evt::client_message& evt);
@@ -118,6 +123,21 @@ class bar : public xpp::event::sink<evt::button_press, evt::expose, evt::propert
 
   string m_lastinput{};
   std::mutex m_mutex{};
+
+  /**
+   * Newest content that has not been drawn yet, replaced by every update
+   */
+  struct frame {
+    string data{};
+    bool force{false};
+    // Arrival of the oldest update merged into this frame
+    trace_util::clock::time_point queued{};
+  };
+  std::mutex m_mailbox_lock{};
+  frame m_mailbox{};
+  std::atomic<bool> m_redraw_pending{false};
+  trace_util::stage& m_latency_trace{trace_util::get_stage("bar:update-to-pixels")};
+
   std::thread m_subthread{};
   std::atomic<bool> m_dblclicks{false};
 
@@ -125,6 +145,9 @@ class bar : public xpp::event::sink<evt::button_press, evt::expose, evt::propert
   int m_buttonpress_pos{0};
 #if WITH_XCURSOR
   int m_motion_pos{0};
+  // region the cursor was last resolved for, only valid for m_motion_index
+  shared_ptr<const action_index> m_motion_index{};
+  const action_index::region* m_motion_region{nullptr};
 #endif
 
   event_timer m_buttonpress{0L, 5L};
@@ -0,0 +1,46 @@
+#pragma once
+
+#include "common.hpp"
+#include "components/types.hpp"
+
+POLYBAR_NS
+
+/**
+ * Horizontal placement of the alignment blocks of a frame
+ *
+ * Resolved once from the measured block widths, so that the draw pass can
+ * put every run at its final position and knows up front which part of a
+ * block still fits on the canvas.
+ *
+ * Positions are relative to the left side of the bar contents (without
+ * borders and tray) and rounded to whole pixels.
+ */
+class block_layout {
+ public:
+  static constexpr double GAP{20.0};
+
+  struct placement {
+    double x{0.0};
+    double width{0.0};
+    // Width of the part that isn't cut off by the end of the canvas
+    double visible{0.0};
+
+    bool overflows() const {
+      return visible < width;
+    }
+  };
+
+  block_layout() = default;
+  explicit block_layout(double canvas_width, double left, double center, double right, bool fixed_center = false,
+      double bar_center = 0.0);
+
+  const placement& get(alignment a) const;
+
+ private:
+  placement m_left{};
+  placement m_center{};
+  placement m_right{};
+  placement m_none{};
+};
+
+POLYBAR_NS_END
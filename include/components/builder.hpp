@@ -18,9 +18,10 @@ class builder {
 
   void reset();
   string flush();
-  void append(string text);
-  void node(string str);
-  void node(string str, int font_index);
+  void flush(string& output);
+  void append(const string& text);
+  void node(const string& str);
+  void node(const string& str, int font_index);
   void node(const label_t& label);
   void node_repeat(const string& str, size_t n);
   void node_repeat(const label_t& label, size_t n);
@@ -47,11 +48,13 @@ class builder {
   void underline(const string& color = "");
   void underline_close();
   void control(controltag tag);
-  void cmd(mousebtn index, string action);
-  void cmd(mousebtn index, string action, const label_t& label);
+  void cmd(mousebtn index, const string& action);
+  void cmd(mousebtn index, const string& action, const label_t& label);
   void cmd_close();
 
  protected:
+  void close_tags();
+
   string background_hex();
   string foreground_hex();
 
@@ -1,7 +1,8 @@
 #pragma once
 
-#include <unordered_map>
 #include <algorithm>
+#include <climits>
+#include <unordered_map>
 
 #include "common.hpp"
 #include "components/logger.hpp"
@@ -45,6 +46,8 @@ class config {
 
   void set_included(file_list included);
 
+  void compile();
+
   void warn_deprecated(const string& section, const string& key, string replacement) const;
 
   gradient_t get_gradient(const string& name) const;
@@ -57,23 +60,7 @@ class config {
     return it != m_sections.end() && it->second.find(key) != it->second.end();
   }
 
-  /**
-   * Set parameter value
-   */
-  void set(const string& section, const string& key, string&& value) {
-    auto it = m_sections.find(section);
-    if (it == m_sections.end()) {
-      valuemap_t values;
-      values[key] = value;
-      m_sections[section] = move(values);
-    }
-    auto it2 = it->second.find(key);
-    if ((it2 = it->second.find(key)) == it->second.end()) {
-      it2 = it->second.emplace_hint(it2, key, value);
-    } else {
-      it2->second = value;
-    }
-  }
+  void set(const string& section, const string& key, string&& value);
 
   /**
    * Get parameter for the current bar by name
@@ -88,6 +75,11 @@ class config {
    */
   template <typename T = string>
   T get(const string& section, const string& key) const {
+    const resolved_value* resolved{find_resolved(section, key)};
+    if (resolved != nullptr) {
+      return convert<T>(*resolved);
+    }
+
     auto it = m_sections.find(section);
     if (it == m_sections.end() || it->second.find(key) == it->second.end()) {
       throw key_error("Missing parameter \"" + section + "." + key + "\"");
@@ -114,6 +106,11 @@ class config {
    */
   template <typename T = string>
   T get(const string& section, const string& key, const T& default_value) const {
+    const resolved_value* resolved{find_resolved(section, key)};
+    if (resolved != nullptr) {
+      return convert<T>(*resolved);
+    }
+
     try {
       string string_value{get<string>(section, key)};
       T result{convert<T>(string{string_value})};
@@ -142,14 +139,7 @@ class config {
 
     while (true) {
       try {
-        string string_value{get<string>(section, key + "-" + to_string(results.size()))};
-        T value{convert<T>(string{string_value})};
-
-        if (!string_value.empty()) {
-          results.emplace_back(dereference<T>(section, key, move(string_value), move(value)));
-        } else {
-          results.emplace_back(move(value));
-        }
+        results.emplace_back(get<T>(section, key + "-" + to_string(results.size())));
       } catch (const key_error& err) {
         break;
       }
@@ -172,14 +162,7 @@ class config {
 
     while (true) {
       try {
-        string string_value{get<string>(section, key + "-" + to_string(results.size()))};
-        T value{convert<T>(string{string_value})};
-
-        if (!string_value.empty()) {
-          results.emplace_back(dereference<T>(section, key, move(string_value), move(value)));
-        } else {
-          results.emplace_back(move(value));
-        }
+        results.emplace_back(get<T>(section, key + "-" + to_string(results.size())));
       } catch (const key_error& err) {
         break;
       }
@@ -224,11 +207,53 @@ class config {
   }
 
  protected:
+  /**
+   * A parameter value with all references resolved
+   *
+   * The numeric forms are parsed once as well, so reading a number
+   * doesn't convert the text again.
+   */
+  struct resolved_value {
+    explicit resolved_value(string&& value);
+
+    string text;
+    long long integer;
+    unsigned long long uinteger;
+    double real;
+    bool flag;
+  };
+
   void copy_inherited();
 
+  void resolve(const string& section, const string& key);
+  string local_reference(const string& section, const string& value) const;
+
+  /**
+   * Get the value of a parameter with all references already resolved
+   *
+   * Returns nullptr if the parameter does not exist or could not be resolved
+   * when compiling, in which case the caller has to take the slow path.
+   */
+  const resolved_value* find_resolved(const string& section, const string& key) const {
+    auto it = m_resolved.find(section);
+    if (it == m_resolved.end()) {
+      return nullptr;
+    }
+    auto it2 = it->second.find(key);
+    return it2 == it->second.end() ? nullptr : &it2->second;
+  }
+
   template <typename T>
   T convert(string&& value) const;
 
+  /**
+   * Convert a resolved value, types without a parsed form are converted from its text
+   */
+  template <typename T>
+  T convert(const resolved_value& value) const {
+    return convert<T>(string{value.text});
+  }
+
   /**
    * Dereference value reference
    */
@@ -275,8 +300,12 @@ class config {
     }
   }
 
+  string derive_color(const string& color, const string& modifiers, const string& key_path) const;
+
   template <typename T>
   T dereference_color(string value, string current_section, vector<string>& ref_trace) const {
+    // dereference_local consumes the trace
+    string key_path{ref_trace.back()};
     auto pos = value.find(".");
     auto pos2 = value.find(":");
     string color;
@@ -289,60 +318,7 @@ class config {
       color = dereference_local<string>(move(section), move(key), move(current_section), ref_trace);
     }
     if (pos2 != string::npos) {
-      auto base_color = rgba::get_rgba(color);
-      double3 jab(base_color);
-      colorspaces::rgb_xyz(jab, jab);
-      colorspaces::xyz_jzazbz(jab, jab);
-      colorspaces::ab_ch(jab, jab);
-      bool ended;
-      do {
-        pos = pos2 + 1;
-        pos2 = value.find(":", pos);
-        if (pos2 == string::npos) {
-          pos2 = value.size();
-          ended = true;
-        } else ended = false;
-
-        // find the operator of the command
-        size_t op_pos = pos;
-        string operators = "+-*/=";
-        for (; op_pos < pos2; op_pos++) {
-          if (operators.find(value[op_pos]) != string::npos) break;
-        }
-
-        if (op_pos == pos2) {
-          throw value_error("Invalid color reference defined at \"" + ref_trace.back() + "\"");
-        }
-
-        auto property = string_util::trim(string_util::lower(value.substr(pos, op_pos - pos)));
-        auto amount = std::stod(&value[op_pos + 1]);
-        double* modified;
-        if (property == "lum" || property == "lightness" || property == "luminosity") {
-          modified = &jab.a;
-        } else if (property == "chroma" || property == "sat" || property == "saturation") {
-          modified = &jab.b;
-        } else if (property == "hue") {
-          modified = &jab.c;
-        } else if (property == "alpha" || property == "opacity") {
-          modified = &base_color.a;
-        } else {
-          throw value_error("Invalid color property \"" + property + "\" defined at \"" + ref_trace.back() + "\"");
-        }
-
-        switch (value[op_pos]) {
-          case '+': *modified += amount; break;
-          case '-': *modified -= amount; break;
-          case '*': *modified *= amount; break;
-          case '/': *modified /= amount; break;
-          case '=': *modified = amount; break;
-          default: throw value_error("Unexpected error, this is a bug, please report!");
-        }
-      } while (!ended);
-      colorspaces::ch_ab(jab, jab);
-      colorspaces::jzazbz_xyz(jab, jab);
-      colorspaces::xyz_rgb(jab, jab);
-      jab.copy_to(base_color);
-      color = color_util::hex<unsigned short int>(base_color);
+      color = derive_color(color, value.substr(pos2 + 1), key_path);
     }
     return convert<T>(move(color));
   }
@@ -485,7 +461,23 @@ class config {
   string m_file;
   string m_barname;
   sectionmap_t m_sections{};
-  mutable map<string,gradient_t> m_gradients;
+  mutable std::unordered_map<string, gradient_t> m_gradients;
+
+  /**
+   * Results of derive_color, indexed by the base color and the modifiers
+   */
+  mutable std::unordered_map<string, string> m_derived_colors;
+
+  /**
+   * Values of all parameters with their references resolved, see compile()
+   */
+  std::unordered_map<string, std::unordered_map<string, resolved_value>> m_resolved{};
+
+  /**
+   * Parameters that reference a parameter ("section.key"), they are
+   * resolved again when it is set
+   */
+  std::unordered_map<string, vector<std::pair<string, string>>> m_dependents{};
 
   /**
    * Absolute path of all files that were parsed in the process of parsing the
@@ -497,4 +489,79 @@ class config {
 #endif
 };
 
+template <>
+inline string config::convert(const resolved_value& value) const {
+  return value.text;
+}
+
+template <>
+inline bool config::convert(const resolved_value& value) const {
+  return value.flag;
+}
+
+template <>
+inline double config::convert(const resolved_value& value) const {
+  return value.real;
+}
+
+template <>
+inline short config::convert(const resolved_value& value) const {
+  return static_cast<short>(value.integer);
+}
+
+template <>
+inline int config::convert(const resolved_value& value) const {
+  return static_cast<int>(value.integer);
+}
+
+template <>
+inline long config::convert(const resolved_value& value) const {
+  return static_cast<long>(value.integer);
+}
+
+template <>
+inline long long config::convert(const resolved_value& value) const {
+  return value.integer;
+}
+
+template <>
+inline unsigned char config::convert(const resolved_value& value) const {
+  return static_cast<unsigned char>(value.uinteger);
+}
+
+template <>
+inline unsigned short config::convert(const resolved_value& value) const {
+  return static_cast<unsigned short>(value.uinteger);
+}
+
+template <>
+inline unsigned int config::convert(const resolved_value& value) const {
+  return static_cast<unsigned int>(value.uinteger);
+}
+
+template <>
+inline unsigned long config::convert(const resolved_value& value) const {
+  return value.uinteger < ULONG_MAX ? static_cast<unsigned long>(value.uinteger) : 0UL;
+}
+
+template <>
+inline unsigned long long config::convert(const resolved_value& value) const {
+  return value.uinteger < ULLONG_MAX ? value.uinteger : 0ULL;
+}
+
+template <>
+inline chrono::seconds config::convert(const resolved_value& value) const {
+  return chrono::seconds{convert<chrono::seconds::rep>(value)};
+}
+
+template <>
+inline chrono::milliseconds config::convert(const resolved_value& value) const {
+  return chrono::milliseconds{convert<chrono::milliseconds::rep>(value)};
+}
+
+template <>
+inline chrono::duration<double> config::convert(const resolved_value& value) const {
+  return chrono::duration<double>{value.real};
+}
+
 POLYBAR_NS_END
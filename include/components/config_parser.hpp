@@ -1,9 +1,12 @@
 #pragma once
 
+#include <future>
+#include <map>
 #include <set>
 
 #include "common.hpp"
 #include "components/config.hpp"
+#include "components/executor.hpp"
 #include "components/logger.hpp"
 #include "errors.hpp"
 #include "utils/file.hpp"
@@ -90,6 +93,7 @@ struct line_t {
 class config_parser {
  public:
   config_parser(const logger& logger, string&& file, string&& bar);
+  ~config_parser();
 
   /**
    * \brief Performs the parsing of the main config file m_file
@@ -112,12 +116,46 @@ class config_parser {
    *        headers and adds them onto the `lines` vector
    *
    * This method directly resolves `include-file` directives and checks for
-   * cyclic dependencies
+   * cyclic dependencies. All files included by `file` are parsed in parallel
+   * before any of them is processed, the lines are still added in the order
+   * they are included
    *
    * `file` is expected to be an already resolved absolute path
    */
   void parse_file(const string& file, file_list path);
 
+  /**
+   * \brief Reads the given file and parses all of its lines
+   *
+   * Only depends on the file contents and doesn't touch any mutable state,
+   * so included files can be parsed on worker threads. Include directives
+   * are returned as regular key-value lines and `file_index` is not set
+   *
+   * \throws syntax_error with the file path and line number set
+   * \throws application_error if the file can't be read
+   */
+  vector<line_t> parse_lines(const string& file) const;
+
+  /**
+   * \brief Returns the (possibly still running) parse result of the given file
+   *
+   * Every file is only read and parsed once, even if it is included
+   * multiple times. With `background`, the file is parsed on the CPU pool
+   * of the executor, otherwise only once the result is needed
+   */
+  const std::shared_future<vector<line_t>>& get_parsed(const string& file, bool background);
+
+  /**
+   * \brief Whether the line is an `include-file` or `include-directory` directive
+   */
+  static bool is_include(const line_t& line);
+
+  /**
+   * \brief Returns the absolute paths of all files included by the given
+   *        include directive, in the order they have to be parsed
+   */
+  static vector<string> get_includes(const line_t& line);
+
   /**
    * \brief Parses the given line string to create a line_t struct
    *
@@ -152,7 +190,7 @@ class config_parser {
    *         doesn't know about those. Whoever calls parse_line needs to
    *         catch those exceptions and set the file path and line number
    */
-  line_t parse_line(const string& line);
+  line_t parse_line(const string& line) const;
 
   /**
    * \brief Determines the type of a line read from a config file
@@ -175,7 +213,7 @@ class config_parser {
    * \throws syntax_error if the line doesn't end with ']' or the header name
    *         contains forbidden characters
    */
-  string parse_header(const string& line);
+  string parse_header(const string& line) const;
 
   /**
    * \brief Parses a line containing a key-value pair and returns the key name
@@ -185,7 +223,7 @@ class config_parser {
    *
    * \throws syntax_error if the key contains forbidden characters
    */
-  std::pair<string, string> parse_key(const string& line);
+  std::pair<string, string> parse_key(const string& line) const;
 
   /**
    * \brief Name of all the files the config includes values from
@@ -201,7 +239,7 @@ class config_parser {
    * \brief Checks if the given name doesn't contain any spaces or characters
    *        in config_parser::m_forbidden_chars
    */
-  bool is_valid_name(const string& name);
+  bool is_valid_name(const string& name) const;
 
   /**
    * \brief Whether or not an xresource manager should be used
@@ -230,6 +268,18 @@ class config_parser {
    */
   vector<line_t> m_lines;
 
+  /**
+   * \brief Parse results of all files read so far, indexed by their path
+   */
+  std::map<string, std::shared_future<vector<line_t>>> m_parsed;
+
+  /**
+   * \brief Executor group of the included files parsed in the background
+   *
+   * Only set once the first file was handed to the executor
+   */
+  unique_ptr<executor::group> m_includes;
+
   /**
    * \brief None of these characters can be used in the key and section names
    */
@@ -1,7 +1,8 @@
 #pragma once
 
-#include <moodycamel/blockingconcurrentqueue.h>
-
+#include <chrono>
+#include <deque>
+#include <mutex>
 #include <thread>
 
 #include "common.hpp"
@@ -10,6 +11,7 @@
 #include "events/signal_receiver.hpp"
 #include "events/types.hpp"
 #include "settings.hpp"
+#include "utils/concurrency.hpp"
 #include "utils/file.hpp"
 #include "x11/types.hpp"
 
@@ -19,8 +21,6 @@ POLYBAR_NS
 
 enum class alignment;
 class bar;
-template <output_policy>
-class command;
 class config;
 class connection;
 class inotify_watch;
@@ -57,7 +57,10 @@ class controller
  protected:
   void read_events();
   void process_eventqueue();
+  void process_event(const event& evt, bool& force);
   void process_inputdata();
+  bool process_input(const string& cmd, string& result);
+  void reap_commands();
   bool process_update(bool force);
 
   bool on(const signals::eventqueue::notify_change& evt);
@@ -82,9 +85,18 @@ class controller
   unique_ptr<bar> m_bar;
   unique_ptr<ipc> m_ipc;
   unique_ptr<inotify_watch> m_confwatch;
-  unique_ptr<command<output_policy::IGNORED>> m_command;
 
-  array<unique_ptr<file_descriptor>, 2> m_queuefd{};
+  /**
+   * \brief Running shell commands started on behalf of input events
+   *
+   * They are not waited for, the event loop reaps them once they exit
+   */
+  vector<pid_t> m_commands;
+
+  /**
+   * \brief Wakes the event loop, written to for every queued event and by the signal handler
+   */
+  unique_ptr<file_descriptor> m_eventfd;
 
   /**
    * \brief State flag
@@ -102,9 +114,22 @@ class controller
   bool m_writeback{false};
 
   /**
-   * \brief Internal event queue
+   * \brief Internal event queue, filled by modules and drained by the event loop
+   */
+  mpsc_ring<event, 256> m_queue;
+
+  /**
+   * \brief Events that didn't fit into the queue, they are never dropped
+   */
+  std::deque<event> m_overflow;
+  std::mutex m_overflowlock;
+  std::atomic<bool> m_overflowed{false};
+
+  /**
+   * \brief Update events are coalesced instead of queued
    */
-  moodycamel::BlockingConcurrentQueue<event> m_queue;
+  std::atomic<bool> m_update_queued{false};
+  std::atomic<bool> m_force_queued{false};
 
   /**
    * \brief Loaded modules
@@ -132,14 +157,16 @@ class controller
   std::chrono::milliseconds m_swallow_update{10};
 
   /**
-   * \brief Input data
+   * \brief State of the update that is held back while swallowing events
    */
-  string m_inputdata;
+  bool m_update_pending{false};
+  size_t m_swallowed{0U};
+  std::chrono::steady_clock::time_point m_update_deadline{};
 
   /**
-   * \brief Thread for the eventqueue loop
+   * \brief Input data
    */
-  std::thread m_event_thread;
+  string m_inputdata;
 
   /**
    * \brief Misc threads
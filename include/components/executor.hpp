@@ -0,0 +1,137 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+#include "common.hpp"
+#include "utils/mixins.hpp"
+
+POLYBAR_NS
+
+namespace chrono = std::chrono;
+using namespace std::chrono_literals;
+
+// fwd
+class logger;
+
+/**
+ * Shared thread pools running module updates
+ *
+ * Tasks run on a work-stealing pool sized to the number of cores, up to a
+ * small limit. Blocking
+ * tasks (network requests, external commands) run on a separate small pool
+ * so that they can't hold up the others.
+ *
+ * Every task belongs to a group, usually one per module. A group that
+ * repeatedly exceeds its time budget is moved to the blocking pool.
+ */
+class executor : non_copyable_mixin<executor> {
+ public:
+  using clock = chrono::steady_clock;
+  using task = function<void()>;
+
+  enum class pool { CPU = 0, IO };
+
+  class group : non_copyable_mixin<group> {
+   public:
+    explicit group(string name, pool kind, clock::duration budget = 50ms);
+
+    const string& name() const;
+    bool slow() const;
+
+   private:
+    friend class executor;
+
+    const string m_name;
+    const clock::duration m_budget;
+    std::atomic<pool> m_pool;
+    std::atomic<bool> m_cancelled{false};
+    std::atomic<bool> m_slow{false};
+    std::atomic<size_t> m_overruns{0};
+
+    // Tasks that were posted but have not finished yet, guarded by executor::m_timerlock
+    size_t m_pending{0};
+  };
+
+ public:
+  using make_type = executor&;
+  static make_type make();
+
+  explicit executor(const logger& logger, size_t threads, size_t io_threads);
+  ~executor();
+
+  void post(group& g, task fn);
+  void post_at(group& g, clock::time_point when, task fn);
+  void cancel(group& g);
+
+ protected:
+  struct job {
+    group* owner;
+    task fn;
+  };
+
+  struct timed_job {
+    clock::time_point when;
+    job j;
+  };
+
+  /**
+   * Set of workers, each with its own queue
+   *
+   * Workers take their newest job first and steal the oldest job
+   * of another worker when their own queue is empty
+   */
+  class worker_pool {
+   public:
+    explicit worker_pool(executor& parent, string name, size_t threads);
+    ~worker_pool();
+
+    void push(job&& j);
+
+   private:
+    struct queue {
+      std::mutex lock;
+      std::deque<job> jobs;
+    };
+
+    bool take(size_t index, job& j);
+    void work(size_t index);
+
+    executor& m_parent;
+    const string m_name;
+    vector<unique_ptr<queue>> m_queues;
+    vector<std::thread> m_threads;
+
+    std::mutex m_lock;
+    std::condition_variable m_wake;
+    size_t m_queued{0};
+    size_t m_next{0};
+    bool m_stopping{false};
+  };
+
+  static bool later(const timed_job& a, const timed_job& b);
+
+  void dispatch(job&& j);
+  void run(job& j);
+  void finish(group& g);
+  void timer();
+
+ private:
+  const logger& m_log;
+
+  // Jobs waiting for their deadline, kept as a min-heap
+  vector<timed_job> m_timers;
+  std::mutex m_timerlock;
+  std::condition_variable m_timerwake;
+  std::condition_variable m_finished;
+  bool m_stopping{false};
+  std::thread m_timerthread;
+
+  unique_ptr<worker_pool> m_pools[2];
+};
+
+POLYBAR_NS_END
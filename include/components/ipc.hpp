@@ -1,5 +1,7 @@
 #pragma once
 
+#include <map>
+
 #include "common.hpp"
 #include "settings.hpp"
 #include "utils/concurrency.hpp"
@@ -17,12 +19,28 @@ static constexpr const char* ipc_command_prefix{"cmd:"};
 static constexpr const char* ipc_hook_prefix{"hook:"};
 static constexpr const char* ipc_action_prefix{"action:"};
 
+/**
+ * Message passed on to the ipc signal handlers
+ *
+ * Handlers run on the event loop and describe the outcome in result, it is
+ * sent back to the client once the handler returned.
+ */
+struct ipc_request {
+  string payload;
+  mutable string result{};
+};
+
 /**
  * Component used for inter-process communication.
  *
  * A unique messaging channel will be setup for each
  * running process which will allow messages and
  * events to be sent to the process externally.
+ *
+ * Messages are accepted on a unix socket, which answers every message with
+ * the outcome of its handler (see ipc_msg.hpp), and on the legacy fifo, which
+ * takes one message per line. Responses are sent without blocking, a client
+ * is not read from again until it received all of them.
  */
 class ipc {
  public:
@@ -32,8 +50,28 @@ class ipc {
   explicit ipc(signal_emitter& emitter, const logger& logger);
   ~ipc();
 
-  void receive_message();
-  int get_file_descriptor() const;
+  void receive_message(int fd);
+  void send_pending(int fd);
+  vector<int> get_file_descriptors() const;
+  vector<int> get_pending_writes() const;
+
+ protected:
+  struct client {
+    unique_ptr<file_descriptor> fd;
+    string buffer;
+    string output;
+    bool closing{false};
+  };
+
+  void accept_clients();
+  void receive_fifo();
+  bool receive_client(client& c);
+  bool process_requests(client& c);
+  bool send_frame(client& c, const string& frame) const;
+  bool flush_client(client& c) const;
+
+  bool dispatch(const string& payload, string& result);
+  bool query(const string& command, string& result, bool& success) const;
 
  private:
   signal_emitter& m_sig;
@@ -41,6 +79,11 @@ class ipc {
 
   string m_path{};
   unique_ptr<file_descriptor> m_fd;
+  string m_fifo_buffer;
+
+  string m_socket_path{};
+  unique_ptr<file_descriptor> m_socket;
+  std::map<int, client> m_clients;
 };
 
 POLYBAR_NS_END
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+#include "common.hpp"
+
+POLYBAR_NS
+
+/**
+ * Framing used on the ipc socket
+ *
+ * Every frame starts with a fixed size header followed by `size` bytes of
+ * payload. A request payload holds one or more messages ("cmd:...",
+ * "hook:...", "action:...") separated by NUL bytes. They are processed in
+ * order and the server answers with exactly one frame holding one result
+ * per message, also separated by NUL bytes. Each result is either "ok",
+ * "ok:<data>" or "error:<reason>".
+ *
+ * Shared with polybar-msg, so this header must not depend on anything
+ * outside of common.hpp.
+ */
+namespace ipc_msg {
+  static constexpr uint8_t MAGIC[4]{'p', 'b', 'i', 'p'};
+  static constexpr uint8_t VERSION{1};
+
+  /**
+   * Upper limit for the payload of a single frame
+   */
+  static constexpr uint32_t MAX_SIZE{1 << 20};
+
+  enum class type : uint8_t {
+    REQUEST = 0,
+    RESPONSE_OK = 1,
+    RESPONSE_ERROR = 2,
+  };
+
+  struct header {
+    uint8_t magic[4];
+    uint8_t version;
+    type msg_type;
+    uint16_t reserved;
+    uint32_t size;
+  };
+
+  static_assert(sizeof(header) == 12, "ipc header must not contain padding");
+
+  /**
+   * Build a frame with the given messages as payload
+   */
+  inline string encode(type msg_type, const vector<string>& messages) {
+    string payload;
+    for (size_t i = 0; i < messages.size(); i++) {
+      if (i > 0) {
+        payload += '\0';
+      }
+      payload += messages[i];
+    }
+
+    header hdr{};
+    memcpy(hdr.magic, MAGIC, sizeof(MAGIC));
+    hdr.version = VERSION;
+    hdr.msg_type = msg_type;
+    hdr.size = static_cast<uint32_t>(payload.size());
+
+    string frame(reinterpret_cast<const char*>(&hdr), sizeof(hdr));
+    return frame + payload;
+  }
+
+  /**
+   * Check the header of a received frame
+   */
+  inline bool valid(const header& hdr) {
+    return memcmp(hdr.magic, MAGIC, sizeof(MAGIC)) == 0 && hdr.version == VERSION && hdr.size <= MAX_SIZE;
+  }
+
+  /**
+   * Split a frame payload into its messages
+   */
+  inline vector<string> decode(const string& payload) {
+    vector<string> messages;
+    size_t start{0};
+    size_t end;
+    while ((end = payload.find('\0', start)) != string::npos) {
+      messages.emplace_back(payload.substr(start, end - start));
+      start = end + 1;
+    }
+    messages.emplace_back(payload.substr(start));
+    return messages;
+  }
+}  // namespace ipc_msg
+
+POLYBAR_NS_END
@@ -1,9 +1,11 @@
 #pragma once
 
+#include <array>
+#include <atomic>
 #include <cstdio>
-#include <map>
 #include <string>
 #include <thread>
+#include <type_traits>
 #include <utility>
 
 #include "common.hpp"
@@ -18,6 +20,8 @@
 
 POLYBAR_NS
 
+class log_writer;
+
 enum class loglevel {
   NONE = 0,
   ERROR,
@@ -33,11 +37,15 @@ class logger {
   static make_type make(loglevel level = loglevel::NONE);
 
   explicit logger(loglevel level);
+  ~logger();
 
   static loglevel parse_verbosity(const string& name, loglevel fallback = loglevel::NONE);
 
   void verbosity(loglevel level);
 
+  void flush() const;
+  size_t dropped() const;
+
 #ifdef DEBUG_LOGGER  // {{{
   template <typename... Args>
   void trace(const string& message, Args&&... args) const {
@@ -108,8 +116,28 @@ class logger {
   size_t convert(std::thread::id arg) const;
 
   /**
-   * Write the log message to the output channel
+   * Compile-time check that a converted argument can be passed through printf varargs
+   */
+  template <typename T>
+  struct is_printf_arg
+      : std::integral_constant<bool, std::is_arithmetic<std::decay_t<T>>::value ||
+                                         std::is_enum<std::decay_t<T>>::value ||
+                                         std::is_pointer<std::decay_t<T>>::value ||
+                                         std::is_null_pointer<std::decay_t<T>>::value> {};
+
+  template <typename... Ts>
+  struct all_printf_args : std::true_type {};
+
+  template <typename T, typename... Ts>
+  struct all_printf_args<T, Ts...>
+      : std::integral_constant<bool, is_printf_arg<T>::value && all_printf_args<Ts...>::value> {};
+
+  /**
+   * Format the log message and hand it over to the writer thread
    * if the defined verbosity level allows it
+   *
+   * Only the formatting happens on the calling thread, the actual
+   * write to the output channel is done in the background
    */
   template <typename... Args>
   void output(loglevel level, const string& format, Args&&... values) const {
@@ -117,23 +145,49 @@ class logger {
       return;
     }
 
+    format_and_enqueue(level, format.c_str(), convert(values)...);
+  }
+
+  template <typename... Args>
+  void format_and_enqueue(loglevel level, const char* format, Args... values) const {
+    static_assert(all_printf_args<Args...>::value, "Log arguments must be numbers, pointers or strings");
+
 #if defined(__clang__)  // {{{
 #pragma clang diagnostic push
 #pragma clang diagnostic ignored "-Wformat-security"
+#pragma clang diagnostic ignored "-Wformat-nonliteral"
 #elif defined(__GNUC__)
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wformat-security"
+#pragma GCC diagnostic ignored "-Wformat-nonliteral"
 #endif  // }}}
 
-    dprintf(m_fd, (m_prefixes.at(level) + format + m_suffixes.at(level) + "\n").c_str(), convert(values)...);
+    const string& prefix = m_prefixes[static_cast<size_t>(level)];
+    const string& suffix = m_suffixes[static_cast<size_t>(level)];
+
+    int length = snprintf(nullptr, 0, format, values...);
+    if (length < 0) {
+      return;
+    }
+
+    // The message is written straight into its final place between prefix and suffix
+    string line(prefix.size() + length + suffix.size() + 1, '\n');
+    line.replace(0, prefix.size(), prefix);
+    snprintf(&line[prefix.size()], length + 1, format, values...);
+    line.replace(prefix.size() + length, suffix.size(), suffix);
+    line.back() = '\n';
 
 #if defined(__clang__)  // {{{
 #pragma clang diagnostic pop
 #elif defined(__GNUC__)
 #pragma GCC diagnostic pop
 #endif  // }}}
+
+    enqueue(level, move(line));
   }
 
+  void enqueue(loglevel level, string&& line) const;
+
  private:
   /**
    * Logger verbosity level
@@ -148,12 +202,17 @@ class logger {
   /**
    * Loglevel specific prefixes
    */
-  std::map<loglevel, string> m_prefixes;
+  std::array<string, static_cast<size_t>(loglevel::TRACE) + 1> m_prefixes;
 
   /**
    * Loglevel specific suffixes
    */
-  std::map<loglevel, string> m_suffixes;
+  std::array<string, static_cast<size_t>(loglevel::TRACE) + 1> m_suffixes;
+
+  /**
+   * Background writer, started with the first message
+   */
+  mutable std::atomic<log_writer*> m_writer{nullptr};
 };
 
 POLYBAR_NS_END
@@ -1,15 +1,15 @@
 #pragma once
 
+#include <unordered_map>
+#include <unordered_set>
+
 #include "common.hpp"
+#include "components/types.hpp"
 #include "errors.hpp"
 
 POLYBAR_NS
 
 class signal_emitter;
-enum class attribute;
-enum class controltag;
-enum class mousebtn;
-struct bar_settings;
 
 DEFINE_ERROR(parser_error);
 DEFINE_CHILD_ERROR(unrecognized_token, parser_error);
@@ -23,22 +23,35 @@ class parser {
 
  public:
   explicit parser(signal_emitter& emitter);
-  void parse(string data);
+  void parse(const string& data);
 
  protected:
-  void codeblock(string&& data);
-  size_t text(string&& data);
+  void codeblock(const string& data);
+  size_t text(string& data);
 
+  const tag_color& parse_color(const string& value);
   static int parse_fontindex(const string& s);
   static attribute parse_attr(const char attr);
-  mousebtn parse_action_btn(const string& data);
+  mousebtn parse_action_btn(const char* data);
   static string parse_action_cmd(string&& data);
+  static size_t action_cmd_end(const string& data, size_t pos);
   static controltag parse_control(const string& data);
 
  private:
   signal_emitter& m_sig;
   vector<int> m_actions;
   unique_ptr<parser> m_parser;
+
+  // Reused between calls to avoid allocations
+  string m_block;
+  string m_text;
+  string m_value;
+  action m_action;
+
+  static constexpr size_t MAX_CACHED_COLORS{256};
+  std::unordered_map<string, tag_color> m_colors;
+  // Never cleared, the renderer keeps the addresses as handles
+  std::unordered_set<string> m_animations;
 };
 
 POLYBAR_NS_END
@@ -8,10 +8,13 @@
 #include "cairo/fwd.hpp"
 #include "cairo/context.hpp"
 #include "common.hpp"
+#include "components/action_index.hpp"
+#include "components/block_layout.hpp"
 #include "components/types.hpp"
 #include "drawtypes/resources/animated_color.hpp"
 #include "events/signal_fwd.hpp"
 #include "events/signal_receiver.hpp"
+#include "settings.hpp"
 #include "x11/extensions/fwd.hpp"
 #include "x11/types.hpp"
 
@@ -23,14 +26,17 @@ class connection;
 class logger;
 class background_manager;
 class bg_slice;
+class shm_image;
 // }}}
 
 using std::map;
 
 struct alignment_block {
-  cairo_pattern_t* pattern;
-  double x;
-  double y;
+  // Advance of the contents drawn so far
+  double x{0.0};
+  double y{0.0};
+  // Fingerprint of everything drawn into the block so far
+  size_t hash{0};
 };
 
 class renderer
@@ -39,7 +45,7 @@ class renderer
           signals::parser::change_font, signals::parser::change_alignment, signals::parser::reverse_colors,
           signals::parser::offset_pixel, signals::parser::attribute_set, signals::parser::attribute_unset,
           signals::parser::attribute_toggle, signals::parser::action_begin, signals::parser::action_end,
-          signals::parser::text, signals::parser::control> {
+          signals::parser::text, signals::parser::control, signals::ui::update_background> {
  public:
   using make_type = unique_ptr<renderer>;
   static make_type make(const bar_settings& bar);
@@ -49,11 +55,12 @@ class renderer
   ~renderer();
 
   xcb_window_t window() const;
-  const vector<action_block> actions() const;
+  shared_ptr<const action_index> actions() const;
 
   void begin(xcb_rectangle_t rect);
+  void layout();
   void end();
-  void flush();
+  void flush(bool damaged_only = false);
 
 #if 0
   void reserve_space(edge side, unsigned int w);
@@ -71,9 +78,11 @@ class renderer
   double block_w(alignment a) const;
   double block_h(alignment a) const;
 
-  void flush(alignment a);
+  void reset_state();
+  void update_damage();
+  void fill_falloff(alignment a);
   void highlight_clickable_areas();
-  unsigned int parse_color(const string& value, unsigned int fallback);
+  unsigned int resolve_color(const tag_color& color, unsigned int fallback);
 
   bool on(const signals::ui::request_snapshot& evt);
   bool on(const signals::parser::change_background& evt);
@@ -91,6 +100,7 @@ class renderer
   bool on(const signals::parser::action_end& evt);
   bool on(const signals::parser::text& evt);
   bool on(const signals::parser::control& evt);
+  bool on(const signals::ui::update_background& evt);
 
  protected:
   struct reserve_area {
@@ -98,6 +108,13 @@ class renderer
     unsigned int size{0U};
   };
 
+  // What a block showed in the last frame
+  struct presented_block {
+    size_t hash{0};
+    double x{0.0};
+    double width{0.0};
+  };
+
  private:
   connection& m_connection;
   signal_emitter& m_sig;
@@ -118,11 +135,25 @@ class renderer
 
   // bool m_autosize{false};
 
+#if WITH_XSHM
+  // when set, cairo renders into shared memory instead of m_pixmap
+  unique_ptr<shm_image> m_shm;
+#endif
   unique_ptr<cairo::context> m_context;
-  unique_ptr<cairo::xcb_surface> m_surface;
+  unique_ptr<cairo::surface> m_surface;
   map<alignment, alignment_block> m_blocks;
+  block_layout m_layout{};
+  // Advance of every text run in the measure pass, in the order they are drawn
+  vector<double> m_run_widths;
+  size_t m_run{0};
   cairo_pattern_t* m_cornermask{};
 
+  map<alignment, presented_block> m_presented;
+  // Area of the bar that changed in the last frame and wasn't flushed yet
+  xcb_rectangle_t m_damage{0, 0, 0U, 0U};
+  // The next frame has to be redrawn completely (e.g. nothing was drawn yet)
+  bool m_redraw_all{true};
+
   cairo_operator_t m_comp_bg{CAIRO_OPERATOR_SOURCE};
   cairo_operator_t m_comp_fg{CAIRO_OPERATOR_OVER};
   cairo_operator_t m_comp_ol{CAIRO_OPERATOR_OVER};
@@ -130,6 +161,7 @@ class renderer
   cairo_operator_t m_comp_border{CAIRO_OPERATOR_OVER};
   bool m_pseudo_transparency{false};
 
+  bool m_measuring{false};
   alignment m_align;
   std::bitset<3> m_attr;
   int m_font{0};
@@ -137,11 +169,18 @@ class renderer
   double m_time;
   unsigned int m_frame;
   unsigned int m_framerate_ms;
-  string m_bg{0U};
-  string m_fg{0U};
-  string m_ol{0U};
-  string m_ul{0U};
+  tag_color m_bg{};
+  tag_color m_fg{};
+  tag_color m_ol{};
+  tag_color m_ul{};
+  std::unordered_map<const string*, animated_color_t> m_animations;
+  // During the measure pass only the first m_num_actions are used, the
+  // others are overwritten so that their commands keep their storage
   vector<action_block> m_actions;
+  size_t m_num_actions{0};
+  shared_ptr<const action_index> m_action_index{make_shared<action_index>()};
+  // Index of the frame before the last one, rebuilt once no reader holds it
+  shared_ptr<action_index> m_spare_index;
 
   bool m_fixedcenter;
   string m_snapshot_dst;
@@ -1,12 +1,11 @@
 #pragma once
 
-#include <atomic>
 #include <chrono>
-#include <condition_variable>
 #include <mutex>
-#include <thread>
+#include <unordered_map>
 
 #include "common.hpp"
+#include "utils/file.hpp"
 #include "utils/mixins.hpp"
 
 POLYBAR_NS
@@ -14,10 +13,20 @@ POLYBAR_NS
 namespace chrono = std::chrono;
 using namespace std::chrono_literals;
 
+/**
+ * Deferred and repeated tasks, ordered by deadline
+ *
+ * The queue doesn't run a thread of its own. It arms a timerfd for the
+ * earliest deadline, the event loop polls that descriptor and calls
+ * process() once it becomes readable.
+ *
+ * Tasks are kept in a binary min-heap, each task knows its position in
+ * the heap so that it can be removed or rescheduled in O(log n).
+ */
 class taskqueue : non_copyable_mixin<taskqueue> {
  public:
   struct deferred {
-    using clock = chrono::high_resolution_clock;
+    using clock = chrono::steady_clock;
     using duration = chrono::milliseconds;
     using timepoint = chrono::time_point<clock, duration>;
     using callback = function<void(size_t remaining)>;
@@ -25,11 +34,17 @@ class taskqueue : non_copyable_mixin<taskqueue> {
     explicit deferred(string id, timepoint now, duration wait, callback fn, size_t count)
         : id(move(id)), func(move(fn)), now(move(now)), wait(move(wait)), count(move(count)) {}
 
+    timepoint deadline() const {
+      return now + wait;
+    }
+
     const string id;
     const callback func;
     timepoint now;
     duration wait;
     size_t count;
+    // Position in the heap
+    size_t index{0};
   };
 
  public:
@@ -37,7 +52,6 @@ class taskqueue : non_copyable_mixin<taskqueue> {
   static make_type make();
 
   explicit taskqueue();
-  ~taskqueue();
 
   void defer(
       string id, deferred::duration ms, deferred::callback fn, deferred::duration offset = 0ms, size_t count = 1);
@@ -47,16 +61,23 @@ class taskqueue : non_copyable_mixin<taskqueue> {
   bool exist(const string& id);
   bool purge(const string& id);
 
+  int get_file_descriptor() const;
+  void process();
+
  protected:
-  void tick();
+  void push(unique_ptr<deferred>&& task);
+  void remove(size_t index);
+  void sift_up(size_t index);
+  void sift_down(size_t index);
+  void swap(size_t a, size_t b);
+  void arm();
 
  private:
-  std::thread m_thread;
+  file_descriptor m_timerfd;
   std::mutex m_lock{};
-  std::condition_variable m_hold;
-  std::atomic_bool m_active{true};
 
-  vector<unique_ptr<deferred>> m_deferred;
+  vector<unique_ptr<deferred>> m_heap;
+  std::unordered_multimap<string, deferred*> m_ids;
 };
 
 POLYBAR_NS_END
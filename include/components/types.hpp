@@ -115,6 +115,26 @@ struct line_settings {
   unsigned int size{0U};
 };
 
+/**
+ * Color of a format tag, resolved by the parser once per distinct value
+ */
+struct tag_color {
+  enum class type { NONE, PLAIN, ANIMATED };
+
+  type kind{type::NONE};
+  // argb value of plain colors
+  unsigned int value{0U};
+  // Interned gradient spec (the part after "anim:") of animated colors
+  const string* anim{nullptr};
+
+  bool operator==(const tag_color& other) const {
+    return kind == other.kind && value == other.value && anim == other.anim;
+  }
+  bool operator!=(const tag_color& other) const {
+    return !(*this == other);
+  }
+};
+
 struct action {
   mousebtn button{mousebtn::NONE};
   string command{};
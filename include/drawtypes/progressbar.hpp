@@ -22,12 +22,19 @@ namespace drawtypes {
     string output(float percentage);
 
    protected:
+    enum class segment_type { TEXT, FILL, INDICATOR, EMPTY };
+
+    struct segment {
+      segment_type type;
+      string text;
+    };
+
     void fill(unsigned int perc, unsigned int fill_width);
 
    private:
     unique_ptr<builder> m_builder;
     vector<string> m_colors;
-    string m_format;
+    vector<segment> m_segments;
     unsigned int m_width;
     unsigned int m_colorstep = 1;
     bool m_gradient = false;
@@ -39,15 +39,19 @@ namespace signals {
 
       explicit value_signal(void* data) : m_ptr(data) {}
       explicit value_signal(ValueType&& data) : m_ptr(&data) {}
+      explicit value_signal(const ValueType& data) : m_ptr(&data) {}
 
       virtual ~value_signal() {}
 
-      inline ValueType cast() const {
-        return *static_cast<ValueType*>(m_ptr);
+      /**
+       * Get the value, it is only valid while the signal is emitted
+       */
+      inline const ValueType& cast() const {
+        return *static_cast<const ValueType*>(m_ptr);
       }
 
      private:
-      void* m_ptr;
+      const void* m_ptr;
     };
   }  // namespace detail
 
@@ -73,13 +77,13 @@ namespace signals {
   }  // namespace eventqueue
 
   namespace ipc {
-    struct command : public detail::value_signal<command, string> {
+    struct command : public detail::value_signal<command, ipc_request> {
       using base_type::base_type;
     };
-    struct hook : public detail::value_signal<hook, string> {
+    struct hook : public detail::value_signal<hook, ipc_request> {
       using base_type::base_type;
     };
-    struct action : public detail::value_signal<action, string> {
+    struct action : public detail::value_signal<action, ipc_request> {
       using base_type::base_type;
     };
   }  // namespace ipc
@@ -132,16 +136,16 @@ namespace signals {
   }  // namespace ui_tray
 
   namespace parser {
-    struct change_background : public detail::value_signal<change_background, string> {
+    struct change_background : public detail::value_signal<change_background, tag_color> {
       using base_type::base_type;
     };
-    struct change_foreground : public detail::value_signal<change_foreground, string> {
+    struct change_foreground : public detail::value_signal<change_foreground, tag_color> {
       using base_type::base_type;
     };
-    struct change_underline : public detail::value_signal<change_underline, string> {
+    struct change_underline : public detail::value_signal<change_underline, tag_color> {
       using base_type::base_type;
     };
-    struct change_overline : public detail::value_signal<change_overline, string> {
+    struct change_overline : public detail::value_signal<change_overline, tag_color> {
       using base_type::base_type;
     };
     struct change_font : public detail::value_signal<change_font, int> {
@@ -13,6 +13,7 @@
 #include "utils/functional.hpp"
 #include "utils/inotify.hpp"
 #include "utils/string.hpp"
+#include "utils/trace.hpp"
 
 POLYBAR_NS
 
@@ -55,9 +56,27 @@ namespace modules {
 
   // class definition : module_format {{{
 
+  /**
+   * Piece of a format, either literal text or a tag
+   *
+   * Formats are split into these when they are added, so that building the
+   * module output doesn't have to parse the format string again
+   */
+  struct format_op {
+    enum class type { TEXT, TAG };
+
+    type kind;
+    string value;
+    // Text only: value without leading spaces, used as long as no tag has been built
+    string trimmed;
+  };
+
   struct module_format {
     string value{};
     vector<string> tags{};
+    vector<format_op> ops{};
+    // Text after the last tag
+    string tail{};
     label_t prefix{};
     label_t suffix{};
     string fg{};
@@ -72,6 +91,7 @@ namespace modules {
     int offset{0};
     int font{0};
 
+    void compile();
     string decorate(builder* builder, string output);
   };
 
@@ -155,6 +175,9 @@ namespace modules {
 
     bool m_handle_events{true};
 
+    trace_util::stage& m_update_trace;
+    trace_util::stage& m_contents_trace;
+
    private:
     atomic<bool> m_enabled{true};
     atomic<bool> m_changed{true};
@@ -19,7 +19,9 @@ namespace modules {
       , m_name("module/" + name)
       , m_builder(make_unique<builder>(bar))
       , m_formatter(make_unique<module_formatter>(m_conf, m_name))
-      , m_handle_events(m_conf.get(m_name, "handle-events", true)) {}
+      , m_handle_events(m_conf.get(m_name, "handle-events", true))
+      , m_update_trace(trace_util::get_stage(m_name + ":update"))
+      , m_contents_trace(trace_util::get_stage(m_name + ":contents")) {}
 
   template <typename Impl>
   module<Impl>::~module() noexcept {
@@ -79,13 +81,14 @@ namespace modules {
   string module<Impl>::contents() {
     if (m_changed) {
       m_log.info("%s: Rebuilding cache", name());
+      trace_util::scope trace{m_contents_trace};
       m_cache = CAST_MOD(Impl)->get_output();
       // Make sure builder is really empty
       m_builder->flush();
       if (!m_cache.empty()) {
         // Add a reset tag after the module
         m_builder->control(controltag::R);
-        m_cache += m_builder->flush();
+        m_builder->flush(m_cache);
       }
       m_changed = false;
     }
@@ -145,44 +148,35 @@ namespace modules {
     bool fake_no_tag_built{false};
     bool tag_built{false};
     auto mingap = std::max(1_z, format->spacing);
-    size_t start, end;
-    string value{format->value};
-    while ((start = value.find('<')) != string::npos && (end = value.find('>', start)) != string::npos) {
-      if (start > 0) {
+
+    for (auto&& op : format->ops) {
+      if (op.kind == format_op::type::TEXT) {
         if (no_tag_built) {
           // If no module tag has been built we do not want to add
           // whitespace defined between the format tags, but we do still
           // want to output other non-tag content
-          auto trimmed = string_util::ltrim(value.substr(0, start), ' ');
-          if (!trimmed.empty()) {
+          if (!op.trimmed.empty()) {
             fake_no_tag_built = false;
-            m_builder->node(move(trimmed));
+            m_builder->node(op.trimmed);
           }
         } else {
-          m_builder->node(value.substr(0, start));
+          m_builder->node(op.value);
         }
-        value.erase(0, start);
-        end -= start;
-        start = 0;
-      }
-      string tag{value.substr(start, end + 1)};
-      if (tag.empty()) {
         continue;
-      } else if (tag[0] == '<' && tag[tag.size() - 1] == '>') {
-        if (!no_tag_built)
-          m_builder->space(format->spacing);
-        else if (fake_no_tag_built)
-          no_tag_built = false;
-        if (!(tag_built = CONST_MOD(Impl).build(m_builder.get(), tag)) && !no_tag_built)
-          m_builder->remove_trailing_space(mingap);
-        if (tag_built)
-          no_tag_built = false;
       }
-      value.erase(0, tag.size());
+
+      if (!no_tag_built)
+        m_builder->space(format->spacing);
+      else if (fake_no_tag_built)
+        no_tag_built = false;
+      if (!(tag_built = CONST_MOD(Impl).build(m_builder.get(), op.value)) && !no_tag_built)
+        m_builder->remove_trailing_space(mingap);
+      if (tag_built)
+        no_tag_built = false;
     }
 
-    if (!value.empty()) {
-      m_builder->append(value);
+    if (!format->tail.empty()) {
+      m_builder->append(format->tail);
     }
 
     return format->decorate(&*m_builder, m_builder->flush());
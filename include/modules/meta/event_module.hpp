@@ -20,13 +20,20 @@ namespace modules {
       try {
         // warm up module output before entering the loop
         std::unique_lock<std::mutex> guard(this->m_updatelock);
-        CAST_MOD(Impl)->update();
+        {
+          trace_util::scope trace{this->m_update_trace};
+          CAST_MOD(Impl)->update();
+        }
         CAST_MOD(Impl)->broadcast();
         guard.unlock();
 
         const auto check = [&]() -> bool {
           std::lock_guard<std::mutex> guard(this->m_updatelock);
-          return CAST_MOD(Impl)->has_event() && CAST_MOD(Impl)->update();
+          if (!CAST_MOD(Impl)->has_event()) {
+            return false;
+          }
+          trace_util::scope trace{this->m_update_trace};
+          return CAST_MOD(Impl)->update();
         };
 
         while (this->running()) {
@@ -21,7 +21,10 @@ namespace modules {
       try {
         // Warm up module output before entering the loop
         std::unique_lock<std::mutex> guard(this->m_updatelock);
-        CAST_MOD(Impl)->on_event(nullptr);
+        {
+          trace_util::scope trace{this->m_update_trace};
+          CAST_MOD(Impl)->on_event(nullptr);
+        }
         CAST_MOD(Impl)->broadcast();
         guard.unlock();
 
@@ -71,7 +74,12 @@ namespace modules {
               w->remove(true);
             }
 
-            if (CAST_MOD(Impl)->on_event(event.get())) {
+            bool changed{false};
+            {
+              trace_util::scope trace{this->m_update_trace};
+              changed = CAST_MOD(Impl)->on_event(event.get());
+            }
+            if (changed) {
               CAST_MOD(Impl)->broadcast();
             }
             CAST_MOD(Impl)->idle();
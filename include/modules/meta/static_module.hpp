@@ -13,7 +13,10 @@ namespace modules {
     void start() {
       this->m_mainthread = thread([&] {
         this->m_log.trace("%s: Thread id = %i", this->name(), concurrency_util::thread_id(this_thread::get_id()));
-        CAST_MOD(Impl)->update();
+        {
+          trace_util::scope trace{this->m_update_trace};
+          CAST_MOD(Impl)->update();
+        }
         CAST_MOD(Impl)->broadcast();
       });
     }
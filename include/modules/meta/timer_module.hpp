@@ -1,5 +1,6 @@
 #pragma once
 
+#include "components/executor.hpp"
 #include "modules/meta/base.hpp"
 
 POLYBAR_NS
@@ -7,56 +8,102 @@ POLYBAR_NS
 namespace modules {
   using interval_t = chrono::duration<double>;
 
+  /**
+   * Module updated in fixed intervals
+   *
+   * Updates run as tasks on the shared executor instead of on a thread of
+   * their own. Modules that block on I/O should set m_blocking.
+   */
   template <class Impl>
   class timer_module : public module<Impl> {
    public:
     using module<Impl>::module;
 
+    ~timer_module() {
+      if (m_group) {
+        executor::make().cancel(*m_group);
+      }
+    }
+
     void start() {
-      this->m_mainthread = thread(&timer_module::runner, this);
+      m_group = make_unique<executor::group>(this->name(), m_blocking ? executor::pool::IO : executor::pool::CPU);
+      executor::make().post(*m_group, [this, generation = m_generation.load()] { tick(generation); });
     }
 
-   protected:
-    void runner() {
-      this->m_log.trace("%s: Thread id = %i", this->name(), concurrency_util::thread_id(this_thread::get_id()));
+    void stop() {
+      module<Impl>::stop();
+      if (m_group) {
+        executor::make().cancel(*m_group);
+      }
+    }
 
-      const auto check = [&]() -> bool {
-        std::unique_lock<std::mutex> guard(this->m_updatelock);
-        return CAST_MOD(Impl)->update();
-      };
+    /**
+     * Update right away instead of waiting for the next interval
+     */
+    void wakeup() {
+      module<Impl>::wakeup();
+      if (m_group && this->running()) {
+        executor::make().post(*m_group, [this, generation = ++m_generation] { tick(generation); });
+      }
+    }
 
-      try {
-        // warm up module output before entering the loop
-        check();
-        CAST_MOD(Impl)->broadcast();
+   protected:
+    void tick(size_t generation) {
+      // A wakeup started a new chain of updates
+      if (generation != m_generation) {
+        return;
+      }
 
-        while (this->running()) {
-          if (check()) {
-            CAST_MOD(Impl)->broadcast();
+      try {
+        bool changed{false};
+        {
+          std::lock_guard<std::mutex> guard(this->m_updatelock);
+          if (!this->running()) {
+            return;
           }
-          // wait until next full interval to avoid drifting clocks
-          using clock = chrono::system_clock;
-          using sys_duration_t = clock::time_point::duration;
-
-          auto sys_interval = chrono::duration_cast<sys_duration_t>(m_interval);
-          clock::time_point now = clock::now();
-          sys_duration_t adjusted = sys_interval - (now.time_since_epoch() % sys_interval);
-
-          // The seemingly arbitrary addition of 500ms is due
-          // to the fact that if we wait the exact time our
-          // thread will be woken just a tiny bit prematurely
-          // and therefore the wrong time will be displayed.
-          // It is currently unknown why exactly the thread gets
-          // woken prematurely.
-          CAST_MOD(Impl)->sleep_until(now + adjusted + 500ms);
+          trace_util::scope trace{this->m_update_trace};
+          // Always show the output of the first update
+          changed = CAST_MOD(Impl)->update() || !m_warm;
+          m_warm = true;
+        }
+        if (changed) {
+          CAST_MOD(Impl)->broadcast();
         }
       } catch (const exception& err) {
         CAST_MOD(Impl)->halt(err.what());
+        return;
+      }
+
+      if (!this->running()) {
+        return;
       }
+
+      // wait until next full interval to avoid drifting clocks
+      using clock = chrono::system_clock;
+      using sys_duration_t = clock::time_point::duration;
+
+      auto sys_interval = chrono::duration_cast<sys_duration_t>(m_interval);
+      sys_duration_t adjusted = sys_interval - (clock::now().time_since_epoch() % sys_interval);
+
+      // The seemingly arbitrary addition of 500ms is due
+      // to the fact that if we wait the exact time our
+      // thread will be woken just a tiny bit prematurely
+      // and therefore the wrong time will be displayed.
+      // It is currently unknown why exactly the thread gets
+      // woken prematurely.
+      executor::make().post_at(
+          *m_group, executor::clock::now() + adjusted + 500ms, [this, generation] { tick(generation); });
     }
 
    protected:
     interval_t m_interval{1.0};
+    bool m_blocking{false};
+
+   private:
+    unique_ptr<executor::group> m_group;
+    atomic<size_t> m_generation{0};
+    // Guarded by m_updatelock
+    bool m_warm{false};
   };
 }  // namespace modules
 
@@ -65,6 +65,7 @@ namespace modules {
     void handle(const evt::property_notify& evt);
 
     void rebuild_clientlist();
+    void update_client_desktop(xcb_window_t client);
     void rebuild_desktops();
     void rebuild_desktop_states();
     void set_desktop_urgent(xcb_window_t window);
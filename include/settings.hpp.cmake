@@ -20,6 +20,9 @@ extern const char* const APP_VERSION;
 #cmakedefine01 WITH_XKB
 #cmakedefine01 WITH_XRM
 #cmakedefine01 WITH_XCURSOR
+#cmakedefine01 WITH_XSHM
+
+#cmakedefine01 WITH_HARFBUZZ
 
 #if WITH_XRANDR
 #cmakedefine01 WITH_XRANDR_MONITORS
@@ -36,6 +39,7 @@ extern const char* const APP_VERSION;
 #cmakedefine XPP_EXTENSION_LIST @XPP_EXTENSION_LIST@
 
 #cmakedefine DEBUG_LOGGER
+#cmakedefine DEBUG_ALLOCATIONS
 
 #if DEBUG
 #cmakedefine DEBUG_LOGGER_VERBOSE
@@ -66,6 +70,7 @@ extern const char* const PATH_BATTERY;
 extern const char* const PATH_CPU_INFO;
 extern const char* const PATH_MEMORY_INFO;
 extern const char* const PATH_MESSAGING_FIFO;
+extern const char* const PATH_MESSAGING_SOCKET;
 extern const char* const PATH_TEMPERATURE_INFO;
 extern const char* const WIRELESS_LIB;
 
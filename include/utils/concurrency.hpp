@@ -1,5 +1,6 @@
 #pragma once
 
+#include <array>
 #include <atomic>
 #include <chrono>
 #include <map>
@@ -63,6 +64,71 @@ class mutex_wrapper : public T {
   mutable mutex m_mtx;
 };
 
+/**
+ * Bounded lock-free queue for many producers and a single consumer
+ *
+ * Every slot carries a sequence number telling whether it is free for the
+ * producer claiming that position or holds a value for the consumer, so
+ * producers only contend on the tail counter.
+ */
+template <typename T, size_t Capacity>
+class mpsc_ring : public non_copyable_mixin<mpsc_ring<T, Capacity>> {
+  static_assert(Capacity > 1 && (Capacity & (Capacity - 1)) == 0, "Capacity has to be a power of two");
+
+ public:
+  explicit mpsc_ring() {
+    for (size_t i = 0; i < Capacity; i++) {
+      m_slots[i].sequence.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  /**
+   * Add a value, returns false if the ring is full
+   */
+  bool push(T value) {
+    size_t pos = m_tail.load(std::memory_order_relaxed);
+    while (true) {
+      auto& s = m_slots[pos & (Capacity - 1)];
+      auto diff = static_cast<std::ptrdiff_t>(s.sequence.load(std::memory_order_acquire) - pos);
+      if (diff == 0) {
+        if (m_tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+          s.value = move(value);
+          s.sequence.store(pos + 1, std::memory_order_release);
+          return true;
+        }
+      } else if (diff < 0) {
+        return false;
+      } else {
+        pos = m_tail.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  /**
+   * Take the oldest value, may only be called from the consumer thread
+   */
+  bool pop(T& value) {
+    auto& s = m_slots[m_head & (Capacity - 1)];
+    if (s.sequence.load(std::memory_order_acquire) != m_head + 1) {
+      return false;
+    }
+    value = move(s.value);
+    s.sequence.store(m_head + Capacity, std::memory_order_release);
+    m_head++;
+    return true;
+  }
+
+ private:
+  struct slot {
+    std::atomic<size_t> sequence;
+    T value;
+  };
+
+  array<slot, Capacity> m_slots;
+  alignas(64) std::atomic<size_t> m_tail{0};
+  alignas(64) size_t m_head{0};
+};
+
 namespace concurrency_util {
   size_t thread_id(const thread::id id);
 }
@@ -49,6 +49,29 @@ class file_descriptor {
   bool m_autoclose{true};
 };
 
+/**
+ * Read-only view of a whole file
+ *
+ * Regular files are memory mapped, anything else (pipes, character devices)
+ * is read into a buffer instead.
+ */
+class mapped_file {
+ public:
+  explicit mapped_file(const string& path);
+  ~mapped_file();
+
+  mapped_file(const mapped_file&) = delete;
+  mapped_file& operator=(const mapped_file&) = delete;
+
+  const char* data() const;
+  size_t size() const;
+
+ private:
+  void* m_map{nullptr};
+  size_t m_size{0};
+  string m_buffer;
+};
+
 class fd_streambuf : public std::streambuf {
  public:
   using traits_type = std::streambuf::traits_type;
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+
+#include "common.hpp"
+
+POLYBAR_NS
+
+namespace trace_util {
+  using clock = std::chrono::steady_clock;
+
+  /**
+   * Lock-free latency histogram with logarithmic buckets
+   *
+   * Every power of two is split into a fixed number of linear sub-buckets,
+   * which keeps the relative error below 1/SUB_BUCKETS over the full range
+   * while recording only needs a couple of bit operations.
+   */
+  class histogram {
+   public:
+    static constexpr size_t SUB_BITS{3};
+    static constexpr size_t SUB_BUCKETS{1 << SUB_BITS};
+    static constexpr size_t BUCKETS{64 * SUB_BUCKETS};
+
+    void record(uint64_t ns);
+    void reset();
+
+    uint64_t count() const;
+    uint64_t max() const;
+    uint64_t percentile(double p) const;
+
+   protected:
+    static size_t index(uint64_t ns);
+    static uint64_t upper_bound(size_t index);
+
+   private:
+    std::array<std::atomic<uint64_t>, BUCKETS> m_buckets{};
+    std::atomic<uint64_t> m_count{0};
+    std::atomic<uint64_t> m_max{0};
+  };
+
+  /**
+   * Named measuring point with its own histogram
+   */
+  struct stage {
+    explicit stage(string name) : name(move(name)) {}
+
+    const string name;
+    histogram hist;
+
+    /**
+     * Heap allocations made while inside the stage,
+     * only counted when built with DEBUG_ALLOCATIONS
+     */
+    std::atomic<uint64_t> allocations{0};
+  };
+
+  stage& get_stage(const string& name);
+
+  uint64_t allocations();
+
+  void record(stage& s, clock::time_point start, clock::time_point end, uint64_t allocs = 0);
+
+  void start_capture();
+  void stop_capture();
+  bool capturing();
+  bool dump(const string& path);
+
+  string summary();
+  void reset();
+
+  /**
+   * Measures the lifetime of the object
+   */
+  class scope {
+   public:
+    explicit scope(stage& s) : m_stage(s), m_allocs(allocations()), m_start(clock::now()) {}
+    ~scope() {
+      record(m_stage, m_start, clock::now(), allocations() - m_allocs);
+    }
+
+    scope(const scope&) = delete;
+    scope& operator=(const scope&) = delete;
+
+   private:
+    stage& m_stage;
+    uint64_t m_allocs;
+    clock::time_point m_start;
+  };
+}  // namespace trace_util
+
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+
+/**
+ * Record the time spent until the end of the enclosing block
+ */
+#define TRACE_SCOPE(name)                                                                   \
+  static auto& TRACE_CONCAT(trace_stage_, __LINE__) = trace_util::get_stage(name);          \
+  trace_util::scope TRACE_CONCAT(trace_scope_, __LINE__) {                                  \
+    TRACE_CONCAT(trace_stage_, __LINE__)                                                    \
+  }
+
+POLYBAR_NS_END
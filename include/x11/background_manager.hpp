@@ -36,6 +36,14 @@ class bg_slice {
     return m_surface.get();
   }
 
+  /**
+   * Same as get_surface, but the background is kept in client memory.
+   *
+   * Used when drawing onto client side surfaces, so the background is only
+   * read back from the X server once after every change.
+   */
+  cairo::surface* get_image_surface();
+
  private:
   bg_slice(connection& conn, const logger& log, xcb_rectangle_t rect, xcb_window_t window, xcb_visualtype_t* visual);
 
@@ -49,8 +57,13 @@ class bg_slice {
   // cache for the root window background at this slice's position
   xcb_pixmap_t m_pixmap{XCB_NONE};
   unique_ptr<cairo::xcb_surface> m_surface;
+  unique_ptr<cairo::surface> m_image;
   xcb_gcontext_t m_gcontext{XCB_NONE};
 
+  // root pixmap and source position the cache was last filled from
+  xcb_pixmap_t m_source{XCB_NONE};
+  xcb_point_t m_source_pos{0, 0};
+
   void allocate_resources(const logger& log, xcb_visualtype_t* visual);
   void free_resources();
 
@@ -118,7 +131,7 @@ class background_manager : public signal_receiver<SIGN_PRIORITY_SCREEN, signals:
 
   void allocate_resources();
   void free_resources();
-  void fetch_root_pixmap();
+  bool fetch_root_pixmap(bool force);
 
 };
 
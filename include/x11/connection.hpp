@@ -119,6 +119,7 @@ class connection : public detail::connection_base<connection&, XPP_EXTENSION_LIS
   string id(xcb_window_t w) const;
 
   void ensure_event_mask(xcb_window_t win, unsigned int event);
+  void ensure_event_mask(const vector<xcb_window_t>& windows, unsigned int event);
   void clear_event_mask(xcb_window_t win);
 
   shared_ptr<xcb_client_message_event_t> make_client_message(xcb_atom_t type, xcb_window_t target) const;
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <xcb/xcb.h>
+
+#include <functional>
+
+#include "common.hpp"
+
+POLYBAR_NS
+
+/**
+ * Reply of a request that has already been sent
+ *
+ * Creating the future only queues the request, the reply is read
+ * (and the output buffer flushed) on the first call to get(). Issuing
+ * all requests needed for an event before reading any of the replies
+ * therefore costs a single round trip.
+ *
+ * Replies that are never read are discarded when the future is destroyed.
+ */
+template <typename T>
+class cookie_future {
+ public:
+  using fetch_type = std::function<T(unsigned int sequence)>;
+
+  explicit cookie_future(xcb_connection_t* conn, unsigned int sequence, fetch_type fetch)
+      : m_conn(conn), m_sequence(sequence), m_fetch(move(fetch)) {}
+
+  cookie_future(cookie_future&& other) noexcept
+      : m_conn(other.m_conn)
+      , m_sequence(other.m_sequence)
+      , m_fetch(move(other.m_fetch))
+      , m_value(move(other.m_value))
+      , m_fetched(other.m_fetched) {
+    other.m_conn = nullptr;
+  }
+
+  cookie_future(const cookie_future&) = delete;
+  cookie_future& operator=(const cookie_future&) = delete;
+  cookie_future& operator=(cookie_future&&) = delete;
+
+  ~cookie_future() {
+    if (!m_fetched && m_conn != nullptr) {
+      xcb_discard_reply(m_conn, m_sequence);
+    }
+  }
+
+  /**
+   * Wait for the reply, it is only read once
+   */
+  const T& get() {
+    if (!m_fetched) {
+      m_value = m_fetch(m_sequence);
+      m_fetched = true;
+    }
+    return m_value;
+  }
+
+ private:
+  xcb_connection_t* m_conn;
+  unsigned int m_sequence;
+  fetch_type m_fetch;
+  T m_value{};
+  bool m_fetched{false};
+};
+
+POLYBAR_NS_END
@@ -4,6 +4,7 @@
 
 #include "common.hpp"
 #include "utils/memory.hpp"
+#include "x11/cookie.hpp"
 
 POLYBAR_NS
 
@@ -29,6 +30,7 @@ namespace ewmh_util {
 
   void change_current_desktop(unsigned int desktop);
   unsigned int get_desktop_from_window(xcb_window_t window);
+  vector<unsigned int> get_desktops_from_windows(const vector<xcb_window_t>& windows);
 
   void set_wm_window_type(xcb_window_t win, vector<xcb_atom_t> types);
 
@@ -42,6 +44,20 @@ namespace ewmh_util {
   void set_wm_window_opacity(xcb_window_t win, unsigned long int values);
 
   vector<xcb_window_t> get_client_list(int screen = 0);
+
+  /**
+   * Non-blocking variants of the getters above, see cookie_future
+   */
+  cookie_future<string> request_wm_name(xcb_window_t win);
+  cookie_future<string> request_visible_name(xcb_window_t win);
+  cookie_future<string> request_icon_name(xcb_window_t win);
+  cookie_future<vector<string>> request_desktop_names(int screen = 0);
+  cookie_future<unsigned int> request_current_desktop(int screen = 0);
+  cookie_future<unsigned int> request_number_of_desktops(int screen = 0);
+  cookie_future<xcb_window_t> request_active_window(int screen = 0);
+  cookie_future<unsigned int> request_desktop_from_window(xcb_window_t window);
+
+  string get_window_title(xcb_connection_t* conn, xcb_window_t win, bool visible_name = true);
 }
 
 POLYBAR_NS_END
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "settings.hpp"
+
+#if not WITH_XSHM
+#error "X Shared Memory extension is disabled..."
+#endif
+
+#include <cairo/cairo.h>
+#include <xcb/shm.h>
+
+#include "common.hpp"
+
+POLYBAR_NS
+
+// fwd
+class connection;
+
+namespace shm_util {
+  bool query_extension(connection& conn);
+  bool compatible(connection& conn, xcb_visualtype_t* visual, int depth);
+}
+
+/**
+ * Client side image shared with the X server through MIT-SHM
+ *
+ * Cairo renders into the shared segment in-process (see data()) and put()
+ * only sends a small request telling the server which area to read from it.
+ * The image doesn't know what changed, the caller passes the damaged area.
+ *
+ * The server reads the segment asynchronously, so sync() has to be called
+ * before drawing into the image again.
+ */
+class shm_image {
+ public:
+  explicit shm_image(connection& conn, int depth, unsigned int width, unsigned int height);
+  ~shm_image();
+
+  shm_image(const shm_image&) = delete;
+  shm_image& operator=(const shm_image&) = delete;
+
+  unsigned char* data() const;
+  cairo_format_t format() const;
+  int stride() const;
+
+  void put(xcb_drawable_t dst, xcb_gcontext_t gc, const xcb_rectangle_t& rect);
+  void sync();
+
+ private:
+  connection& m_connection;
+
+  int m_depth;
+  unsigned int m_width;
+  unsigned int m_height;
+  int m_stride;
+
+  int m_shmid{-1};
+  unsigned char* m_data{nullptr};
+  xcb_shm_seg_t m_segment{XCB_NONE};
+
+  // request sent after the last put, its reply means the server is done reading
+  xcb_get_input_focus_cookie_t m_fence{0};
+  bool m_pending{false};
+};
+
+POLYBAR_NS_END
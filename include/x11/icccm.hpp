@@ -3,6 +3,7 @@
 #include <xcb/xcb_icccm.h>
 
 #include "common.hpp"
+#include "x11/cookie.hpp"
 
 POLYBAR_NS
 
@@ -13,6 +14,9 @@ namespace icccm_util {
   void set_wm_name(xcb_connection_t* c, xcb_window_t w, const char* wmname, size_t l, const char* wmclass, size_t l2);
   void set_wm_protocols(xcb_connection_t* c, xcb_window_t w, vector<xcb_atom_t> flags);
   bool get_wm_urgency(xcb_connection_t* c, xcb_window_t w);
+
+  cookie_future<string> request_wm_name(xcb_connection_t* c, xcb_window_t w);
+  cookie_future<bool> request_wm_urgency(xcb_connection_t* c, xcb_window_t w);
 }
 
 POLYBAR_NS_END
@@ -21,7 +21,7 @@ class tray_client {
 
   unsigned int width() const;
   unsigned int height() const;
-  void clear_window() const;
+  xcb_void_cookie_t clear_window() const;
 
   bool match(const xcb_window_t& win) const;
   bool mapped() const;
@@ -30,8 +30,14 @@ class tray_client {
   xcb_window_t window() const;
   xembed_data* xembed() const;
 
+  int x() const;
+  int y() const;
+  void place(int x, int y);
+  bool placed() const;
+
   void ensure_state() const;
   void reconfigure(int x, int y) const;
+  xcb_void_cookie_t configure();
   void configure_notify(int x, int y) const;
 
  protected:
@@ -43,6 +49,11 @@ class tray_client {
 
   unsigned int m_width;
   unsigned int m_height;
+
+  // position assigned by the tray layout and whether the window has been moved there
+  int m_x{0};
+  int m_y{0};
+  bool m_placed{false};
 };
 
 POLYBAR_NS_END
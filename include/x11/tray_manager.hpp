@@ -113,6 +113,7 @@ class tray_manager
 
   int calculate_client_x(const xcb_window_t& win);
   int calculate_client_y();
+  void update_layout();
 
   bool is_embedded(const xcb_window_t& win) const;
   shared_ptr<tray_client> find_client(const xcb_window_t& win) const;
@@ -154,6 +155,9 @@ class tray_manager
   unsigned int m_prevwidth{0U};
   unsigned int m_prevheight{0U};
 
+  // number of clients in m_clients that are mapped
+  unsigned int m_mapped_clients{0U};
+
   xcb_atom_t m_atom{0};
   xcb_window_t m_tray{0};
   xcb_window_t m_othermanager{0};
@@ -2,11 +2,16 @@
 
 #include <arpa/inet.h>
 #include <linux/ethtool.h>
+#include <linux/if.h>
 #include <linux/if_link.h>
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
 #include <linux/sockios.h>
 #include <net/if.h>
 #include <netdb.h>
 #include <netinet/in.h>
+#include <netinet/ip_icmp.h>
+#include <poll.h>
 #include <sys/ioctl.h>
 #include <sys/socket.h>
 
@@ -14,7 +19,6 @@
 
 #include "common.hpp"
 #include "settings.hpp"
-#include "utils/command.hpp"
 #include "utils/file.hpp"
 #include "utils/string.hpp"
 
@@ -30,13 +34,18 @@ namespace net {
 
   static const string NO_IP = string("N/A");
 
+  /**
+   * Time to wait for the kernel to answer a route netlink request
+   */
+  static constexpr int RTNL_TIMEOUT_MS{1000};
+
   // class : network {{{
 
   /**
    * Construct network interface
    */
   network::network(string interface) : m_log(logger::make()), m_interface(move(interface)) {
-    if (if_nametoindex(m_interface.c_str()) == 0) {
+    if ((m_ifid = if_nametoindex(m_interface.c_str())) == 0) {
       throw network_error("Invalid network interface \"" + m_interface + "\"");
     }
 
@@ -45,97 +54,422 @@ namespace net {
       throw network_error("Failed to open socket");
     }
 
+    /*
+     * The route netlink socket is kept open for the lifetime of the
+     * interface. Besides answering our own requests, it is subscribed to the
+     * link and address groups so that changes are queued up as they happen
+     * instead of having to be discovered by walking all interfaces.
+     */
+    m_rtnlfd = file_util::make_file_descriptor(socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC | SOCK_NONBLOCK, NETLINK_ROUTE));
+    if (!*m_rtnlfd) {
+      throw network_error("Failed to open netlink socket");
+    }
+
+    struct sockaddr_nl addr {};
+    addr.nl_family = AF_NETLINK;
+    addr.nl_groups = RTMGRP_LINK | RTMGRP_IPV4_IFADDR | RTMGRP_IPV6_IFADDR;
+
+    if (bind(*m_rtnlfd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) == -1) {
+      throw network_error("Failed to bind netlink socket (" + string(strerror(errno)) + ")");
+    }
+
+    // Replies to our requests are addressed to the port id the kernel assigned
+    socklen_t addrlen{sizeof(addr)};
+    if (getsockname(*m_rtnlfd, reinterpret_cast<struct sockaddr*>(&addr), &addrlen) == -1) {
+      throw network_error("Failed to get netlink socket address (" + string(strerror(errno)) + ")");
+    }
+    m_rtnl_portid = addr.nl_pid;
+
     check_tuntap_or_bridge();
   }
 
   /**
    * Query device driver for information
+   *
+   * Byte counters and the operational state are requested for the single
+   * interface (or dumped for all interfaces when accumulating). Addresses
+   * are only re-read after the kernel notified us about a change.
    */
   bool network::query(bool accumulate) {
     m_status.previous = m_status.current;
     m_status.current.transmitted = 0;
     m_status.current.received = 0;
     m_status.current.time = std::chrono::system_clock::now();
-    m_status.ip = NO_IP;
-    m_status.ip6 = NO_IP;
 
-    struct ifaddrs* ifaddr;
-    if (getifaddrs(&ifaddr) == -1 || ifaddr == nullptr) {
+    if (!rtnl_request(RTM_GETLINK, accumulate, accumulate)) {
       return false;
     }
 
-    for (auto ifa = ifaddr; ifa != nullptr; ifa = ifa->ifa_next) {
-      if (ifa->ifa_addr == nullptr) {
-        continue;
+    if (m_addr_changed) {
+      m_addr_changed = false;
+      m_status.ip = NO_IP;
+      m_status.ip6 = NO_IP;
+
+      if (!rtnl_request(RTM_GETADDR, true, accumulate)) {
+        m_addr_changed = true;
+        return false;
       }
+    }
 
-      if (m_interface.compare(0, m_interface.length(), ifa->ifa_name) != 0) {
-        if (!accumulate || (ifa->ifa_data == nullptr && ifa->ifa_addr->sa_family != AF_PACKET)) {
+    return true;
+  }
+
+  /**
+   * Send a request on the route netlink socket and wait for the answer
+   */
+  bool network::rtnl_request(unsigned short type, bool dump, bool accumulate) {
+    struct {
+      struct nlmsghdr hdr;
+      union {
+        struct ifinfomsg link;
+        struct ifaddrmsg addr;
+      };
+    } req{};
+
+    req.hdr.nlmsg_type = type;
+    req.hdr.nlmsg_flags = NLM_F_REQUEST | (dump ? NLM_F_DUMP : 0);
+    req.hdr.nlmsg_seq = ++m_rtnl_seq;
+
+    if (type == RTM_GETLINK) {
+      req.hdr.nlmsg_len = NLMSG_LENGTH(sizeof(req.link));
+      req.link.ifi_family = AF_UNSPEC;
+      req.link.ifi_index = dump ? 0 : m_ifid;
+    } else {
+      req.hdr.nlmsg_len = NLMSG_LENGTH(sizeof(req.addr));
+      req.addr.ifa_family = AF_UNSPEC;
+    }
+
+    if (send(*m_rtnlfd, &req, req.hdr.nlmsg_len, 0) == -1) {
+      m_log.warn("Failed to send netlink request (%s)", strerror(errno));
+      return false;
+    }
+
+    return rtnl_receive(req.hdr.nlmsg_seq, accumulate);
+  }
+
+  /**
+   * Process messages on the route netlink socket until the
+   * request with the given sequence number has been answered
+   *
+   * Notifications queued up before the answer are processed on the way
+   */
+  bool network::rtnl_receive(unsigned int seq, bool accumulate) {
+    alignas(struct nlmsghdr) char buffer[16384];
+
+    while (true) {
+      struct pollfd pfd {
+        *m_rtnlfd, POLLIN, 0
+      };
+
+      int ready = poll(&pfd, 1, RTNL_TIMEOUT_MS);
+      if (ready == 0) {
+        m_log.warn("Timed out waiting for netlink reply");
+        return false;
+      } else if (ready == -1) {
+        if (errno == EINTR) {
           continue;
         }
+        return false;
       }
 
-      struct sockaddr_in6* sa6;
+      ssize_t len = recv(*m_rtnlfd, buffer, sizeof(buffer), 0);
 
-      switch (ifa->ifa_addr->sa_family) {
-        case AF_INET:
-          char ip_buffer[NI_MAXHOST];
-          getnameinfo(ifa->ifa_addr, sizeof(sockaddr_in), ip_buffer, NI_MAXHOST, nullptr, 0, NI_NUMERICHOST);
-          m_status.ip = string{ip_buffer};
-          break;
+      if (len == -1) {
+        if (errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK) {
+          continue;
+        } else if (errno == ENOBUFS) {
+          // Notifications were dropped, so we cannot trust the cached addresses anymore
+          m_addr_changed = true;
+          continue;
+        }
+        m_log.warn("Failed to read from netlink socket (%s)", strerror(errno));
+        return false;
+      }
 
-        case AF_INET6:
-          char ip6_buffer[INET6_ADDRSTRLEN];
-          sa6 = reinterpret_cast<decltype(sa6)>(ifa->ifa_addr);
-          if (IN6_IS_ADDR_LINKLOCAL(&sa6->sin6_addr)) {
-            continue;
-          }
-          if (IN6_IS_ADDR_SITELOCAL(&sa6->sin6_addr)) {
-            continue;
-          }
-          if ((((unsigned char*)sa6->sin6_addr.s6_addr)[0] & 0xFE) == 0xFC) {
-            /* Skip Unique Local Addresses (fc00::/7) */
-            continue;
-          }
-          if (inet_ntop(AF_INET6, &sa6->sin6_addr, ip6_buffer, INET6_ADDRSTRLEN) == 0) {
-            m_log.warn("inet_ntop() " + string(strerror(errno)));
-            continue;
-          }
-          m_status.ip6 = string{ip6_buffer};
-          break;
+      bool done{false};
+      auto remaining = static_cast<unsigned int>(len);
 
-        case AF_PACKET:
-          if (ifa->ifa_data == nullptr) {
+      for (auto msg = reinterpret_cast<struct nlmsghdr*>(buffer); NLMSG_OK(msg, remaining);
+           msg = NLMSG_NEXT(msg, remaining)) {
+        bool reply = msg->nlmsg_seq == seq && msg->nlmsg_pid == m_rtnl_portid;
+
+        switch (msg->nlmsg_type) {
+          case NLMSG_DONE:
+            done = done || reply;
             continue;
-          }
-          struct rtnl_link_stats* link_state = reinterpret_cast<decltype(link_state)>(ifa->ifa_data);
-          if (link_state == nullptr) {
+
+          case NLMSG_ERROR:
+            if (reply) {
+              auto error = static_cast<struct nlmsgerr*>(NLMSG_DATA(msg));
+              if (error->error != 0) {
+                m_log.warn("Netlink request failed (%s)", strerror(-error->error));
+              }
+              return error->error == 0;
+            }
             continue;
-          }
-          m_status.current.transmitted += link_state->tx_bytes;
-          m_status.current.received += link_state->rx_bytes;
-          break;
+
+          case RTM_NEWLINK:
+          case RTM_DELLINK:
+            parse_link(msg, reply, accumulate);
+            break;
+
+          case RTM_NEWADDR:
+          case RTM_DELADDR:
+            if (reply) {
+              parse_address(msg);
+            } else if (static_cast<struct ifaddrmsg*>(NLMSG_DATA(msg))->ifa_index == m_ifid) {
+              m_addr_changed = true;
+            }
+            break;
+
+          default:
+            break;
+        }
+
+        if (reply && !(msg->nlmsg_flags & NLM_F_MULTI)) {
+          done = true;
+        }
+      }
+
+      if (done) {
+        return true;
+      }
+    }
+  }
+
+  /**
+   * Read the operational state and the byte counters from a link message
+   */
+  void network::parse_link(const struct nlmsghdr* msg, bool reply, bool accumulate) {
+    auto info = static_cast<const struct ifinfomsg*>(NLMSG_DATA(msg));
+    bool own = static_cast<unsigned int>(info->ifi_index) == m_ifid;
+
+    if (!own && !(reply && accumulate)) {
+      return;
+    }
+
+    bytes_t transmitted{0};
+    bytes_t received{0};
+    bool has_stats64{false};
+
+    auto remaining = static_cast<int>(IFLA_PAYLOAD(msg));
+    for (auto attr = IFLA_RTA(info); RTA_OK(attr, remaining); attr = RTA_NEXT(attr, remaining)) {
+      if (attr->rta_type == IFLA_OPERSTATE && own) {
+        m_operstate = *static_cast<unsigned char*>(RTA_DATA(attr));
+      } else if (attr->rta_type == IFLA_STATS64) {
+        struct rtnl_link_stats64 stats {};
+        memcpy(&stats, RTA_DATA(attr), std::min<size_t>(sizeof(stats), RTA_PAYLOAD(attr)));
+        transmitted = stats.tx_bytes;
+        received = stats.rx_bytes;
+        has_stats64 = true;
+      } else if (attr->rta_type == IFLA_STATS && !has_stats64) {
+        struct rtnl_link_stats stats {};
+        memcpy(&stats, RTA_DATA(attr), std::min<size_t>(sizeof(stats), RTA_PAYLOAD(attr)));
+        transmitted = stats.tx_bytes;
+        received = stats.rx_bytes;
       }
     }
 
-    freeifaddrs(ifaddr);
+    if (reply && msg->nlmsg_type == RTM_NEWLINK) {
+      m_status.current.transmitted += transmitted;
+      m_status.current.received += received;
+    }
+  }
 
-    return true;
+  /**
+   * Read the interface address from an address message
+   */
+  void network::parse_address(const struct nlmsghdr* msg) {
+    auto info = static_cast<const struct ifaddrmsg*>(NLMSG_DATA(msg));
+
+    if (info->ifa_index != m_ifid || msg->nlmsg_type != RTM_NEWADDR) {
+      return;
+    }
+
+    const void* address{nullptr};
+    const void* local{nullptr};
+
+    auto remaining = static_cast<int>(IFA_PAYLOAD(msg));
+    for (auto attr = IFA_RTA(info); RTA_OK(attr, remaining); attr = RTA_NEXT(attr, remaining)) {
+      if (attr->rta_type == IFA_ADDRESS) {
+        address = RTA_DATA(attr);
+      } else if (attr->rta_type == IFA_LOCAL) {
+        local = RTA_DATA(attr);
+      }
+    }
+
+    if (info->ifa_family == AF_INET) {
+      char ip_buffer[INET_ADDRSTRLEN];
+      // On point-to-point links IFA_ADDRESS is the remote end, IFA_LOCAL is ours
+      if ((local != nullptr || address != nullptr) &&
+          inet_ntop(AF_INET, local != nullptr ? local : address, ip_buffer, sizeof(ip_buffer)) != nullptr) {
+        m_status.ip = string{ip_buffer};
+      }
+    } else if (info->ifa_family == AF_INET6 && address != nullptr) {
+      struct in6_addr addr6 {};
+      memcpy(&addr6, address, sizeof(addr6));
+
+      if (IN6_IS_ADDR_LINKLOCAL(&addr6)) {
+        return;
+      }
+      if (IN6_IS_ADDR_SITELOCAL(&addr6)) {
+        return;
+      }
+      if ((addr6.s6_addr[0] & 0xFE) == 0xFC) {
+        /* Skip Unique Local Addresses (fc00::/7) */
+        return;
+      }
+
+      char ip6_buffer[INET6_ADDRSTRLEN];
+      if (inet_ntop(AF_INET6, &addr6, ip6_buffer, sizeof(ip6_buffer)) == nullptr) {
+        m_log.warn("inet_ntop() " + string(strerror(errno)));
+        return;
+      }
+      m_status.ip6 = string{ip6_buffer};
+    }
   }
 
   /**
-   * Run ping command to test internet connectivity
+   * Test internet connectivity by sending echo requests to CONNECTION_TEST_IP
+   *
+   * Uses an unprivileged ICMP socket and falls back to a UDP probe if the
+   * system does not allow those (see net.ipv4.ping_group_range)
    */
   bool network::ping() const {
+    const int timeout_ms{2000};
+
     try {
-      auto exec = "ping -c 2 -W 2 -I " + m_interface + " " + string(CONNECTION_TEST_IP);
-      auto ping = command_util::make_command<output_policy::IGNORED>(exec);
-      return ping && ping->exec(true) == EXIT_SUCCESS;
-    } catch (const std::exception& err) {
+      return ping_icmp(timeout_ms);
+    } catch (const network_error& err) {
+      m_log.trace("network: %s, falling back to udp probe", err.what());
+    }
+
+    try {
+      return ping_udp(timeout_ms);
+    } catch (const network_error& err) {
+      m_log.warn("network: Failed to test connectivity (%s)", err.what());
       return false;
     }
   }
 
+  /**
+   * Open a datagram socket bound to the interface address
+   * and connected to CONNECTION_TEST_IP
+   *
+   * \\throws network_error if the socket could not be set up
+   */
+  static unique_ptr<file_descriptor> make_probe_socket(int protocol, unsigned short port, const string& source) {
+    auto fd = file_util::make_file_descriptor(socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC | SOCK_NONBLOCK, protocol));
+    if (!*fd) {
+      throw network_error("Failed to open probe socket (" + string(strerror(errno)) + ")");
+    }
+
+    struct sockaddr_in src {};
+    src.sin_family = AF_INET;
+    if (source != NO_IP && inet_pton(AF_INET, source.c_str(), &src.sin_addr) == 1 &&
+        bind(*fd, reinterpret_cast<struct sockaddr*>(&src), sizeof(src)) == -1) {
+      throw network_error("Failed to bind probe socket (" + string(strerror(errno)) + ")");
+    }
+
+    struct sockaddr_in dst {};
+    dst.sin_family = AF_INET;
+    dst.sin_port = htons(port);
+    if (inet_pton(AF_INET, CONNECTION_TEST_IP, &dst.sin_addr) != 1) {
+      throw network_error("Invalid connection test address " + string(CONNECTION_TEST_IP));
+    }
+    if (connect(*fd, reinterpret_cast<struct sockaddr*>(&dst), sizeof(dst)) == -1) {
+      throw network_error("Failed to connect probe socket (" + string(strerror(errno)) + ")");
+    }
+
+    return fd;
+  }
+
+  /**
+   * Wait for any datagram (or ICMP error) on the probe socket
+   */
+  static bool await_probe_reply(int fd, int timeout_ms) {
+    struct pollfd pfd {
+      fd, POLLIN, 0
+    };
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+
+    while (true) {
+      auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now());
+      if (left.count() <= 0) {
+        return false;
+      }
+
+      int ready = poll(&pfd, 1, left.count());
+      if (ready == 0) {
+        return false;
+      } else if (ready == -1) {
+        if (errno == EINTR) {
+          continue;
+        }
+        return false;
+      }
+
+      char buffer[512];
+      if (recv(fd, buffer, sizeof(buffer), 0) >= 0) {
+        return true;
+      } else if (errno == ECONNREFUSED) {
+        // The host answered with port unreachable, which still proves connectivity
+        return true;
+      } else if (errno != EINTR && errno != EAGAIN && errno != EWOULDBLOCK) {
+        return false;
+      }
+    }
+  }
+
+  /**
+   * Send two echo requests using an unprivileged ICMP socket
+   *
+   * \\throws network_error if ICMP sockets are not permitted
+   */
+  bool network::ping_icmp(int timeout_ms) const {
+    auto fd = make_probe_socket(IPPROTO_ICMP, 0, m_status.ip);
+
+    // The kernel fills in the identifier and checksum for ping sockets
+    struct icmphdr request {};
+    request.type = ICMP_ECHO;
+
+    for (unsigned short seq = 1; seq <= 2; seq++) {
+      request.un.echo.sequence = htons(seq);
+      if (send(*fd, &request, sizeof(request), 0) == -1) {
+        return false;
+      }
+      if (await_probe_reply(*fd, timeout_ms / 2)) {
+        return true;
+      }
+    }
+
+    return false;
+  }
+
+  /**
+   * Send a minimal DNS query to port 53 of the test address
+   *
+   * Any answer, including an ICMP port unreachable error, counts as success
+   */
+  bool network::ping_udp(int timeout_ms) const {
+    auto fd = make_probe_socket(IPPROTO_UDP, 53, m_status.ip);
+
+    // Query for the NS records of the root zone
+    const unsigned char query[]{0x50, 0x42, 0x01, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+        0x02, 0x00, 0x01};
+
+    for (int attempt = 0; attempt < 2; attempt++) {
+      if (send(*fd, query, sizeof(query), 0) == -1) {
+        return errno == ECONNREFUSED;
+      }
+      if (await_probe_reply(*fd, timeout_ms / 2)) {
+        return true;
+      }
+    }
+
+    return false;
+  }
+
   /**
    * Get interface ipv4 address
    */
@@ -213,11 +547,12 @@ namespace net {
 
   /**
    * Test if the network interface is in a valid state
+   *
+   * Uses the operational state reported by the last query
    */
   bool network::test_interface() const {
-    auto operstate = file_util::contents("/sys/class/net/" + m_interface + "/operstate");
-    bool up = operstate.compare(0, 2, "up") == 0;
-    return m_unknown_up ? (up || operstate.compare(0, 7, "unknown") == 0) : up;
+    bool up = m_operstate == IF_OPER_UP;
+    return m_unknown_up ? (up || m_operstate == IF_OPER_UNKNOWN) : up;
   }
 
   /**
@@ -16,14 +16,16 @@ namespace net {
       return false;
     }
 
-    auto socket_fd = file_util::make_file_descriptor(iw_sockets_open());
-    if (!*socket_fd) {
-      return false;
+    if (!m_iwsocket || !*m_iwsocket) {
+      m_iwsocket = file_util::make_file_descriptor(iw_sockets_open());
+      if (!*m_iwsocket) {
+        return false;
+      }
     }
 
     struct iwreq req {};
 
-    if (iw_get_ext(*socket_fd, m_interface.c_str(), SIOCGIWMODE, &req) == -1) {
+    if (iw_get_ext(*m_iwsocket, m_interface.c_str(), SIOCGIWMODE, &req) == -1) {
       return false;
     }
 
@@ -32,8 +34,8 @@ namespace net {
       return false;
     }
 
-    query_essid(*socket_fd);
-    query_quality(*socket_fd);
+    query_essid(*m_iwsocket);
+    query_quality(*m_iwsocket);
 
     return true;
   }
@@ -11,6 +11,10 @@ POLYBAR_NS
 namespace net {
   // class : wireless_network {{{
 
+  wireless_network::~wireless_network() {
+    disconnect_nl80211();
+  }
+
   /**
    * Query the wireless device for information
    * about the current connection
@@ -20,50 +24,82 @@ namespace net {
       return false;
     }
 
-    struct nl_sock* sk = nl_socket_alloc();
-    if (sk == nullptr) {
+    if (m_nl_sock == nullptr && !connect_nl80211()) {
       return false;
     }
 
-    if (genl_connect(sk) < 0) {
+    // The request is reused, only the header needs to be reset so that it gets a fresh sequence number
+    struct nlmsghdr* hdr = nlmsg_hdr(m_nl_msg);
+    hdr->nlmsg_seq = NL_AUTO_SEQ;
+    hdr->nlmsg_pid = NL_AUTO_PORT;
+    hdr->nlmsg_flags = NLM_F_DUMP;
+
+    if (nl_send_auto(m_nl_sock, m_nl_msg) < 0 || nl_wait_for_ack(m_nl_sock) < 0) {
+      // Drop the socket, it will be reopened on the next query
+      disconnect_nl80211();
       return false;
     }
 
-    int driver_id = genl_ctrl_resolve(sk, "nl80211");
-    if (driver_id < 0) {
-      nl_socket_free(sk);
+    return true;
+  }
+
+  /**
+   * Open the generic netlink socket and prepare the scan request
+   *
+   * Both are kept around between queries
+   */
+  bool wireless_network::connect_nl80211() {
+    m_nl_sock = nl_socket_alloc();
+    if (m_nl_sock == nullptr) {
       return false;
     }
 
-    if (nl_socket_modify_cb(sk, NL_CB_VALID, NL_CB_CUSTOM, scan_cb, this) != 0) {
-      nl_socket_free(sk);
+    if (genl_connect(m_nl_sock) < 0) {
+      disconnect_nl80211();
       return false;
     }
 
-    struct nl_msg* msg = nlmsg_alloc();
-    if (msg == nullptr) {
-      nl_socket_free(sk);
+    int driver_id = genl_ctrl_resolve(m_nl_sock, "nl80211");
+    if (driver_id < 0) {
+      disconnect_nl80211();
       return false;
     }
 
-    if ((genlmsg_put(msg, NL_AUTO_PORT, NL_AUTO_SEQ, driver_id, 0, NLM_F_DUMP, NL80211_CMD_GET_SCAN, 0) == nullptr) ||
-        nla_put_u32(msg, NL80211_ATTR_IFINDEX, m_ifid) < 0) {
-      nlmsg_free(msg);
-      nl_socket_free(sk);
+    if (nl_socket_modify_cb(m_nl_sock, NL_CB_VALID, NL_CB_CUSTOM, scan_cb, this) != 0) {
+      disconnect_nl80211();
       return false;
     }
 
-    // nl_send_sync always frees msg
-    if (nl_send_sync(sk, msg) < 0) {
-      nl_socket_free(sk);
+    m_nl_msg = nlmsg_alloc();
+    if (m_nl_msg == nullptr) {
+      disconnect_nl80211();
       return false;
     }
 
-    nl_socket_free(sk);
+    if ((genlmsg_put(m_nl_msg, NL_AUTO_PORT, NL_AUTO_SEQ, driver_id, 0, NLM_F_DUMP, NL80211_CMD_GET_SCAN, 0) ==
+            nullptr) ||
+        nla_put_u32(m_nl_msg, NL80211_ATTR_IFINDEX, m_ifid) < 0) {
+      disconnect_nl80211();
+      return false;
+    }
 
     return true;
   }
 
+  /**
+   * Release the generic netlink socket and the prepared request
+   */
+  void wireless_network::disconnect_nl80211() {
+    if (m_nl_msg != nullptr) {
+      nlmsg_free(m_nl_msg);
+      m_nl_msg = nullptr;
+    }
+    if (m_nl_sock != nullptr) {
+      nl_socket_free(m_nl_sock);
+      m_nl_sock = nullptr;
+    }
+  }
+
   /**
    * Check current connection state
    */
@@ -1,6 +1,14 @@
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
 #include <map>
 
 #include "cairo/utils.hpp"
+#include "utils/env.hpp"
+#include "utils/file.hpp"
 
 POLYBAR_NS
 
@@ -38,6 +46,186 @@ namespace cairo {
       return m_face;
     }
 
+    // }}}
+    // implementation : font_cache {{{
+
+    font_cache::font_cache(string path) : m_path(move(path)) {}
+
+    font_cache::~font_cache() {
+      save();
+    }
+
+    /**
+     * Get the cached match for the given pattern
+     *
+     * Returns nullptr if there is no valid entry, the caller owns the
+     * returned pattern
+     */
+    FcPattern* font_cache::get(const string& pattern, double dpi_x, double dpi_y) {
+      load();
+
+      auto it = m_entries.find(make_key(pattern, dpi_x, dpi_y));
+      if (it == m_entries.end()) {
+        return nullptr;
+      }
+
+      FcPattern* match = FcNameParse(reinterpret_cast<const FcChar8*>(it->second.c_str()));
+      if (match == nullptr) {
+        return nullptr;
+      }
+
+      // The file could have been removed without touching its directory's mtime
+      FcChar8* file;
+      if (FcPatternGetString(match, FC_FILE, 0, &file) != FcResultMatch ||
+          !file_util::exists(reinterpret_cast<const char*>(file))) {
+        FcPatternDestroy(match);
+        return nullptr;
+      }
+
+      return match;
+    }
+
+    /**
+     * Store the match for the given pattern
+     *
+     * Only the properties needed to load the font face are stored, the
+     * charset and language coverage are left out
+     */
+    void font_cache::put(const string& pattern, double dpi_x, double dpi_y, FcPattern* match) {
+      load();
+
+      FcObjectSet* objects = FcObjectSetBuild(FC_FAMILY, FC_STYLE, FC_FILE, FC_INDEX, FC_SIZE, FC_PIXEL_SIZE,
+          FC_SCALABLE, FC_WEIGHT, FC_SLANT, FC_MATRIX, FC_EMBOLDEN, FC_ANTIALIAS, FC_HINTING, FC_HINT_STYLE,
+          FC_AUTOHINT, FC_RGBA, FC_LCD_FILTER, FC_EMBEDDED_BITMAP, FC_VERTICAL_LAYOUT, nullptr);
+      FcPattern* filtered = FcPatternFilter(match, objects);
+      FcObjectSetDestroy(objects);
+
+      if (filtered == nullptr) {
+        return;
+      }
+
+      FcChar8* unparsed = FcNameUnparse(filtered);
+      FcPatternDestroy(filtered);
+
+      if (unparsed == nullptr) {
+        return;
+      }
+
+      m_entries[make_key(pattern, dpi_x, dpi_y)] = reinterpret_cast<const char*>(unparsed);
+      FcStrFree(unparsed);
+      m_dirty = true;
+    }
+
+    /**
+     * $XDG_CACHE_HOME/polybar/fonts, empty if there is no cache directory
+     */
+    string font_cache::default_path() {
+      string dir;
+      if (env_util::has("XDG_CACHE_HOME")) {
+        dir = env_util::get("XDG_CACHE_HOME");
+      } else if (env_util::has("HOME")) {
+        dir = env_util::get("HOME") + "/.cache";
+      } else {
+        return "";
+      }
+      return dir + "/polybar/fonts";
+    }
+
+    string font_cache::make_key(const string& pattern, double dpi_x, double dpi_y) {
+      return pattern + "@" + to_string(dpi_x) + "x" + to_string(dpi_y);
+    }
+
+    /**
+     * Newest modification time of all fontconfig configuration files and font
+     * directories
+     *
+     * Installing or removing fonts changes the mtime of their directory, so
+     * this is enough to tell that a match may no longer be valid
+     */
+    string font_cache::make_stamp() {
+      time_t newest{0};
+      auto update = [&](FcStrList* list) {
+        if (list == nullptr) {
+          return;
+        }
+        struct stat st {};
+        FcChar8* path;
+        while ((path = FcStrListNext(list)) != nullptr) {
+          if (stat(reinterpret_cast<const char*>(path), &st) == 0) {
+            newest = std::max(newest, st.st_mtime);
+          }
+        }
+        FcStrListDone(list);
+      };
+
+      update(FcConfigGetConfigFiles(nullptr));
+      update(FcConfigGetFontDirs(nullptr));
+
+      return to_string(newest);
+    }
+
+    /**
+     * Read all entries that are still valid
+     *
+     * The file contains one entry per line: stamp, key and the unparsed
+     * pattern separated by tabs
+     */
+    void font_cache::load() {
+      if (m_loaded) {
+        return;
+      }
+      m_loaded = true;
+      m_stamp = make_stamp();
+
+      if (m_path.empty()) {
+        return;
+      }
+
+      std::ifstream in(m_path);
+      string line;
+      while (std::getline(in, line)) {
+        size_t key_start = line.find('\t');
+        size_t value_start = line.find('\t', key_start + 1);
+        if (value_start == string::npos || line.compare(0, key_start, m_stamp) != 0) {
+          continue;
+        }
+        m_entries.emplace(line.substr(key_start + 1, value_start - key_start - 1), line.substr(value_start + 1));
+      }
+    }
+
+    /**
+     * Rewrite the cache file with all valid entries if any were added
+     *
+     * Several bars are often started at once, so the file is replaced
+     * atomically instead of written in place
+     */
+    void font_cache::save() {
+      if (!m_dirty || m_path.empty()) {
+        return;
+      }
+      m_dirty = false;
+
+      // Create the parent directories
+      for (size_t pos = m_path.find('/', 1); pos != string::npos; pos = m_path.find('/', pos + 1)) {
+        mkdir(m_path.substr(0, pos).c_str(), 0700);
+      }
+
+      string tmp_path{m_path + "." + to_string(getpid())};
+      {
+        std::ofstream out(tmp_path);
+        for (auto&& entry : m_entries) {
+          out << m_stamp << '\t' << entry.first << '\t' << entry.second << '\n';
+        }
+        if (!out) {
+          std::remove(tmp_path.c_str());
+          return;
+        }
+      }
+      if (std::rename(tmp_path.c_str(), m_path.c_str()) != 0) {
+        std::remove(tmp_path.c_str());
+      }
+    }
+
     // }}}
     // implementation : unicode_character {{{
 
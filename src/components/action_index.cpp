@@ -0,0 +1,120 @@
+#include "components/action_index.hpp"
+
+#include <algorithm>
+
+POLYBAR_NS
+
+namespace {
+  bool is_scroll(mousebtn button) {
+    return button == mousebtn::SCROLL_UP || button == mousebtn::SCROLL_DOWN;
+  }
+}
+
+/**
+ * Build the index from the action blocks of a finished frame
+ */
+action_index::action_index(const vector<action_block>& actions) {
+  assign(actions.data(), actions.size());
+}
+
+/**
+ * Rebuild the index from the action blocks of a finished frame
+ *
+ * Actions that were never closed can't be hit and are left out. Existing
+ * elements are overwritten instead of recreated, so rebuilding the index
+ * for a frame with a similar set of actions doesn't allocate.
+ */
+void action_index::assign(const action_block* actions, size_t count) {
+  size_t num_actions{0};
+  m_bounds.clear();
+  m_doubleclick = false;
+
+  for (size_t i = 0; i < count; i++) {
+    const auto& action = actions[i];
+    if (static_cast<int>(action.button) >= static_cast<int>(mousebtn::DOUBLE_LEFT)) {
+      m_doubleclick = true;
+    }
+    if (action.active || static_cast<int>(action.start_x) >= static_cast<int>(action.end_x)) {
+      continue;
+    }
+    if (num_actions < m_actions.size()) {
+      m_actions[num_actions] = action;
+    } else {
+      m_actions.emplace_back(action);
+    }
+    num_actions++;
+    m_bounds.emplace_back(static_cast<int>(action.start_x));
+    m_bounds.emplace_back(static_cast<int>(action.end_x));
+  }
+  m_actions.resize(num_actions);
+
+  std::sort(m_bounds.begin(), m_bounds.end());
+  m_bounds.erase(std::unique(m_bounds.begin(), m_bounds.end()), m_bounds.end());
+
+  size_t num_regions{0};
+  for (size_t i = 1; i < m_bounds.size(); i++) {
+    if (num_regions == m_regions.size()) {
+      m_regions.emplace_back();
+    }
+    region& r = m_regions[num_regions];
+    r.start = m_bounds[i - 1];
+    r.end = m_bounds[i];
+    r.actions.clear();
+    r.click = false;
+    r.scroll = false;
+
+    for (size_t n = 0; n < m_actions.size(); n++) {
+      if (m_actions[n].test(r.start)) {
+        r.actions.emplace_back(n);
+        r.scroll |= is_scroll(m_actions[n].button);
+        r.click |= !is_scroll(m_actions[n].button) && m_actions[n].button != mousebtn::NONE;
+      }
+    }
+
+    if (!r.actions.empty()) {
+      num_regions++;
+    }
+  }
+  m_regions.resize(num_regions);
+}
+
+/**
+ * Get the region containing x, nullptr if no action covers it
+ */
+const action_index::region* action_index::find(int x) const {
+  auto it = std::upper_bound(
+      m_regions.begin(), m_regions.end(), x, [](int x, const region& r) { return x < r.start; });
+
+  if (it == m_regions.begin() || x >= (--it)->end) {
+    return nullptr;
+  }
+  return &*it;
+}
+
+/**
+ * Get the innermost action for the given button at x
+ *
+ * Nested actions are opened after their surrounding action,
+ * so the last match is the innermost one.
+ */
+const action_block* action_index::find(mousebtn button, int x) const {
+  auto r = find(x);
+  if (r == nullptr) {
+    return nullptr;
+  }
+  for (auto n = r->actions.rbegin(); n != r->actions.rend(); n++) {
+    if (m_actions[*n].button == button) {
+      return &m_actions[*n];
+    }
+  }
+  return nullptr;
+}
+
+/**
+ * Whether any action, closed or not, is bound to a double click
+ */
+bool action_index::has_double_click() const {
+  return m_doubleclick;
+}
+
+POLYBAR_NS_END
@@ -309,6 +309,14 @@ const bar_settings bar::settings() const {
   return m_opts;
 }
 
+/**
+ * Get the queue of deferred ui tasks, its descriptor
+ * has to be watched by the event loop
+ */
+taskqueue& bar::tasks() const {
+  return *m_taskqueue;
+}
+
 void bar::subthread() {
   m_log.trace("Renderer: Start of subthread");
   this_thread::sleep_for(chrono::milliseconds(500U));
@@ -320,6 +328,8 @@ void bar::subthread() {
       m_renderer->increment_subframe(framerate);
       redraw();
     }
+    // Contents that arrived while the frame was drawn
+    draw_pending();
     now += chrono::milliseconds(framerate);
     this_thread::sleep_until(now);
   }
@@ -327,39 +337,90 @@ void bar::subthread() {
 }
 
 /**
- * Parse input string and redraw the bar window
+ * Queue new contents and draw them as soon as the bar is free
+ *
+ * Contents that have not been drawn yet are replaced, so only the
+ * newest contents are ever drawn, and drawn once.
  *
  * \param data Input string
  * \param force Unless true, do not parse unchanged data
  */
 void bar::parse(string&& data, bool force) {
-  if (!m_mutex.try_lock()) {
-    return;
+  {
+    std::lock_guard<std::mutex> guard(m_mailbox_lock);
+    if (!m_redraw_pending) {
+      m_mailbox.queued = trace_util::clock::now();
+      m_mailbox.force = false;
+    }
+    m_mailbox.data = move(data);
+    m_mailbox.force = m_mailbox.force || force;
+    m_redraw_pending = true;
   }
 
-  std::lock_guard<std::mutex> guard(m_mutex, std::adopt_lock);
+  draw_pending();
+}
+
+/**
+ * Draw the contents waiting in the mailbox
+ *
+ * If another thread is drawing, it calls this again once it
+ * is done and picks up the contents itself.
+ */
+void bar::draw_pending() {
+  while (m_redraw_pending) {
+    std::unique_lock<std::mutex> guard(m_mutex, std::try_to_lock);
+    if (!guard.owns_lock()) {
+      return;
+    }
+
+    frame next{};
+    {
+      std::lock_guard<std::mutex> mailbox(m_mailbox_lock);
+      if (!m_redraw_pending) {
+        // Release m_mutex before checking again, another thread may have
+        // failed to get it in the meantime and relies on us to draw
+        continue;
+      }
+      std::swap(next, m_mailbox);
+      m_redraw_pending = false;
+    }
+
+    if (draw(move(next.data), next.force)) {
+      trace_util::record(m_latency_trace, next.queued, trace_util::clock::now());
+    }
+  }
+}
 
+/**
+ * Parse input string and redraw the bar window, m_mutex has to be held
+ *
+ * Returns false if the contents were ignored
+ */
+bool bar::draw(string&& data, bool force) {
   bool unchanged = data == m_lastinput;
 
-  m_lastinput = data;
+  if (!unchanged) {
+    m_lastinput.swap(data);
+  }
 
   if (force) {
     m_log.trace("bar: Force update");
   } else if (!m_visible) {
-    return m_log.trace("bar: Ignoring update (invisible)");
+    m_log.trace("bar: Ignoring update (invisible)");
+    return false;
   } else if (m_opts.shaded) {
-    return m_log.trace("bar: Ignoring update (shaded)");
+    m_log.trace("bar: Ignoring update (shaded)");
+    return false;
   } else if (unchanged) {
-    return m_log.trace("bar: Ignoring update (unchanged)");
+    m_log.trace("bar: Ignoring update (unchanged)");
+    return false;
   }
 
 	redraw();
 
   const auto check_dblclicks = [&]() -> bool {
-    for (auto&& action : m_renderer->actions()) {
-      if (static_cast<int>(action.button) >= static_cast<int>(mousebtn::DOUBLE_LEFT)) {
-        return true;
-      }
+    if (m_renderer->actions()->has_double_click()) {
+      return true;
     }
     for (auto&& action : m_opts.actions) {
       if (static_cast<int>(action.button) >= static_cast<int>(mousebtn::DOUBLE_LEFT)) {
@@ -369,9 +430,12 @@ void bar::parse(string&& data, bool force) {
     return false;
   };
   m_dblclicks = check_dblclicks();
+  return true;
 }
 
 void bar::redraw() {
+  TRACE_SCOPE("bar::redraw");
+
   auto rect = m_opts.inner_area();
 
   if (m_tray && !m_tray->settings().detached && m_tray->settings().configured_slots) {
@@ -389,6 +453,9 @@ void bar::redraw() {
   m_renderer->begin(rect);
 
   try {
+    // Measure the blocks first, then draw them at their final position
+    m_parser->parse(m_lastinput);
+    m_renderer->layout();
     m_parser->parse(m_lastinput);
   } catch (const parser_error& err) {
     m_log.err("Failed to parse contents (reason: %s)\nContent: %s", err.what(), m_lastinput);
@@ -647,69 +714,59 @@ void bar::handle(const evt::leave_notify&) {
  * Used to change the cursor depending on the module
  */
 void bar::handle(const evt::motion_notify& evt) {
-  if (!m_mutex.try_lock()) {
-    return;
-  }
-
-  std::lock_guard<std::mutex> guard(m_mutex, std::adopt_lock);
+  // Never drop pointer events, the lock is only held while a frame is drawn
+  std::lock_guard<std::mutex> guard(m_mutex);
 
   m_log.trace("bar: Detected motion: %i at pos(%i, %i)", evt->detail, evt->event_x, evt->event_y);
 #if WITH_XCURSOR
   m_motion_pos = evt->event_x;
-  // scroll cursor is less important than click cursor, so we shouldn't return until we are sure there is no click
-  // action
-  bool found_scroll = false;
-  const auto find_click_area = [&](const action& action) {
-    if (!m_opts.cursor_click.empty() &&
-        !(action.button == mousebtn::SCROLL_UP || action.button == mousebtn::SCROLL_DOWN ||
-            action.button == mousebtn::NONE)) {
-      if (!string_util::compare(m_opts.cursor, m_opts.cursor_click)) {
-        m_opts.cursor = m_opts.cursor_click;
-        m_sig.emit(cursor_change{string{m_opts.cursor}});
-      }
-      return true;
-    } else if (!m_opts.cursor_scroll.empty() &&
-               (action.button == mousebtn::SCROLL_UP || action.button == mousebtn::SCROLL_DOWN)) {
-      if (!found_scroll) {
-        found_scroll = true;
-      }
-    }
-    return false;
-  };
 
-  for (auto&& action : m_renderer->actions()) {
-    if (action.test(m_motion_pos)) {
-      m_log.trace("Found matching input area");
-      if (find_click_area(action))
-        return;
-    }
-  }
-  if (found_scroll) {
-    if (!string_util::compare(m_opts.cursor, m_opts.cursor_scroll)) {
-      m_opts.cursor = m_opts.cursor_scroll;
-      m_sig.emit(cursor_change{string{m_opts.cursor}});
-    }
+  // The cursor only depends on the actions under the pointer, so it only
+  // has to be resolved again once the pointer enters another region
+  auto index = m_renderer->actions();
+  auto region = index->find(m_motion_pos);
+  if (index == m_motion_index && region == m_motion_region) {
     return;
   }
-  for (auto&& action : m_opts.actions) {
-    if (!action.command.empty()) {
-      m_log.trace("Found matching fallback handler");
-      if (find_click_area(action))
-        return;
+  m_motion_index = move(index);
+  m_motion_region = region;
+
+  const auto set_cursor = [&](const string& cursor) {
+    if (!string_util::compare(m_opts.cursor, cursor)) {
+      m_opts.cursor = cursor;
+      m_sig.emit(cursor_change{string{m_opts.cursor}});
     }
+  };
+
+  // scroll cursor is less important than click cursor, so we only use it if there is no click action
+  bool found_click = false;
+  bool found_scroll = false;
+
+  if (region != nullptr) {
+    m_log.trace("Found matching input area");
+    found_click = region->click && !m_opts.cursor_click.empty();
+    found_scroll = region->scroll && !m_opts.cursor_scroll.empty();
   }
-  if (found_scroll) {
-    if (!string_util::compare(m_opts.cursor, m_opts.cursor_scroll)) {
-      m_opts.cursor = m_opts.cursor_scroll;
-      m_sig.emit(cursor_change{string{m_opts.cursor}});
+  if (!found_click && !found_scroll) {
+    for (auto&& action : m_opts.actions) {
+      if (!action.command.empty()) {
+        m_log.trace("Found matching fallback handler");
+        if (action.button == mousebtn::SCROLL_UP || action.button == mousebtn::SCROLL_DOWN) {
+          found_scroll |= !m_opts.cursor_scroll.empty();
+        } else if (action.button != mousebtn::NONE) {
+          found_click |= !m_opts.cursor_click.empty();
+        }
+      }
     }
-    return;
   }
-  if (!string_util::compare(m_opts.cursor, "default")) {
+
+  if (found_click) {
+    set_cursor(m_opts.cursor_click);
+  } else if (found_scroll) {
+    set_cursor(m_opts.cursor_scroll);
+  } else {
     m_log.trace("No matching cursor area found");
-    m_opts.cursor = "default";
-    m_sig.emit(cursor_change{string{m_opts.cursor}});
-    return;
+    set_cursor("default");
   }
 #endif
 }
@@ -720,11 +777,8 @@ void bar::handle(const evt::motion_notify& evt) {
  * Used to map mouse clicks to bar actions
  */
 void bar::handle(const evt::button_press& evt) {
-  if (!m_mutex.try_lock()) {
-    return;
-  }
-
-  std::lock_guard<std::mutex> guard(m_mutex, std::adopt_lock);
+  // Never drop pointer events, the lock is only held while a frame is drawn
+  std::lock_guard<std::mutex> guard(m_mutex);
 
   if (m_buttonpress.deny(evt->time)) {
     return m_log.trace_x("bar: Ignoring button press (throttled)...");
@@ -737,17 +791,14 @@ void bar::handle(const evt::button_press& evt) {
 
   const auto deferred_fn = [&](size_t) {
     /*
-     * Iterate over all defined actions in reverse order until matching action is found
-     * To properly handle nested actions we iterate in reverse because nested actions are added later than their
-     * surrounding action block
+     * The index returns the innermost matching action, nested actions take
+     * precedence over their surrounding action block
      */
-    auto actions = m_renderer->actions();
-    for (auto action = actions.rbegin(); action != actions.rend(); action++) {
-      if (action->button == m_buttonpress_btn && !action->active && action->test(m_buttonpress_pos)) {
-        m_log.trace("Found matching input area");
-        m_sig.emit(button_press{string{action->command}});
-        return;
-      }
+    auto index = m_renderer->actions();
+    if (auto action = index->find(m_buttonpress_btn, m_buttonpress_pos)) {
+      m_log.trace("Found matching input area");
+      m_sig.emit(button_press{string{action->command}});
+      return;
     }
 
     for (auto&& action : m_opts.actions) {
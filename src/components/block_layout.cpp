@@ -0,0 +1,91 @@
+#include "components/block_layout.hpp"
+
+#include <algorithm>
+
+POLYBAR_NS
+
+constexpr double block_layout::GAP;
+
+namespace {
+  double to_pixel(double value) {
+    return static_cast<int>(value + 0.5);
+  }
+
+  void place(block_layout::placement& p, double canvas_width, double x) {
+    p.x = to_pixel(x);
+    p.visible = std::max(0.0, std::min(to_pixel(p.width), canvas_width - p.x));
+  }
+}
+
+/**
+ * Position the blocks for the given canvas and measured widths
+ *
+ * The left block always starts at the left edge. The center block is put
+ * between the left and the right block, or at the center of the bar with
+ * fixed-center, but never overlaps the left block. The right block is
+ * aligned to the right edge unless it is pushed further by the blocks in
+ * front of it, anything pushed past the canvas is cut off.
+ *
+ * bar_center is the middle of the whole bar relative to the left side of
+ * the bar contents, it is only used with fixed_center.
+ */
+block_layout::block_layout(
+    double canvas_width, double left, double center, double right, bool fixed_center, double bar_center) {
+  m_left.width = left;
+  m_center.width = center;
+  m_right.width = right;
+
+  // The leftmost x position the center block can start at
+  double min_pos = left;
+  if (left != 0.0) {
+    min_pos += GAP;
+  }
+
+  // The rightmost x position the center block can end at
+  double max_pos = canvas_width - right;
+  if (right != 0.0) {
+    max_pos -= GAP;
+  }
+
+  /*
+   * x position of the center of the center block
+   *
+   * With fixed-center this will be the center of the bar unless it is pushed to the left by a large right block
+   * Without fixed-center this will be the middle between the end of the left and the start of the right block.
+   */
+  double base_pos{(min_pos + max_pos) / 2.0};
+  if (fixed_center) {
+    base_pos = std::min(bar_center, max_pos - center / 2.0);
+  }
+
+  place(m_left, canvas_width, 0.0);
+  // The left block always has priority (even with fixed-center)
+  place(m_center, canvas_width, std::max(base_pos - center / 2.0, min_pos));
+
+  // The block immediately to the left of the right block
+  double barrier{0.0};
+  if (center != 0.0) {
+    barrier = m_center.x + center + GAP;
+  } else if (left != 0.0) {
+    barrier = left + GAP;
+  }
+  place(m_right, canvas_width, std::max(canvas_width - right, barrier));
+}
+
+/**
+ * Get the placement of the block with the given alignment
+ */
+const block_layout::placement& block_layout::get(alignment a) const {
+  switch (a) {
+    case alignment::LEFT:
+      return m_left;
+    case alignment::CENTER:
+      return m_center;
+    case alignment::RIGHT:
+      return m_right;
+    default:
+      return m_none;
+  }
+}
+
+POLYBAR_NS_END
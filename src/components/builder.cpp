@@ -9,14 +9,9 @@
 POLYBAR_NS
 
 builder::builder(const bar_settings& bar) : m_bar(bar) {
-  reset();
-}
-
-void builder::reset() {
   /* Add all values as keys so that we never have to check if a key exists in
    * the map
    */
-  m_tags.clear();
   m_tags[syntaxtag::NONE] = 0;
   m_tags[syntaxtag::A] = 0;
   m_tags[syntaxtag::B] = 0;
@@ -27,17 +22,35 @@ void builder::reset() {
   m_tags[syntaxtag::u] = 0;
   m_tags[syntaxtag::P] = 0;
 
-  m_colors.clear();
   m_colors[syntaxtag::B] = string();
   m_colors[syntaxtag::F] = string();
   m_colors[syntaxtag::o] = string();
   m_colors[syntaxtag::u] = string();
 
-  m_attrs.clear();
   m_attrs[attribute::NONE] = false;
   m_attrs[attribute::UNDERLINE] = false;
   m_attrs[attribute::OVERLINE] = false;
 
+  reset();
+}
+
+/**
+ * Reset the builder state
+ *
+ * The keys of the maps are fixed, only the values are reset so
+ * that no nodes are reallocated. The output buffer keeps its capacity.
+ */
+void builder::reset() {
+  for (auto&& tag : m_tags) {
+    tag.second = 0;
+  }
+  for (auto&& color : m_colors) {
+    color.second.clear();
+  }
+  for (auto&& attr : m_attrs) {
+    attr.second = false;
+  }
+
   m_output.clear();
   m_fontindex = 1;
 }
@@ -46,8 +59,35 @@ void builder::reset() {
  * Flush contents of the builder and return built string
  *
  * This will also close any unclosed tags
+ *
+ * The result is copied out, the internal buffer is only cleared and keeps
+ * its capacity for the next run.
  */
 string builder::flush() {
+  close_tags();
+
+  string output{m_output};
+  reset();
+
+  return output;
+}
+
+/**
+ * Flush contents of the builder by appending them to the given string
+ *
+ * Appends to a buffer owned by the caller, so nothing is allocated once
+ * both buffers are large enough
+ */
+void builder::flush(string& output) {
+  close_tags();
+  output += m_output;
+  reset();
+}
+
+/**
+ * Insert closing tags for all open tags
+ */
+void builder::close_tags() {
   if (m_tags[syntaxtag::B]) {
     background_close();
   }
@@ -73,20 +113,13 @@ string builder::flush() {
   while (m_tags[syntaxtag::A]) {
     cmd_close();
   }
-
-  string output{m_output};
-
-  reset();
-
-  return output;
 }
 
 /**
  * Insert raw text string
  */
-void builder::append(string text) {
-  m_output.reserve(text.size());
-  m_output += move(text);
+void builder::append(const string& text) {
+  m_output += text;
 }
 
 /**
@@ -94,12 +127,12 @@ void builder::append(string text) {
  *
  * This will also parse raw syntax tags
  */
-void builder::node(string str) {
+void builder::node(const string& str) {
   if (str.empty()) {
     return;
   }
 
-  append(move(str));
+  append(str);
 }
 
 /**
@@ -107,9 +140,9 @@ void builder::node(string str) {
  *
  * \see builder::node
  */
-void builder::node(string str, int font_index) {
+void builder::node(const string& str, int font_index) {
   font(font_index);
-  node(move(str));
+  node(str);
   font_close();
 }
 
@@ -174,12 +207,13 @@ void builder::node(const label_t& label) {
  * Repeat text string n times
  */
 void builder::node_repeat(const string& str, size_t n) {
-  string text;
-  text.reserve(str.size() * n);
+  if (str.empty()) {
+    return;
+  }
+  m_output.reserve(m_output.size() + str.size() * n);
   while (n--) {
-    text += str;
+    m_output += str;
   }
-  node(text);
 }
 
 /**
@@ -430,18 +464,30 @@ void builder::control(controltag tag) {
 
 /**
  * Open command tag
+ *
+ * The colons in the command are escaped while it is appended, so that
+ * no temporary strings are built
  */
-void builder::cmd(mousebtn index, string action) {
+void builder::cmd(mousebtn index, const string& action) {
   if (!action.empty()) {
-    action = string_util::replace_all(action, ":", "\\:");
-    tag_open(syntaxtag::A, to_string(static_cast<int>(index)) + ":" + action + ":");
+    m_tags[syntaxtag::A]++;
+    m_output += "%{A";
+    m_output += to_string(static_cast<int>(index));
+    m_output += ':';
+    for (auto c : action) {
+      if (c == ':') {
+        m_output += '\\';
+      }
+      m_output += c;
+    }
+    m_output += ":}";
   }
 }
 
 /**
  * Wrap label in command block
  */
-void builder::cmd(mousebtn index, string action, const label_t& label) {
+void builder::cmd(mousebtn index, const string& action, const label_t& label) {
   if (label && *label) {
     cmd(index, action);
     node(label);
@@ -478,41 +524,48 @@ string builder::foreground_hex() {
 
 /**
  * Insert directive to change value of given tag
+ *
+ * The directive is appended piece by piece instead of being built first
  */
 void builder::tag_open(syntaxtag tag, const string& value) {
   m_tags[tag]++;
 
+  const char* prefix{nullptr};
   switch (tag) {
     case syntaxtag::NONE:
-      break;
+      return;
     case syntaxtag::A:
-      append("%{A" + value + "}");
+      prefix = "%{A";
       break;
     case syntaxtag::F:
-      append("%{F" + value + "}");
+      prefix = "%{F";
       break;
     case syntaxtag::B:
-      append("%{B" + value + "}");
+      prefix = "%{B";
       break;
     case syntaxtag::T:
-      append("%{T" + value + "}");
+      prefix = "%{T";
       break;
     case syntaxtag::u:
-      append("%{u" + value + "}");
+      prefix = "%{u";
       break;
     case syntaxtag::o:
-      append("%{o" + value + "}");
+      prefix = "%{o";
       break;
     case syntaxtag::R:
       append("%{R}");
-      break;
+      return;
     case syntaxtag::O:
-      append("%{O" + value + "}");
+      prefix = "%{O";
       break;
     case syntaxtag::P:
-      append("%{P" + value + "}");
+      prefix = "%{P";
       break;
   }
+
+  m_output += prefix;
+  m_output += value;
+  m_output += '}';
 }
 
 /**
@@ -32,14 +32,81 @@ string config::section() const {
 
 string config::get_color(const string& section, const string& key, const string& default_value) const {
   try {
-    string string_value{get<string>(section, key)};
-    return color_util::colorspace_torgb(
-      dereference<string>(move(section), move(key), string_value, string_value));
+    // get() already returns the dereferenced value
+    return color_util::colorspace_torgb(get<string>(section, key));
   } catch (const key_error& err) {
     return default_value;
   }
 }
 
+/**
+ * Apply the modifiers of a ${color:...} reference to the given color
+ *
+ * Derived colors tend to be repeated across a config (the same shade of the
+ * foreground in every module), so results are memoized for the lifetime
+ * of the config
+ */
+string config::derive_color(const string& color, const string& modifiers, const string& key_path) const {
+  string memo_key{color + ":" + modifiers};
+  auto it = m_derived_colors.find(memo_key);
+  if (it != m_derived_colors.end()) {
+    return it->second;
+  }
+
+  auto base_color = rgba::get_rgba(color);
+  double3 jab(base_color);
+  colorspaces::rgb_xyz(jab, jab);
+  colorspaces::xyz_jzazbz(jab, jab);
+  colorspaces::ab_ch(jab, jab);
+
+  size_t pos{0};
+  while (pos <= modifiers.size()) {
+    size_t end = modifiers.find(':', pos);
+    if (end == string::npos) {
+      end = modifiers.size();
+    }
+
+    // find the operator of the command
+    size_t op_pos = modifiers.find_first_of("+-*/=", pos);
+    if (op_pos == string::npos || op_pos >= end) {
+      throw value_error("Invalid color reference defined at \"" + key_path + "\"");
+    }
+
+    auto property = string_util::trim(string_util::lower(modifiers.substr(pos, op_pos - pos)));
+    auto amount = std::stod(&modifiers[op_pos + 1]);
+    double* modified;
+    if (property == "lum" || property == "lightness" || property == "luminosity") {
+      modified = &jab.a;
+    } else if (property == "chroma" || property == "sat" || property == "saturation") {
+      modified = &jab.b;
+    } else if (property == "hue") {
+      modified = &jab.c;
+    } else if (property == "alpha" || property == "opacity") {
+      modified = &base_color.a;
+    } else {
+      throw value_error("Invalid color property \"" + property + "\" defined at \"" + key_path + "\"");
+    }
+
+    switch (modifiers[op_pos]) {
+      case '+': *modified += amount; break;
+      case '-': *modified -= amount; break;
+      case '*': *modified *= amount; break;
+      case '/': *modified /= amount; break;
+      case '=': *modified = amount; break;
+      default: throw value_error("Unexpected error, this is a bug, please report!");
+    }
+
+    pos = end + 1;
+  }
+
+  colorspaces::ch_ab(jab, jab);
+  colorspaces::jzazbz_xyz(jab, jab);
+  colorspaces::xyz_rgb(jab, jab);
+  jab.copy_to(base_color);
+
+  return m_derived_colors[memo_key] = color_util::hex<unsigned short int>(base_color);
+}
+
 void config::use_xrm() {
 #if WITH_XRM
   /*
@@ -55,9 +122,136 @@ void config::use_xrm() {
 
 void config::set_sections(sectionmap_t sections) {
   m_sections = move(sections);
+  m_resolved.clear();
   copy_inherited();
 }
 
+/**
+ * Resolve the references (${...}) of all parameters once, so that
+ * reading a value only takes a hash lookup
+ *
+ * Has to be called after all sections are set and xrm is initialized.
+ * Parameters that fail to resolve are left out, reading them takes the slow
+ * path and raises the same error as before.
+ */
+void config::compile() {
+  m_resolved.clear();
+  m_resolved.reserve(m_sections.size());
+  m_dependents.clear();
+
+  for (auto&& section : m_sections) {
+    m_resolved[section.first].reserve(section.second.size());
+
+    for (auto&& param : section.second) {
+      resolve(section.first, param.first);
+
+      string reference{local_reference(section.first, param.second)};
+      if (!reference.empty()) {
+        m_dependents[reference].emplace_back(section.first, param.first);
+      }
+    }
+  }
+}
+
+/**
+ * Set parameter value
+ *
+ * Only the parameter and the ones referencing it are resolved again
+ */
+void config::set(const string& section, const string& key, string&& value) {
+  string reference{local_reference(section, value)};
+  if (!reference.empty()) {
+    m_dependents[reference].emplace_back(section, key);
+  }
+
+  m_sections[section][key] = move(value);
+
+  if (m_resolved.empty()) {
+    return;
+  }
+
+  vector<std::pair<string, string>> pending{{section, key}};
+  vector<string> visited;
+
+  while (!pending.empty()) {
+    auto param = move(pending.back());
+    pending.pop_back();
+
+    string key_path{param.first + "." + param.second};
+    if (find(visited.begin(), visited.end(), key_path) != visited.end()) {
+      continue;
+    }
+    visited.emplace_back(key_path);
+
+    resolve(param.first, param.second);
+
+    auto it = m_dependents.find(key_path);
+    if (it != m_dependents.end()) {
+      pending.insert(pending.end(), it->second.begin(), it->second.end());
+    }
+  }
+}
+
+/**
+ * Store the resolved value of a parameter, or drop it if it does not resolve
+ */
+void config::resolve(const string& section, const string& key) {
+  auto& values = m_resolved[section];
+  values.erase(key);
+
+  const string& value{m_sections.at(section).at(key)};
+  try {
+    values.emplace(key, resolved_value{dereference<string>(section, key, value, value)});
+  } catch (const application_error& err) {
+    m_log.trace("config: Not resolving %s.%s (%s)", section, key, err.what());
+  }
+}
+
+/**
+ * Get the parameter ("section.key") a value directly refers to
+ *
+ * Returns an empty string if the value is not a reference to another parameter.
+ */
+string config::local_reference(const string& section, const string& value) const {
+  if (value.compare(0, 2, "${") != 0 || value.back() != '}') {
+    return "";
+  }
+
+  string path{value.substr(2, value.length() - 3)};
+  if (path.compare(0, 6, "color:") == 0) {
+    // Literal colors don't refer to anything
+    path.erase(0, 6);
+    auto pos = path.find('.');
+    auto pos2 = path.find(':');
+    if (pos == string::npos || (pos2 != string::npos && pos > pos2)) {
+      return "";
+    }
+  } else if (path.compare(0, 4, "env:") == 0 || path.compare(0, 5, "xrdb:") == 0 || path.compare(0, 5, "file:") == 0) {
+    return "";
+  }
+
+  auto pos = path.find('.');
+  if (pos == string::npos) {
+    return "";
+  }
+
+  string ref_section{path.substr(0, pos)};
+  ref_section = string_util::replace(ref_section, "BAR", this->section(), 0, 3);
+  ref_section = string_util::replace(ref_section, "root", this->section(), 0, 4);
+  ref_section = string_util::replace(ref_section, "self", section, 0, 4);
+
+  return ref_section + "." + path.substr(pos + 1, path.find(':', pos) - pos - 1);
+}
+
+config::resolved_value::resolved_value(string&& value)
+    : text(move(value))
+    , integer(std::strtoll(text.c_str(), nullptr, 10))
+    , uinteger(std::strtoull(text.c_str(), nullptr, 10))
+    , real(std::strtod(text.c_str(), nullptr)) {
+  string lower{string_util::lower(text)};
+  flag = lower == "true" || lower == "yes" || lower == "on" || lower == "1";
+}
+
 gradient_t config::get_gradient(const string& name) const {
   auto it = m_gradients.find(name);
   if (it == m_gradients.end()) {
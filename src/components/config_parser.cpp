@@ -1,13 +1,20 @@
 #include "components/config_parser.hpp"
 
 #include <algorithm>
-#include <fstream>
+#include <cstring>
 
 POLYBAR_NS
 
 config_parser::config_parser(const logger& logger, string&& file, string&& bar)
     : m_log(logger), m_config(file_util::expand(file)), m_barname(move(bar)) {}
 
+config_parser::~config_parser() {
+  // Parsing may have failed before all included files were needed
+  if (m_includes) {
+    executor::make().cancel(*m_includes);
+  }
+}
+
 config::make_type config_parser::parse() {
   m_log.notice("Parsing config file: %s", m_config);
 
@@ -35,6 +42,7 @@ config::make_type config_parser::parse() {
   if (use_xrm) {
     m_conf.use_xrm();
   }
+  m_conf.compile();
 
   return result;
 }
@@ -110,54 +118,128 @@ void config_parser::parse_file(const string& file, file_list path) {
 
   path.push_back(file);
 
-  int line_no = 0;
+  const vector<line_t>& lines = get_parsed(file, false).get();
+
+  // Collect the includes first, so that all included files are already being
+  // parsed in the background when we get to them
+  vector<vector<string>> includes;
+  for (const auto& line : lines) {
+    if (is_include(line)) {
+      includes.emplace_back(get_includes(line));
+      for (const auto& included : includes.back()) {
+        get_parsed(included, true);
+      }
+    }
+  }
+
+  auto next_include = includes.begin();
+  for (const auto& line : lines) {
+    if (is_include(line)) {
+      for (const auto& included : *next_include++) {
+        parse_file(included, path);
+      }
+      continue;
+    }
 
-  string line_str{};
+#if WITH_XRM
+    // Use xrm, if at least one value is an xrdb reference
+    if (!use_xrm && !line.is_header && line.value.find("${xrdb") == 0) {
+      use_xrm = true;
+    }
+#endif
 
-  std::ifstream in(file);
+    m_lines.push_back(line);
+    m_lines.back().file_index = file_index;
+  }
+}
 
-  if (!in) {
-    throw application_error("Failed to open config file " + file + ": " + strerror(errno));
+vector<line_t> config_parser::parse_lines(const string& file) const {
+  unique_ptr<mapped_file> contents;
+  try {
+    contents = make_unique<mapped_file>(file);
+  } catch (const system_error& err) {
+    throw application_error("Failed to open config file " + file + ": " + strerror(err.code));
   }
 
-  while (std::getline(in, line_str)) {
+  vector<line_t> lines;
+
+  const char* pos = contents->data();
+  const char* end = pos + contents->size();
+  int line_no = 0;
+
+  while (pos < end) {
+    const char* eol = static_cast<const char*>(memchr(pos, '\n', end - pos));
+    if (eol == nullptr) {
+      eol = end;
+    }
+
     line_no++;
     line_t line;
     try {
-      line = parse_line(line_str);
-
-      // parse_line doesn't set these
-      line.file_index = file_index;
+      line = parse_line(string{pos, eol});
       line.line_no = line_no;
     } catch (syntax_error& err) {
       /*
        * Exceptions thrown by parse_line doesn't have the line
        * numbers and files set, so we have to add them here
        */
-      throw syntax_error(err.get_msg(), m_files[file_index], line_no);
+      throw syntax_error(err.get_msg(), file, line_no);
     }
 
     // Skip useless lines (comments, empty lines)
-    if (!line.useful) {
-      continue;
+    if (line.useful) {
+      lines.emplace_back(move(line));
     }
 
-    if (!line.is_header && line.key == "include-file") {
-      parse_file(file_util::expand(line.value), path);
-    } else if (!line.is_header && line.key == "include-directory") {
-      const string expanded_path = file_util::expand(line.value);
-      vector<string> file_list = file_util::list_files(expanded_path);
-      sort(file_list.begin(), file_list.end());
-      for (const auto& filename : file_list) {
-        parse_file(expanded_path + "/" + filename, path);
-      }
-    } else {
-      m_lines.push_back(line);
-    }
+    pos = eol + 1;
+  }
+
+  return lines;
+}
+
+const std::shared_future<vector<line_t>>& config_parser::get_parsed(const string& file, bool background) {
+  auto it = m_parsed.find(file);
+  if (it != m_parsed.end()) {
+    return it->second;
+  }
+
+  if (!background) {
+    return m_parsed.emplace(file, std::async(std::launch::deferred, &config_parser::parse_lines, this, file).share())
+        .first->second;
+  }
+
+  // The executor has a fixed number of workers, no matter how many files are included
+  if (!m_includes) {
+    m_includes = make_unique<executor::group>("config_parser/includes", executor::pool::CPU);
   }
+  auto task = make_shared<std::packaged_task<vector<line_t>()>>([this, file] { return parse_lines(file); });
+  it = m_parsed.emplace(file, task->get_future().share()).first;
+  executor::make().post(*m_includes, [task] { (*task)(); });
+  return it->second;
 }
 
-line_t config_parser::parse_line(const string& line) {
+bool config_parser::is_include(const line_t& line) {
+  return !line.is_header && (line.key == "include-file" || line.key == "include-directory");
+}
+
+vector<string> config_parser::get_includes(const line_t& line) {
+  if (line.key == "include-file") {
+    return {file_util::expand(line.value)};
+  }
+
+  const string expanded_path = file_util::expand(line.value);
+  vector<string> file_list = file_util::list_files(expanded_path);
+  sort(file_list.begin(), file_list.end());
+
+  vector<string> files;
+  files.reserve(file_list.size());
+  for (const auto& filename : file_list) {
+    files.emplace_back(expanded_path + "/" + filename);
+  }
+  return files;
+}
+
+line_t config_parser::parse_line(const string& line) const {
   if (string_util::contains(line, "\ufeff")) {
     throw syntax_error(
         "This config file uses UTF-8 with BOM, which is not supported. Please use plain UTF-8 without BOM.");
@@ -215,7 +297,7 @@ line_type config_parser::get_line_type(const string& line) {
   }
 }
 
-string config_parser::parse_header(const string& line) {
+string config_parser::parse_header(const string& line) const {
   if (line.back() != ']') {
     throw syntax_error("Missing ']' in header '" + line + "'");
   }
@@ -234,7 +316,7 @@ string config_parser::parse_header(const string& line) {
   return header;
 }
 
-std::pair<string, string> config_parser::parse_key(const string& line) {
+std::pair<string, string> config_parser::parse_key(const string& line) const {
   size_t pos = line.find_first_of('=');
 
   string key = string_util::trim(line.substr(0, pos), isspace);
@@ -254,17 +336,10 @@ std::pair<string, string> config_parser::parse_key(const string& line) {
 
   // TODO check value for references
 
-#if WITH_XRM
-  // Use xrm, if at least one value is an xrdb reference
-  if (!use_xrm && value.find("${xrdb") == 0) {
-    use_xrm = true;
-  }
-#endif
-
   return {move(key), move(value)};
 }
 
-bool config_parser::is_valid_name(const string& name) {
+bool config_parser::is_valid_name(const string& name) const {
   if (name.empty()) {
     return false;
   }
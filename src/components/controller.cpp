@@ -1,5 +1,7 @@
 #include "components/controller.hpp"
 
+#include <sys/eventfd.h>
+
 #include <csignal>
 
 #include "components/bar.hpp"
@@ -7,25 +9,30 @@
 #include "components/config.hpp"
 #include "components/ipc.hpp"
 #include "components/logger.hpp"
+#include "components/taskqueue.hpp"
 #include "components/types.hpp"
 #include "events/signal.hpp"
 #include "events/signal_emitter.hpp"
 #include "modules/meta/event_handler.hpp"
 #include "modules/meta/factory.hpp"
-#include "utils/command.hpp"
 #include "utils/factory.hpp"
 #include "utils/inotify.hpp"
+#include "utils/process.hpp"
 #include "utils/string.hpp"
 #include "utils/time.hpp"
+#include "utils/trace.hpp"
 #include "x11/connection.hpp"
 #include "x11/extensions/all.hpp"
 
 POLYBAR_NS
 
-array<int, 2> g_eventpipe{{-1, -1}};
+int g_eventfd{-1};
 sig_atomic_t g_reload{0};
 sig_atomic_t g_terminate{0};
 
+// How often running shell commands are checked for having exited
+static constexpr chrono::milliseconds COMMAND_POLL_INTERVAL{250};
+
 void interrupt_handler(int signum) {
   if (g_reload || g_terminate) {
     return;
@@ -33,8 +40,9 @@ void interrupt_handler(int signum) {
 
   g_terminate = 1;
   g_reload = (signum == SIGUSR1);
-  if (write(g_eventpipe[PIPE_WRITE], &g_terminate, 1) == -1) {
-    throw system_error("Failed to write to eventpipe");
+  uint64_t wake{1};
+  if (write(g_eventfd, &wake, sizeof(wake)) == -1) {
+    throw system_error("Failed to write to eventfd");
   }
 }
 
@@ -66,11 +74,10 @@ controller::controller(connection& conn, signal_emitter& emitter, const logger&
   m_swallow_limit = m_conf.deprecated("settings", "eventqueue-swallow", "throttle-output", m_swallow_limit);
   m_swallow_update = m_conf.deprecated("settings", "eventqueue-swallow-time", "throttle-output-for", m_swallow_update);
 
-  if (pipe(g_eventpipe.data()) == 0) {
-    m_queuefd[PIPE_READ] = make_unique<file_descriptor>(g_eventpipe[PIPE_READ]);
-    m_queuefd[PIPE_WRITE] = make_unique<file_descriptor>(g_eventpipe[PIPE_WRITE]);
+  if ((g_eventfd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)) != -1) {
+    m_eventfd = make_unique<file_descriptor>(g_eventfd);
   } else {
-    throw system_error("Failed to create event channel pipes");
+    throw system_error("Failed to create eventfd");
   }
 
   m_log.trace("controller: Install signal handler");
@@ -168,15 +175,16 @@ bool controller::run(bool writeback, string snapshot_dst) {
   }
 
   m_connection.flush();
-  m_event_thread = thread(&controller::process_eventqueue, this);
-
-  read_events();
 
-  if (m_event_thread.joinable()) {
-    enqueue(make_quit_evt(static_cast<bool>(g_reload)));
-    m_event_thread.join();
+  if (!m_writeback) {
+    m_sig.emit(signals::eventqueue::start{});
+  } else {
+    // bypass the start eventqueue signal
+    m_sig.emit(signals::ui::ready{});
   }
 
+  read_events();
+
   m_log.notice("Termination signal received, shutting down...");
 
   return !g_reload;
@@ -184,18 +192,30 @@ bool controller::run(bool writeback, string snapshot_dst) {
 
 /**
  * Enqueue event
+ *
+ * Updates only set a flag, since any number of them result in a single
+ * redraw. All other events go through the queue, or the overflow list
+ * once the queue is full, so that they are never lost.
  */
 bool controller::enqueue(event&& evt) {
   if (!m_process_events && evt.type != event_type::QUIT) {
     return false;
   }
-  if (!m_queue.enqueue(forward<decltype(evt)>(evt))) {
-    m_log.warn("Failed to enqueue event");
-    return false;
+  if (evt.type == event_type::UPDATE) {
+    if (evt.flag) {
+      m_force_queued = true;
+    }
+    m_update_queued = true;
+  } else if (m_overflowed || !m_queue.push(evt)) {
+    // Once events overflowed, keep adding to the list to preserve their order
+    std::lock_guard<std::mutex> guard(m_overflowlock);
+    m_overflow.emplace_back(evt);
+    m_overflowed = true;
+  }
+  uint64_t wake{1};
+  if (write(static_cast<int>(*m_eventfd), &wake, sizeof(wake)) == -1) {
+    m_log.err("Failed to write to eventfd (reason: %s)", strerror(errno));
   }
-  // if (write(g_eventpipe[PIPE_WRITE], " ", 1) == -1) {
-  //   m_log.err("Failed to write to eventpipe (reason: %s)", strerror(errno));
-  // }
   return true;
 }
 
@@ -220,11 +240,14 @@ void controller::read_events() {
 
   int fd_connection{-1};
   int fd_confwatch{-1};
-  int fd_ipc{-1};
+  int fd_tasks{-1};
+  vector<int> fds_ipc;
+  vector<int> fds_ipc_out;
 
   vector<int> fds;
-  fds.emplace_back(*m_queuefd[PIPE_READ]);
+  fds.emplace_back(*m_eventfd);
   fds.emplace_back((fd_connection = m_connection.get_file_descriptor()));
+  fds.emplace_back((fd_tasks = m_bar->tasks().get_file_descriptor()));
 
   if (m_confwatch) {
     m_log.trace("controller: Attach config watch");
@@ -233,12 +256,15 @@ void controller::read_events() {
   }
 
   if (m_ipc) {
-    fds.emplace_back((fd_ipc = m_ipc->get_file_descriptor()));
+    fds_ipc = m_ipc->get_file_descriptors();
+    fds.insert(fds.end(), fds_ipc.begin(), fds_ipc.end());
   }
 
   while (!g_terminate) {
     fd_set readfds{};
     FD_ZERO(&readfds);
+    fd_set writefds{};
+    FD_ZERO(&writefds);
 
     int maxfd{0};
     for (auto&& fd : fds) {
@@ -246,8 +272,30 @@ void controller::read_events() {
       maxfd = std::max(maxfd, fd);
     }
 
-    // Wait until event is ready on one of the configured streams
-    int events = select(maxfd + 1, &readfds, nullptr, nullptr, nullptr);
+    // Ipc clients that did not take all of their responses yet
+    for (auto&& fd : fds_ipc_out) {
+      FD_SET(fd, &writefds);
+      maxfd = std::max(maxfd, fd);
+    }
+
+    // Wait until event is ready on one of the configured streams,
+    // until a pending update has to be drawn or, while shell commands
+    // are running, until it is time to check whether they exited
+    timeval timeout{};
+    timeval* timeout_ptr{nullptr};
+    if (m_update_pending || !m_commands.empty()) {
+      chrono::steady_clock::duration remaining{COMMAND_POLL_INTERVAL};
+      if (m_update_pending) {
+        remaining = std::min(remaining, m_update_deadline - chrono::steady_clock::now());
+      }
+      remaining = std::max(remaining, chrono::steady_clock::duration{0});
+      auto usec = chrono::duration_cast<chrono::microseconds>(remaining).count();
+      timeout.tv_sec = usec / 1000000;
+      timeout.tv_usec = usec % 1000000;
+      timeout_ptr = &timeout;
+    }
+
+    int events = select(maxfd + 1, &readfds, &writefds, nullptr, timeout_ptr);
 
     // Check for errors
     if (events == -1) {
@@ -266,12 +314,17 @@ void controller::read_events() {
       break;
     }
 
-    // Process event on the internal fd
-    if (m_queuefd[PIPE_READ] && FD_ISSET(static_cast<int>(*m_queuefd[PIPE_READ]), &readfds)) {
-      char buffer[BUFSIZ];
-      if (read(static_cast<int>(*m_queuefd[PIPE_READ]), &buffer, BUFSIZ) == -1) {
-        m_log.err("Failed to read from eventpipe (err: %s)", strerror(errno));
+    if (!m_commands.empty()) {
+      reap_commands();
+    }
+
+    // Process events posted by modules and other threads
+    if (FD_ISSET(static_cast<int>(*m_eventfd), &readfds)) {
+      uint64_t count;
+      if (read(static_cast<int>(*m_eventfd), &count, sizeof(count)) == -1 && errno != EAGAIN) {
+        m_log.err("Failed to read from eventfd (err: %s)", strerror(errno));
       }
+      process_eventqueue();
     }
 
     // Process event on the config inotify watch fd
@@ -311,78 +364,125 @@ void controller::read_events() {
       }
     }
 
-    // Process event on the ipc fd
-    if (fd_ipc > -1 && FD_ISSET(fd_ipc, &readfds)) {
-      m_ipc->receive_message();
-      fds.erase(std::remove_if(fds.begin(), fds.end(), [fd_ipc](int fd) { return fd == fd_ipc; }), fds.end());
-      fds.emplace_back((fd_ipc = m_ipc->get_file_descriptor()));
+    // Run deferred ui tasks that are due
+    if (fd_tasks > -1 && FD_ISSET(fd_tasks, &readfds)) {
+      try {
+        m_bar->tasks().process();
+      } catch (const exception& err) {
+        m_log.err("Error in deferred task: %s", err.what());
+      }
+    }
+
+    // Process events on the ipc channel, socket and client connections
+    if (!fds_ipc.empty()) {
+      bool activity{false};
+      for (auto&& fd : fds_ipc_out) {
+        if (FD_ISSET(fd, &writefds)) {
+          m_ipc->send_pending(fd);
+          activity = true;
+        }
+      }
+      for (auto&& fd : fds_ipc) {
+        if (FD_ISSET(fd, &readfds)) {
+          m_ipc->receive_message(fd);
+          activity = true;
+        }
+      }
+
+      // Clients may have connected, disconnected or be waiting for responses
+      if (activity) {
+        fds.erase(std::remove_if(fds.begin(), fds.end(),
+                      [&](int fd) { return std::find(fds_ipc.begin(), fds_ipc.end(), fd) != fds_ipc.end(); }),
+            fds.end());
+        fds_ipc = m_ipc->get_file_descriptors();
+        fds_ipc_out = m_ipc->get_pending_writes();
+        fds.insert(fds.end(), fds_ipc.begin(), fds_ipc.end());
+      }
+    }
+
+    // Draw the swallowed updates once no more arrived in time
+    if (m_update_pending && chrono::steady_clock::now() >= m_update_deadline) {
+      m_update_pending = false;
+      process_update(false);
     }
   }
 }
 
 /**
- * Eventqueue worker loop
+ * Process all queued events
+ *
+ * Consecutive updates are swallowed: a normal update is only drawn once
+ * no other update arrived for the configured time (up to a limit of
+ * swallowed events), all forced updates in the queue are drawn at once.
  */
 void controller::process_eventqueue() {
-  m_log.info("Eventqueue worker (thread-id=%lu)", this_thread::get_id());
-  if (!m_writeback) {
-    m_sig.emit(signals::eventqueue::start{});
-  } else {
-    // bypass the start eventqueue signal
-    m_sig.emit(signals::ui::ready{});
-  }
+  bool force{false};
+  event evt{};
 
-  while (!g_terminate) {
-    event evt{};
-    m_queue.wait_dequeue(evt);
+  while (!g_terminate && m_queue.pop(evt)) {
+    process_event(evt, force);
+  }
 
-    if (g_terminate) {
-      break;
-    } else if (evt.type == event_type::QUIT) {
-      if (evt.flag) {
-        on(signals::eventqueue::exit_reload{});
-      } else {
-        on(signals::eventqueue::exit_terminate{});
+  if (m_overflowed) {
+    std::deque<event> overflow;
+    {
+      std::lock_guard<std::mutex> guard(m_overflowlock);
+      // Events that were queued before the overflow come first
+      while (m_queue.pop(evt)) {
+        overflow.emplace_back(evt);
       }
-    } else if (evt.type == event_type::INPUT) {
-      process_inputdata();
-    } else if (evt.type == event_type::UPDATE && evt.flag) {
-      process_update(true);
-    } else {
-      event next{};
-      size_t swallowed{0};
-      while (swallowed++ < m_swallow_limit && m_queue.wait_dequeue_timed(next, m_swallow_update)) {
-        if (next.type == event_type::QUIT) {
-          evt = next;
-          break;
-        } else if (next.type == event_type::INPUT) {
-          evt = next;
-          break;
-        } else if (evt.type != next.type) {
-          enqueue(move(next));
-          break;
-        } else {
-          m_log.trace_x("controller: Swallowing event within timeframe");
-          evt = next;
-        }
+      overflow.insert(overflow.end(), m_overflow.begin(), m_overflow.end());
+      m_overflow.clear();
+      m_overflowed = false;
+    }
+    for (auto&& e : overflow) {
+      if (g_terminate) {
+        break;
       }
+      process_event(e, force);
+    }
+  }
 
-      if (evt.type == event_type::UPDATE) {
-        process_update(evt.flag);
-      } else if (evt.type == event_type::INPUT) {
-        process_inputdata();
-      } else if (evt.type == event_type::QUIT) {
-        if (evt.flag) {
-          on(signals::eventqueue::exit_reload{});
-        } else {
-          on(signals::eventqueue::exit_terminate{});
-        }
-      } else if (evt.type == event_type::CHECK) {
-        on(signals::eventqueue::check_state{});
-      } else {
-        m_log.warn("Unknown event type for enqueued event (%d)", evt.type);
-      }
+  if (m_update_queued.exchange(false)) {
+    process_event(make_update_evt(m_force_queued.exchange(false)), force);
+  }
+
+  if (force && !g_terminate) {
+    m_update_pending = false;
+    process_update(true);
+  }
+}
+
+/**
+ * Handle a single queued event
+ *
+ * Forced updates are only recorded in force, the caller draws them once
+ */
+void controller::process_event(const event& evt, bool& force) {
+  if (evt.type == event_type::QUIT) {
+    if (evt.flag) {
+      on(signals::eventqueue::exit_reload{});
+    } else {
+      on(signals::eventqueue::exit_terminate{});
     }
+  } else if (evt.type == event_type::INPUT) {
+    process_inputdata();
+  } else if (evt.type == event_type::UPDATE && evt.flag) {
+    force = true;
+  } else if (evt.type == event_type::UPDATE) {
+    auto now = chrono::steady_clock::now();
+    if (!m_update_pending) {
+      m_update_pending = true;
+      m_swallowed = 0;
+      m_update_deadline = now + m_swallow_update;
+    } else if (m_swallowed++ < m_swallow_limit) {
+      m_log.trace_x("controller: Swallowing event within timeframe");
+      m_update_deadline = now + m_swallow_update;
+    }
+  } else if (evt.type == event_type::CHECK) {
+    on(signals::eventqueue::check_state{});
+  } else {
+    m_log.warn("Unknown event type for enqueued event (%d)", evt.type);
   }
 }
 
@@ -394,28 +494,49 @@ void controller::process_inputdata() {
     string cmd = m_inputdata;
     m_inputdata.clear();
 
-    for (auto&& handler : m_inputhandlers) {
-      if (handler->input(string{cmd})) {
-        return;
-      }
+    string result;
+    process_input(cmd, result);
+  }
+}
+
+/**
+ * Pass input to the module that handles it or, if there is none, run it as shell command
+ *
+ * \returns false if the input could not be handled, result describes what happened
+ */
+bool controller::process_input(const string& cmd, string& result) {
+  for (auto&& handler : m_inputhandlers) {
+    if (handler->input(string{cmd})) {
+      return true;
     }
+  }
 
-    try {
-      m_log.info("Uncaught input event, forwarding to shell... (input: %s)", cmd);
+  m_log.info("Uncaught input event, forwarding to shell... (input: %s)", cmd);
 
-      if (m_command) {
-        m_log.warn("Terminating previous shell command");
-        m_command->terminate();
-      }
+  try {
+    // Commands may open long running applications, they are reaped by the event loop
+    m_log.info("Executing shell command: %s", cmd);
+    m_commands.emplace_back(process_util::spawn_sh(cmd));
+    result = "started shell command (pid " + to_string(m_commands.back()) + ")";
+    return true;
+  } catch (const application_error& err) {
+    m_log.err("controller: Error while forwarding input to shell -> %s", err.what());
+    result = err.what();
+    return false;
+  }
+}
 
-      m_log.info("Executing shell command: %s", cmd);
-      m_command = command_util::make_command<output_policy::IGNORED>(move(cmd));
-      m_command->exec();
-      m_command.reset();
-      process_update(true);
-    } catch (const application_error& err) {
-      m_log.err("controller: Error while forwarding input to shell -> %s", err.what());
-    }
+/**
+ * Reap the shell commands that have exited and update the bar if there were any
+ */
+void controller::reap_commands() {
+  int status;
+  auto exited = std::remove_if(m_commands.begin(), m_commands.end(),
+      [&](pid_t pid) { return process_util::wait_for_completion_nohang(pid, &status) != 0; });
+
+  if (exited != m_commands.end()) {
+    m_commands.erase(exited, m_commands.end());
+    process_update(true);
   }
 }
 
@@ -423,6 +544,8 @@ void controller::process_inputdata() {
  * Process eventqueue update event
  */
 bool controller::process_update(bool force) {
+  TRACE_SCOPE("controller::process_update");
+
   const bar_settings& bar{m_bar->settings()};
   string contents;
   string padding_left(bar.padding.left, ' ');
@@ -659,27 +782,34 @@ bool controller::on(const signals::ui::button_press& evt) {
 
 /**
  * Process ipc action messages
+ *
+ * The action is run right away, so that the client learns whether it worked
  */
 bool controller::on(const signals::ipc::action& evt) {
-  string action{evt.cast()};
+  const ipc_request& request{evt.cast()};
 
-  if (action.empty()) {
-    m_log.err("Cannot enqueue empty ipc action");
+  if (request.payload.empty()) {
+    m_log.err("Cannot process empty ipc action");
+    request.result = "empty action";
+    return false;
+  } else if (!m_process_events) {
+    request.result = "bar is not ready";
     return false;
   }
 
-  m_log.info("Enqueuing ipc action: %s", action);
-  enqueue(move(action));
-  return true;
+  m_log.info("Processing ipc action: %s", request.payload);
+  return process_input(request.payload, request.result);
 }
 
 /**
  * Process ipc command messages
  */
 bool controller::on(const signals::ipc::command& evt) {
-  string command{evt.cast()};
+  const ipc_request& request{evt.cast()};
+  const string& command{request.payload};
 
   if (command.empty()) {
+    request.result = "empty command";
     return false;
   }
 
@@ -695,6 +825,8 @@ bool controller::on(const signals::ipc::command& evt) {
     m_bar->toggle();
   } else {
     m_log.warn("\"%s\" is not a valid ipc command", command);
+    request.result = "\"" + command + "\" is not a valid command";
+    return false;
   }
 
   return true;
@@ -702,21 +834,35 @@ bool controller::on(const signals::ipc::command& evt) {
 
 /**
  * Process ipc hook messages
+ *
+ * Hook commands run to completion, failures are reported to the client
  */
 bool controller::on(const signals::ipc::hook& evt) {
-  string hook{evt.cast()};
+  const ipc_request& request{evt.cast()};
+  bool matched{false};
+  bool success{true};
 
   for (const auto& module : m_modules) {
     if (!module->running()) {
       continue;
     }
     auto ipc = std::dynamic_pointer_cast<ipc_module>(module);
-    if (ipc != nullptr) {
-      ipc->on_message(hook);
+    string result;
+    if (ipc != nullptr && ipc->on_message(request.payload, result)) {
+      matched = true;
+    }
+    if (!result.empty()) {
+      request.result += (request.result.empty() ? "" : ", ") + result;
+      success = false;
     }
   }
 
-  return true;
+  if (!matched) {
+    request.result = "no hook matches \"" + request.payload + "\"";
+    return false;
+  }
+
+  return success;
 }
 
 bool controller::on(const signals::ui::update_background&) {
@@ -0,0 +1,310 @@
+#include "components/executor.hpp"
+
+#include <algorithm>
+
+#include "components/logger.hpp"
+#include "errors.hpp"
+#include "utils/concurrency.hpp"
+#include "utils/factory.hpp"
+
+POLYBAR_NS
+
+namespace {
+  /**
+   * Number of consecutive updates over budget after
+   * which a group is moved to the blocking pool
+   */
+  constexpr size_t MAX_OVERRUNS{3};
+
+  /**
+   * Upper limit for the number of workers in the CPU pool, module
+   * updates are short and a bar has no use for one thread per core
+   */
+  constexpr unsigned int MAX_CPU_THREADS{4};
+
+  // Pool and queue of the worker running on this thread
+  thread_local const void* current_pool{nullptr};
+  thread_local size_t current_queue{0};
+  // Group of the task running on this thread
+  thread_local const executor::group* current_group{nullptr};
+}
+
+// group {{{
+
+executor::group::group(string name, pool kind, clock::duration budget)
+    : m_name(move(name)), m_budget(budget), m_pool(kind) {}
+
+const string& executor::group::name() const {
+  return m_name;
+}
+
+/**
+ * Whether the group has been moved to the blocking pool
+ * for taking longer than its budget
+ */
+bool executor::group::slow() const {
+  return m_slow;
+}
+
+// }}}
+// worker_pool {{{
+
+executor::worker_pool::worker_pool(executor& parent, string name, size_t threads)
+    : m_parent(parent), m_name(move(name)) {
+  for (size_t i = 0; i < threads; i++) {
+    m_queues.emplace_back(make_unique<queue>());
+  }
+  for (size_t i = 0; i < threads; i++) {
+    m_threads.emplace_back(&worker_pool::work, this, i);
+  }
+}
+
+executor::worker_pool::~worker_pool() {
+  {
+    std::lock_guard<std::mutex> guard(m_lock);
+    m_stopping = true;
+  }
+  m_wake.notify_all();
+
+  for (auto&& t : m_threads) {
+    if (t.joinable()) {
+      t.join();
+    }
+  }
+}
+
+/**
+ * Queue a job, jobs posted from one of our own workers stay on its queue
+ */
+void executor::worker_pool::push(job&& j) {
+  size_t index;
+  {
+    std::lock_guard<std::mutex> guard(m_lock);
+    index = current_pool == this ? current_queue : m_next++ % m_queues.size();
+    m_queued++;
+  }
+  {
+    std::lock_guard<std::mutex> guard(m_queues[index]->lock);
+    m_queues[index]->jobs.emplace_back(move(j));
+  }
+  m_wake.notify_one();
+}
+
+/**
+ * Take the newest job of our own queue, or steal the oldest job of another one
+ */
+bool executor::worker_pool::take(size_t index, job& j) {
+  {
+    auto& own = *m_queues[index];
+    std::lock_guard<std::mutex> guard(own.lock);
+    if (!own.jobs.empty()) {
+      j = move(own.jobs.back());
+      own.jobs.pop_back();
+      return true;
+    }
+  }
+
+  for (size_t i = 1; i < m_queues.size(); i++) {
+    auto& other = *m_queues[(index + i) % m_queues.size()];
+    std::lock_guard<std::mutex> guard(other.lock);
+    if (!other.jobs.empty()) {
+      j = move(other.jobs.front());
+      other.jobs.pop_front();
+      return true;
+    }
+  }
+
+  return false;
+}
+
+void executor::worker_pool::work(size_t index) {
+  m_parent.m_log.trace("executor: Started %s worker %i (thread id = %i)", m_name, index,
+      concurrency_util::thread_id(this_thread::get_id()));
+
+  current_pool = this;
+  current_queue = index;
+
+  while (true) {
+    job j{};
+    if (take(index, j)) {
+      {
+        std::lock_guard<std::mutex> guard(m_lock);
+        m_queued--;
+      }
+      m_parent.run(j);
+      continue;
+    }
+
+    // The job count is raised before the job is queued,
+    // we might get here while it is on its way
+    std::unique_lock<std::mutex> guard(m_lock);
+    m_wake.wait(guard, [&] { return m_stopping || m_queued > 0; });
+    if (m_stopping) {
+      break;
+    }
+  }
+}
+
+// }}}
+// executor {{{
+
+executor::make_type executor::make() {
+  return *factory_util::singleton<executor>(
+      logger::make(), std::max(1U, std::min(MAX_CPU_THREADS, std::thread::hardware_concurrency())), 2);
+}
+
+executor::executor(const logger& logger, size_t threads, size_t io_threads) : m_log(logger) {
+  m_pools[static_cast<int>(pool::CPU)] = make_unique<worker_pool>(*this, "cpu", threads);
+  m_pools[static_cast<int>(pool::IO)] = make_unique<worker_pool>(*this, "io", io_threads);
+  m_timerthread = std::thread(&executor::timer, this);
+}
+
+executor::~executor() {
+  {
+    std::lock_guard<std::mutex> guard(m_timerlock);
+    m_stopping = true;
+  }
+  m_timerwake.notify_all();
+
+  if (m_timerthread.joinable()) {
+    m_timerthread.join();
+  }
+
+  for (auto&& p : m_pools) {
+    p.reset();
+  }
+}
+
+/**
+ * Run fn as soon as a worker is available
+ */
+void executor::post(group& g, task fn) {
+  {
+    std::lock_guard<std::mutex> guard(m_timerlock);
+    if (g.m_cancelled) {
+      return;
+    }
+    g.m_pending++;
+  }
+  dispatch(job{&g, move(fn)});
+}
+
+/**
+ * Run fn once the given point in time has been reached
+ */
+void executor::post_at(group& g, clock::time_point when, task fn) {
+  {
+    std::lock_guard<std::mutex> guard(m_timerlock);
+    if (g.m_cancelled) {
+      return;
+    }
+    g.m_pending++;
+    m_timers.emplace_back(timed_job{when, job{&g, move(fn)}});
+    std::push_heap(m_timers.begin(), m_timers.end(), &executor::later);
+  }
+  m_timerwake.notify_one();
+}
+
+/**
+ * Drop all pending tasks of the group and wait for the running ones
+ *
+ * No new tasks are accepted for the group afterwards. When called from
+ * one of the group's own tasks, that task is not waited for.
+ */
+void executor::cancel(group& g) {
+  std::unique_lock<std::mutex> guard(m_timerlock);
+  g.m_cancelled = true;
+
+  auto it = std::remove_if(m_timers.begin(), m_timers.end(), [&](const timed_job& t) { return t.j.owner == &g; });
+  g.m_pending -= std::distance(it, m_timers.end());
+  m_timers.erase(it, m_timers.end());
+  std::make_heap(m_timers.begin(), m_timers.end(), &executor::later);
+
+  size_t self = current_group == &g ? 1 : 0;
+  m_finished.wait(guard, [&] { return g.m_pending <= self; });
+}
+
+/**
+ * Heap order, the job with the earliest deadline comes first
+ */
+bool executor::later(const timed_job& a, const timed_job& b) {
+  return a.when > b.when;
+}
+
+void executor::dispatch(job&& j) {
+  m_pools[static_cast<int>(j.owner->m_pool.load())]->push(move(j));
+}
+
+/**
+ * Run a job and check it against the budget of its group
+ */
+void executor::run(job& j) {
+  auto& g = *j.owner;
+
+  if (!g.m_cancelled) {
+    auto parent = current_group;
+    current_group = &g;
+    auto start = clock::now();
+
+    try {
+      j.fn();
+    } catch (const exception& err) {
+      m_log.err("%s: Uncaught exception in task (%s)", g.name(), err.what());
+    }
+
+    auto elapsed = clock::now() - start;
+    current_group = parent;
+
+    if (elapsed <= g.m_budget) {
+      g.m_overruns = 0;
+    } else if (++g.m_overruns >= MAX_OVERRUNS && !g.m_slow) {
+      m_log.warn("%s: Update took %ims, more than its budget of %ims, moving it to the pool for blocking tasks",
+          g.name(), chrono::duration_cast<chrono::milliseconds>(elapsed).count(),
+          chrono::duration_cast<chrono::milliseconds>(g.m_budget).count());
+      g.m_slow = true;
+      g.m_pool = pool::IO;
+    }
+  }
+
+  finish(g);
+}
+
+void executor::finish(group& g) {
+  {
+    std::lock_guard<std::mutex> guard(m_timerlock);
+    g.m_pending--;
+  }
+  m_finished.notify_all();
+}
+
+/**
+ * Hand jobs over to the pools once their deadline is reached
+ */
+void executor::timer() {
+  std::unique_lock<std::mutex> guard(m_timerlock);
+
+  while (!m_stopping) {
+    if (m_timers.empty()) {
+      m_timerwake.wait(guard);
+      continue;
+    }
+
+    auto when = m_timers.front().when;
+    if (when > clock::now()) {
+      m_timerwake.wait_until(guard, when);
+      continue;
+    }
+
+    std::pop_heap(m_timers.begin(), m_timers.end(), &executor::later);
+    auto j = move(m_timers.back().j);
+    m_timers.pop_back();
+
+    guard.unlock();
+    dispatch(move(j));
+    guard.lock();
+  }
+}
+
+// }}}
+
+POLYBAR_NS_END
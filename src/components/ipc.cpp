@@ -1,13 +1,17 @@
 #include <fcntl.h>
+#include <sys/socket.h>
 #include <sys/stat.h>
+#include <sys/un.h>
 
 #include "components/ipc.hpp"
+#include "components/ipc_msg.hpp"
 #include "components/logger.hpp"
 #include "events/signal.hpp"
 #include "events/signal_emitter.hpp"
 #include "utils/factory.hpp"
 #include "utils/file.hpp"
 #include "utils/string.hpp"
+#include "utils/trace.hpp"
 
 POLYBAR_NS
 
@@ -32,15 +36,49 @@ ipc::ipc(signal_emitter& emitter, const logger& logger) : m_sig(emitter), m_log(
   }
 
   m_log.info("Created ipc channel at: %s", m_path);
+
   m_fd = file_util::make_file_descriptor(m_path, O_RDONLY | O_NONBLOCK);
+
+  m_socket_path = string_util::replace(PATH_MESSAGING_SOCKET, "%pid%", to_string(getpid()));
+
+  struct sockaddr_un addr {};
+  addr.sun_family = AF_UNIX;
+
+  if (m_socket_path.size() >= sizeof(addr.sun_path)) {
+    throw application_error("Path to ipc socket is too long: " + m_socket_path);
+  }
+  strncpy(addr.sun_path, m_socket_path.c_str(), sizeof(addr.sun_path) - 1);
+
+  if (file_util::exists(m_socket_path) && unlink(m_socket_path.c_str()) == -1) {
+    throw system_error("Failed to remove ipc socket");
+  }
+
+  m_socket = file_util::make_file_descriptor(socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0));
+  if (!*m_socket) {
+    throw system_error("Failed to create ipc socket");
+  }
+  if (bind(*m_socket, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) == -1) {
+    throw system_error("Failed to bind ipc socket");
+  }
+  if (listen(*m_socket, 16) == -1) {
+    throw system_error("Failed to listen on ipc socket");
+  }
+
+  m_log.info("Listening for ipc messages on: %s", m_socket_path);
 }
 
 /**
  * Deconstruct ipc handler
  */
 ipc::~ipc() {
+  m_clients.clear();
+  m_socket.reset();
   m_fd.reset();
 
+  if (!m_socket_path.empty()) {
+    unlink(m_socket_path.c_str());
+  }
+
   if (!m_path.empty()) {
     m_log.trace("ipc: Removing file handle");
     unlink(m_path.c_str());
@@ -48,38 +86,314 @@ ipc::~ipc() {
 }
 
 /**
- * Receive available ipc messages and delegate valid events
+ * Handle activity on one of the descriptors returned by get_file_descriptors
  */
-void ipc::receive_message() {
-  m_log.info("Receiving ipc message");
+void ipc::receive_message(int fd) {
+  if (m_fd && fd == *m_fd) {
+    receive_fifo();
+  } else if (m_socket && fd == *m_socket) {
+    accept_clients();
+  } else {
+    auto it = m_clients.find(fd);
+    if (it != m_clients.end() && !receive_client(it->second)) {
+      m_log.trace("ipc: Closing client connection (fd=%i)", fd);
+      m_clients.erase(it);
+    }
+  }
+}
+
+/**
+ * Continue sending to a client returned by get_pending_writes
+ */
+void ipc::send_pending(int fd) {
+  auto it = m_clients.find(fd);
+  if (it == m_clients.end()) {
+    return;
+  }
 
-  char buffer[BUFSIZ]{'\0'};
+  auto& c = it->second;
+  // Requests that were held back while the client was not reading
+  // are processed once all responses went out
+  if (!flush_client(c) || (c.output.empty() && !process_requests(c)) || (c.closing && c.output.empty())) {
+    m_log.trace("ipc: Closing client connection (fd=%i)", fd);
+    m_clients.erase(it);
+  }
+}
+
+/**
+ * Get all file descriptors that need to be watched for input
+ *
+ * Clients are only read from while all responses to them were sent
+ */
+vector<int> ipc::get_file_descriptors() const {
+  vector<int> fds;
+  fds.emplace_back(*m_fd);
+  fds.emplace_back(*m_socket);
+  for (auto&& c : m_clients) {
+    if (c.second.output.empty() && !c.second.closing) {
+      fds.emplace_back(c.first);
+    }
+  }
+  return fds;
+}
+
+/**
+ * Get the clients that still have responses queued
+ */
+vector<int> ipc::get_pending_writes() const {
+  vector<int> fds;
+  for (auto&& c : m_clients) {
+    if (!c.second.output.empty()) {
+      fds.emplace_back(c.first);
+    }
+  }
+  return fds;
+}
+
+/**
+ * Accept pending connections on the ipc socket
+ */
+void ipc::accept_clients() {
+  int fd;
+  while ((fd = accept4(*m_socket, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC)) != -1) {
+    m_log.trace("ipc: New client connection (fd=%i)", fd);
+    m_clients[fd].fd = file_util::make_file_descriptor(fd);
+  }
+
+  if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+    m_log.err("Failed to accept ipc connection (err: %s)", strerror(errno));
+  }
+}
+
+/**
+ * Read all lines available on the fifo
+ *
+ * Each line is a separate message, there is no way to reply. A message
+ * without a trailing newline is only complete once its writer closed the
+ * fifo, until then it may still arrive in several reads.
+ */
+void ipc::receive_fifo() {
+  char buffer[BUFSIZ];
   ssize_t bytes_read{0};
 
-  if ((bytes_read = read(*m_fd, &buffer, BUFSIZ)) == -1) {
+  while ((bytes_read = read(*m_fd, buffer, sizeof(buffer))) > 0) {
+    m_fifo_buffer.append(buffer, bytes_read);
+  }
+
+  bool eof = bytes_read == 0;
+
+  if (bytes_read == -1 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
     m_log.err("Failed to read from ipc channel (err: %s)", strerror(errno));
-  } else if (bytes_read > 0) {
-    string payload{string_util::trim(string{buffer}, '\n')};
-
-    if (payload.find(ipc_command_prefix) == 0) {
-      m_sig.emit(signals::ipc::command{payload.substr(strlen(ipc_command_prefix))});
-    } else if (payload.find(ipc_hook_prefix) == 0) {
-      m_sig.emit(signals::ipc::hook{payload.substr(strlen(ipc_hook_prefix))});
-    } else if (payload.find(ipc_action_prefix) == 0) {
-      m_sig.emit(signals::ipc::action{payload.substr(strlen(ipc_action_prefix))});
-    } else if (!payload.empty()) {
-      m_log.warn("Received unknown ipc message: (payload=%s)", payload);
+  }
+
+  const auto process = [&](const string& payload) {
+    string result;
+    if (dispatch(payload, result) && !result.empty()) {
+      m_log.notice("%s", result);
+    } else if (!result.empty()) {
+      m_log.err("%s", result);
+    }
+  };
+
+  size_t pos;
+  while ((pos = m_fifo_buffer.find('\n')) != string::npos) {
+    string payload{m_fifo_buffer.substr(0, pos)};
+    m_fifo_buffer.erase(0, pos + 1);
+    if (!payload.empty()) {
+      process(payload);
     }
   }
 
-  m_fd = file_util::make_file_descriptor(m_path, O_RDONLY | O_NONBLOCK);
+  if (eof) {
+    // Writers are not required to terminate their message with a newline.
+    // All of them are gone, so the remainder is a complete message
+    if (!m_fifo_buffer.empty()) {
+      process(m_fifo_buffer);
+      m_fifo_buffer.clear();
+    }
+
+    // The fifo keeps reporting EOF until it is reopened
+    m_fd = file_util::make_file_descriptor(m_path, O_RDONLY | O_NONBLOCK);
+  }
+}
+
+/**
+ * Read data from a client and answer all complete requests
+ *
+ * \returns false if the connection should be closed
+ */
+bool ipc::receive_client(client& c) {
+  char buffer[BUFSIZ];
+  ssize_t bytes_read;
+
+  while ((bytes_read = read(*c.fd, buffer, sizeof(buffer))) > 0) {
+    c.buffer.append(buffer, bytes_read);
+  }
+
+  if (bytes_read == -1 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+    m_log.err("Failed to read from ipc client (err: %s)", strerror(errno));
+    return false;
+  }
+
+  if (!process_requests(c)) {
+    return false;
+  }
+
+  // The client is done sending, keep the connection until it got all responses
+  if (bytes_read == 0) {
+    c.closing = true;
+  }
+
+  return !c.closing || !c.output.empty();
 }
 
 /**
- * Get the file descriptor to the ipc channel
+ * Handle the complete requests received from a client
+ *
+ * Stops as soon as a response could not be sent right away, the
+ * remaining requests are handled once the client caught up.
+ *
+ * \returns false if the connection should be closed
  */
-int ipc::get_file_descriptor() const {
-  return *m_fd;
+bool ipc::process_requests(client& c) {
+  while (c.output.empty() && c.buffer.size() >= sizeof(ipc_msg::header)) {
+    ipc_msg::header hdr{};
+    memcpy(&hdr, c.buffer.data(), sizeof(hdr));
+
+    if (!ipc_msg::valid(hdr) || hdr.msg_type != ipc_msg::type::REQUEST) {
+      m_log.warn("Received invalid ipc frame, closing connection");
+      c.buffer.clear();
+      c.closing = true;
+      return send_frame(c, ipc_msg::encode(ipc_msg::type::RESPONSE_ERROR, {"error:invalid frame"}));
+    }
+
+    if (c.buffer.size() < sizeof(hdr) + hdr.size) {
+      break;
+    }
+
+    auto messages = ipc_msg::decode(c.buffer.substr(sizeof(hdr), hdr.size));
+    c.buffer.erase(0, sizeof(hdr) + hdr.size);
+
+    vector<string> results;
+    results.reserve(messages.size());
+    bool success{true};
+
+    for (auto&& payload : messages) {
+      string result;
+      if (dispatch(payload, result)) {
+        results.emplace_back(result.empty() ? "ok" : "ok:" + result);
+      } else {
+        results.emplace_back("error:" + (result.empty() ? "message was not handled" : result));
+        success = false;
+      }
+    }
+
+    auto type = success ? ipc_msg::type::RESPONSE_OK : ipc_msg::type::RESPONSE_ERROR;
+    if (!send_frame(c, ipc_msg::encode(type, results))) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+/**
+ * Queue a frame for the client and send as much of it as possible
+ *
+ * \returns false if the connection failed
+ */
+bool ipc::send_frame(client& c, const string& frame) const {
+  c.output += frame;
+  return flush_client(c);
+}
+
+/**
+ * Send queued output without blocking, the rest is kept until the
+ * client is writable again
+ *
+ * \returns false if the connection failed
+ */
+bool ipc::flush_client(client& c) const {
+  size_t offset{0};
+
+  while (offset < c.output.size()) {
+    ssize_t bytes = send(*c.fd, c.output.data() + offset, c.output.size() - offset, MSG_NOSIGNAL);
+
+    if (bytes == -1 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+      break;
+    } else if (bytes == -1 && errno != EINTR) {
+      m_log.warn("Failed to send ipc response (err: %s)", strerror(errno));
+      return false;
+    } else if (bytes > 0) {
+      offset += bytes;
+    }
+  }
+
+  c.output.erase(0, offset);
+  return true;
+}
+
+/**
+ * Delegate a single message
+ *
+ * \returns true if the message was handled, result holds the outcome reported by its handler
+ */
+bool ipc::dispatch(const string& message, string& result) {
+  string payload{string_util::trim(string{message}, '\n')};
+  bool handled{false};
+  ipc_request request{};
+
+  if (payload.find(ipc_command_prefix) == 0) {
+    request.payload = payload.substr(strlen(ipc_command_prefix));
+    bool success{false};
+    if (query(request.payload, result, success)) {
+      return success;
+    }
+    handled = m_sig.emit(signals::ipc::command{request});
+  } else if (payload.find(ipc_hook_prefix) == 0) {
+    request.payload = payload.substr(strlen(ipc_hook_prefix));
+    handled = m_sig.emit(signals::ipc::hook{request});
+  } else if (payload.find(ipc_action_prefix) == 0) {
+    request.payload = payload.substr(strlen(ipc_action_prefix));
+    handled = m_sig.emit(signals::ipc::action{request});
+  } else {
+    m_log.warn("Received unknown ipc message: (payload=%s)", payload);
+    result = "unknown message type";
+    return false;
+  }
+
+  result = move(request.result);
+  return handled;
+}
+
+/**
+ * Answer commands that only read or reset diagnostic state
+ *
+ * \returns false if the command is not a query and has to be passed on
+ */
+bool ipc::query(const string& command, string& result, bool& success) const {
+  success = true;
+
+  if (command == "stats") {
+    result = trace_util::summary();
+  } else if (command == "stats-reset") {
+    trace_util::reset();
+  } else if (command == "trace-start") {
+    m_log.notice("Capturing trace events");
+    trace_util::start_capture();
+  } else if (command.compare(0, 11, "trace-dump ") == 0) {
+    string path{string_util::trim(command.substr(11), ' ')};
+    if (trace_util::dump(path)) {
+      result = "Wrote trace events to " + path;
+    } else {
+      result = "Failed to write trace events to " + path;
+      success = false;
+    }
+  } else {
+    return false;
+  }
+
+  return true;
 }
 
 POLYBAR_NS_END
@@ -1,5 +1,9 @@
+#include <moodycamel/blockingconcurrentqueue.h>
 #include <unistd.h>
 
+#include <cerrno>
+#include <condition_variable>
+
 #include "components/logger.hpp"
 #include "errors.hpp"
 #include "settings.hpp"
@@ -9,6 +13,121 @@
 
 POLYBAR_NS
 
+/**
+ * Background thread writing the formatted log lines
+ *
+ * Every producing thread gets its own lock-free sub-queue (implicit producer),
+ * so logging never waits on the output channel. Lines are dropped, and
+ * counted, when the queue is full.
+ */
+class log_writer {
+ public:
+  static constexpr size_t CAPACITY{4096};
+  static constexpr size_t BATCH_SIZE{64};
+
+  explicit log_writer(int fd) : m_fd(fd), m_pid(getpid()), m_queue(CAPACITY) {
+    m_thread = thread(&log_writer::run, this);
+  }
+
+  ~log_writer() {
+    flush();
+    m_running = false;
+    m_queue.enqueue(string{});
+    if (m_thread.joinable()) {
+      m_thread.join();
+    }
+  }
+
+  void push(string&& line) {
+    if (getpid() != m_pid) {
+      // Forked child without a writer thread
+      write_all(line);
+      return;
+    }
+
+    if (m_queue.try_enqueue(move(line))) {
+      m_pushed++;
+    } else {
+      m_dropped++;
+    }
+  }
+
+  /**
+   * Block until all queued lines have been written
+   */
+  void flush() {
+    if (getpid() != m_pid) {
+      return;
+    }
+    auto target = m_pushed.load();
+    std::unique_lock<mutex> guard(m_flushlock);
+    m_flushed.wait(guard, [&] { return m_written.load() >= target || !m_running; });
+  }
+
+  size_t dropped() const {
+    return m_dropped_total.load();
+  }
+
+ protected:
+  void run() {
+    std::array<string, BATCH_SIZE> lines;
+    string buffer;
+
+    while (m_running) {
+      // The destructor wakes us up with an empty line
+      size_t count = m_queue.wait_dequeue_bulk(lines.begin(), lines.size());
+
+      auto dropped = m_dropped.exchange(0);
+      if (dropped > 0) {
+        m_dropped_total += dropped;
+        buffer += "polybar|warn:  " + to_string(dropped) + " log messages dropped\n";
+      }
+
+      for (size_t i = 0; i < count; i++) {
+        buffer += lines[i];
+        lines[i].clear();
+      }
+
+      if (!buffer.empty()) {
+        write_all(buffer);
+        buffer.clear();
+      }
+
+      {
+        std::lock_guard<mutex> guard(m_flushlock);
+        m_written += count;
+      }
+      m_flushed.notify_all();
+    }
+  }
+
+  void write_all(const string& data) const {
+    size_t offset{0};
+    while (offset < data.size()) {
+      ssize_t bytes = ::write(m_fd, data.data() + offset, data.size() - offset);
+      if (bytes == -1 && errno == EINTR) {
+        continue;
+      } else if (bytes <= 0) {
+        break;
+      }
+      offset += bytes;
+    }
+  }
+
+ private:
+  int m_fd;
+  pid_t m_pid;
+  moodycamel::BlockingConcurrentQueue<string> m_queue;
+  atomic<bool> m_running{true};
+  atomic<size_t> m_pushed{0};
+  atomic<size_t> m_written{0};
+  atomic<size_t> m_dropped{0};
+  atomic<size_t> m_dropped_total{0};
+  mutex m_flushlock;
+  std::condition_variable m_flushed;
+  thread m_thread;
+};
+
 /**
  * Convert string
  */
@@ -36,31 +155,78 @@ logger::make_type logger::make(loglevel level) {
 logger::logger(loglevel level) : m_level(level) {
   // clang-format off
   if (isatty(m_fd)) {
-    m_prefixes[loglevel::TRACE]   = "\r\033[0;32m- \033[0m";
-    m_prefixes[loglevel::INFO]    = "\r\033[1;32m* \033[0m";
-    m_prefixes[loglevel::NOTICE]  = "\r\033[1;34mnotice: \033[0m";
-    m_prefixes[loglevel::WARNING] = "\r\033[1;33mwarn: \033[0m";
-    m_prefixes[loglevel::ERROR]   = "\r\033[1;31merror: \033[0m";
-    m_suffixes[loglevel::TRACE]   = "\033[0m";
-    m_suffixes[loglevel::INFO]    = "\033[0m";
-    m_suffixes[loglevel::NOTICE]  = "\033[0m";
-    m_suffixes[loglevel::WARNING] = "\033[0m";
-    m_suffixes[loglevel::ERROR]   = "\033[0m";
+    m_prefixes[static_cast<size_t>(loglevel::TRACE)]   = "\r\033[0;32m- \033[0m";
+    m_prefixes[static_cast<size_t>(loglevel::INFO)]    = "\r\033[1;32m* \033[0m";
+    m_prefixes[static_cast<size_t>(loglevel::NOTICE)]  = "\r\033[1;34mnotice: \033[0m";
+    m_prefixes[static_cast<size_t>(loglevel::WARNING)] = "\r\033[1;33mwarn: \033[0m";
+    m_prefixes[static_cast<size_t>(loglevel::ERROR)]   = "\r\033[1;31merror: \033[0m";
+    m_suffixes[static_cast<size_t>(loglevel::TRACE)]   = "\033[0m";
+    m_suffixes[static_cast<size_t>(loglevel::INFO)]    = "\033[0m";
+    m_suffixes[static_cast<size_t>(loglevel::NOTICE)]  = "\033[0m";
+    m_suffixes[static_cast<size_t>(loglevel::WARNING)] = "\033[0m";
+    m_suffixes[static_cast<size_t>(loglevel::ERROR)]   = "\033[0m";
   } else {
-    m_prefixes.emplace(make_pair(loglevel::TRACE,   "polybar|trace: "));
-    m_prefixes.emplace(make_pair(loglevel::INFO,    "polybar|info:  "));
-    m_prefixes.emplace(make_pair(loglevel::NOTICE,  "polybar|notice:  "));
-    m_prefixes.emplace(make_pair(loglevel::WARNING, "polybar|warn:  "));
-    m_prefixes.emplace(make_pair(loglevel::ERROR,   "polybar|error: "));
-    m_suffixes.emplace(make_pair(loglevel::TRACE,   ""));
-    m_suffixes.emplace(make_pair(loglevel::INFO,    ""));
-    m_suffixes.emplace(make_pair(loglevel::NOTICE,  ""));
-    m_suffixes.emplace(make_pair(loglevel::WARNING, ""));
-    m_suffixes.emplace(make_pair(loglevel::ERROR,   ""));
+    m_prefixes[static_cast<size_t>(loglevel::TRACE)]   = "polybar|trace: ";
+    m_prefixes[static_cast<size_t>(loglevel::INFO)]    = "polybar|info:  ";
+    m_prefixes[static_cast<size_t>(loglevel::NOTICE)]  = "polybar|notice:  ";
+    m_prefixes[static_cast<size_t>(loglevel::WARNING)] = "polybar|warn:  ";
+    m_prefixes[static_cast<size_t>(loglevel::ERROR)]   = "polybar|error: ";
   }
   // clang-format on
 }
 
+/**
+ * Deconstruct logger
+ *
+ * Pending messages are written before the writer thread is stopped
+ */
+logger::~logger() {
+  delete m_writer.exchange(nullptr);
+}
+
+/**
+ * Pass a formatted line to the writer thread
+ *
+ * Errors are flushed right away so that they are visible
+ * even if the process goes down afterwards
+ */
+void logger::enqueue(loglevel level, string&& line) const {
+  auto writer = m_writer.load(std::memory_order_acquire);
+
+  if (writer == nullptr) {
+    auto created = new log_writer(m_fd);
+    if (m_writer.compare_exchange_strong(writer, created, std::memory_order_acq_rel)) {
+      writer = created;
+    } else {
+      delete created;
+    }
+  }
+
+  writer->push(move(line));
+
+  if (level == loglevel::ERROR) {
+    writer->flush();
+  }
+}
+
+/**
+ * Wait until all pending messages have been written
+ */
+void logger::flush() const {
+  auto writer = m_writer.load(std::memory_order_acquire);
+  if (writer != nullptr) {
+    writer->flush();
+  }
+}
+
+/**
+ * Number of messages dropped because the queue was full
+ */
+size_t logger::dropped() const {
+  auto writer = m_writer.load(std::memory_order_acquire);
+  return writer != nullptr ? writer->dropped() : 0;
+}
+
 /**
  * Set output verbosity
  */
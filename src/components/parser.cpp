@@ -9,6 +9,7 @@
 #include "utils/factory.hpp"
 #include "utils/memory.hpp"
 #include "utils/string.hpp"
+#include "utils/trace.hpp"
 
 POLYBAR_NS
 
@@ -28,18 +29,29 @@ parser::parser(signal_emitter& emitter) : m_sig(emitter) {}
 
 /**
  * Process input string
+ *
+ * The tags and text are copied into buffers owned by the parser, which
+ * keep their capacity, so parsing the same kind of contents again does
+ * not allocate.
  */
-void parser::parse(string data) {
-  while (!data.empty()) {
-    size_t pos{string::npos};
-
-    if (data.compare(0, 2, "%{") == 0 && (pos = data.find('}')) != string::npos) {
-      codeblock(data.substr(2, pos - 2));
-      data.erase(0, pos + 1);
-    } else if ((pos = data.find("%{")) != string::npos) {
-      data.erase(0, text(data.substr(0, pos)));
+void parser::parse(const string& data) {
+  TRACE_SCOPE("parser::parse");
+
+  m_actions.clear();
+
+  size_t pos{0};
+  while (pos < data.size()) {
+    size_t end{string::npos};
+
+    if (data.compare(pos, 2, "%{") == 0 && (end = data.find('}', pos)) != string::npos) {
+      m_block.assign(data, pos + 2, end - pos - 2);
+      codeblock(m_block);
+      pos = end + 1;
     } else {
-      data.erase(0, text(data.substr(0)));
+      // An unclosed tag is drawn as text
+      end = data.find("%{", pos + 1);
+      m_text.assign(data, pos, end == string::npos ? string::npos : end - pos);
+      pos += text(m_text);
     }
   }
 
@@ -51,21 +63,21 @@ void parser::parse(string data) {
 /**
  * Process contents within tag blocks, i.e: %{...}
  */
-void parser::codeblock(string&& data) {
-  size_t pos;
-
-  while (data.length()) {
-    data = string_util::ltrim(move(data), ' ');
+void parser::codeblock(const string& data) {
+  size_t pos{0};
 
-    if (data.empty()) {
-      break;
+  while (pos < data.size()) {
+    if (data[pos] == ' ') {
+      pos++;
+      continue;
     }
 
-    char tag{data[0]};
+    // Remove the tag
+    char tag{data[pos++]};
 
     /*
      * Contains the string from the current position to the next space or
-     * closing curly bracket (})
+     * the end of the block
      *
      * This may be unsuitable for some tags (e.g. action tag) to use
      * These MUST set value to the actual string they parsed from the beginning
@@ -74,10 +86,10 @@ void parser::codeblock(string&& data) {
      *
      * example:
      *
-     * data = A1:echo "test": ...}
+     * data = A1:echo "test": ...
      *
-     * erase(0,1)
-     * -> data = 1:echo "test": ...}
+     * pos = 1
+     * -> 1:echo "test": ...
      *
      * case 'A', parse_action_cmd
      * -> value = echo "test"
@@ -85,28 +97,21 @@ void parser::codeblock(string&& data) {
      * Padding value
      * -> value = echo "test"0::
      *
-     * erase(0, value.length())
-     * -> data =  ...}
+     * pos += value.length()
+     * ->  ...
      *
      */
-    string value;
-
-    // Remove the tag
-    data.erase(0, 1);
-
-    if ((pos = data.find_first_of(" }")) != string::npos) {
-      value = data.substr(0, pos);
-    } else {
-      value = data;
-    }
+    string& value{m_value};
+    size_t end{data.find(' ', pos)};
+    value.assign(data, pos, end == string::npos ? string::npos : end - pos);
 
     switch (tag) {
       case 'B':
-        m_sig.emit(change_background{string(value)});
+        m_sig.emit(change_background{parse_color(value)});
         break;
 
       case 'F':
-        m_sig.emit(change_foreground{string(value)});
+        m_sig.emit(change_foreground{parse_color(value)});
         break;
 
       case 'T':
@@ -114,16 +119,16 @@ void parser::codeblock(string&& data) {
         break;
 
       case 'U':
-        m_sig.emit(change_underline{string(value)});
-        m_sig.emit(change_overline{string(value)});
+        m_sig.emit(change_underline{parse_color(value)});
+        m_sig.emit(change_overline{parse_color(value)});
         break;
 
       case 'u':
-        m_sig.emit(change_underline{string(value)});
+        m_sig.emit(change_underline{parse_color(value)});
         break;
 
       case 'o':
-        m_sig.emit(change_overline{string(value)});
+        m_sig.emit(change_overline{parse_color(value)});
         break;
 
       case 'R':
@@ -158,15 +163,28 @@ void parser::codeblock(string&& data) {
         break;
 
       case 'A': {
-        bool has_btn_id = (data[0] != ':');
-        if (isdigit(data[0]) || !has_btn_id) {
-          value = parse_action_cmd(data.substr(has_btn_id ? 1 : 0));
-          mousebtn btn = parse_action_btn(data);
+        bool has_btn_id = (data[pos] != ':');
+        if (isdigit(data[pos]) || !has_btn_id) {
+          size_t cmd_start{pos + (has_btn_id ? 1 : 0)};
+          size_t cmd_end{action_cmd_end(data, cmd_start)};
+          if (cmd_end == string::npos) {
+            value.clear();
+          } else {
+            value.assign(data, cmd_start + 1, cmd_end - cmd_start - 1);
+          }
+          mousebtn btn = parse_action_btn(data.c_str() + pos);
           m_actions.push_back(static_cast<int>(btn));
 
           // Unescape colons inside command before sending it to the renderer
-          auto cmd = string_util::replace_all(value, "\\:", ":");
-          m_sig.emit(action_begin{action{btn, cmd}});
+          m_action.button = btn;
+          m_action.command.clear();
+          for (size_t i = 0; i < value.size(); i++) {
+            if (value.compare(i, 2, "\\:") == 0) {
+              i++;
+            }
+            m_action.command += value[i];
+          }
+          m_sig.emit(action_begin{m_action});
 
           /*
            * make sure value has the same length as the inside of the action
@@ -177,7 +195,7 @@ void parser::codeblock(string&& data) {
           }
           value += "::";
         } else if (!m_actions.empty()) {
-          m_sig.emit(action_end{parse_action_btn(value)});
+          m_sig.emit(action_end{parse_action_btn(value.c_str())});
           m_actions.pop_back();
         }
         break;
@@ -189,12 +207,12 @@ void parser::codeblock(string&& data) {
         break;
 
       default:
-        throw unrecognized_token("Unrecognized token '" + string{tag} + "' in '" + data + "'");
+        throw unrecognized_token("Unrecognized token '" + string{tag} + "' in '" + data.substr(pos) + "'");
     }
 
-    if (!data.empty()) {
-      // Remove the parsed string from data
-      data.erase(0, !value.empty() ? value.length() : 1);
+    if (pos < data.size()) {
+      // Skip the parsed string
+      pos += !value.empty() ? value.length() : 1;
     }
   }
 }
@@ -202,7 +220,7 @@ void parser::codeblock(string&& data) {
 /**
  * Process text contents
  */
-size_t parser::text(string&& data) {
+size_t parser::text(string& data) {
 #ifdef DEBUG_WHITESPACE
   string::size_type p;
   while ((p = data.find(' ')) != string::npos) {
@@ -210,10 +228,43 @@ size_t parser::text(string&& data) {
   }
 #endif
 
-  m_sig.emit(signals::parser::text{forward<string>(data)});
+  m_sig.emit(signals::parser::text{data});
   return data.size();
 }
 
+/**
+ * Process color token and convert it to the correct value
+ *
+ * Results are cached by the token, so every color code is only
+ * parsed the first time it is seen
+ */
+const tag_color& parser::parse_color(const string& value) {
+  auto it = m_colors.find(value);
+  if (it != m_colors.end()) {
+    return it->second;
+  }
+
+  // Modules that generate their colors keep adding new values
+  if (m_colors.size() >= MAX_CACHED_COLORS) {
+    m_colors.clear();
+  }
+
+  tag_color color{};
+  if (value.compare(0, 5, "anim:") == 0) {
+    color.kind = tag_color::type::ANIMATED;
+    color.anim = &*m_animations.emplace(value.substr(5)).first;
+  } else if (!value.empty() && value[0] != '-') {
+    color.kind = tag_color::type::PLAIN;
+    try {
+      color.value = color_util::parse(value);
+    } catch (const std::exception& err) {
+      throw unrecognized_token("Invalid color '" + value + "'");
+    }
+  }
+
+  return m_colors.emplace(value, color).first->second;
+}
+
 /**
  * Process font index and convert it to the correct value
  */
@@ -246,7 +297,7 @@ attribute parser::parse_attr(const char attr) {
 /**
  * Process action button token and convert it to the correct value
  */
-mousebtn parser::parse_action_btn(const string& data) {
+mousebtn parser::parse_action_btn(const char* data) {
   if (data[0] == ':') {
     return mousebtn::LEFT;
   } else if (isdigit(data[0])) {
@@ -267,20 +318,31 @@ mousebtn parser::parse_action_btn(const string& data) {
  * Returns everything inside the unescaped colons as is
  */
 string parser::parse_action_cmd(string&& data) {
-  if (data[0] != ':') {
+  size_t end{action_cmd_end(data, 0)};
+
+  if (end == string::npos) {
     return "";
   }
 
-  size_t end{1};
-  while ((end = data.find(':', end)) != string::npos && data[end - 1] == '\\') {
-    end++;
+  return data.substr(1, end - 1);
+}
+
+/**
+ * Find the unescaped colon closing the action cmd that starts at pos
+ *
+ * Returns npos if there is no cmd starting at pos or it is not closed
+ */
+size_t parser::action_cmd_end(const string& data, size_t pos) {
+  if (data[pos] != ':') {
+    return string::npos;
   }
 
-  if (end == string::npos) {
-    return "";
+  size_t end{pos + 1};
+  while ((end = data.find(':', end)) != string::npos && data[end - 1] == '\\') {
+    end++;
   }
 
-  return data.substr(1, end - 1);
+  return end;
 }
 
 controltag parser::parse_control(const string& data) {
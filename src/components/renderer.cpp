@@ -7,6 +7,8 @@
 #include "events/signal_receiver.hpp"
 #include "utils/factory.hpp"
 #include "utils/math.hpp"
+#include "utils/string.hpp"
+#include "utils/trace.hpp"
 #include "x11/atoms.hpp"
 #include "x11/background_manager.hpp"
 #include "x11/connection.hpp"
@@ -14,7 +16,6 @@
 
 POLYBAR_NS
 
-static constexpr double BLOCK_GAP{20.0};
 
 /**
  * Create instance
@@ -106,14 +107,34 @@ renderer::renderer(connection& conn, signal_emitter& sig, const config& conf, co
 
   m_log.trace("renderer: Allocate alignment blocks");
   {
-    m_blocks.emplace(alignment::LEFT, alignment_block{nullptr, 0.0, 0.0});
-    m_blocks.emplace(alignment::CENTER, alignment_block{nullptr, 0.0, 0.0});
-    m_blocks.emplace(alignment::RIGHT, alignment_block{nullptr, 0.0, 0.0});
+    m_blocks.emplace(alignment::LEFT, alignment_block{});
+    m_blocks.emplace(alignment::CENTER, alignment_block{});
+    m_blocks.emplace(alignment::RIGHT, alignment_block{});
   }
 
   m_log.trace("renderer: Allocate cairo components");
   {
-    m_surface = make_unique<cairo::xcb_surface>(m_connection, m_pixmap, m_visual, m_bar.size.w, m_bar.size.h);
+#if WITH_XSHM
+    if (m_conf.get<bool>("settings", "shm-presentation", false)) {
+      if (!shm_util::query_extension(m_connection)) {
+        m_log.warn("MIT-SHM extension not available, falling back to X rendering");
+      } else if (!shm_util::compatible(m_connection, m_visual, m_depth)) {
+        m_log.warn("MIT-SHM not supported for the bar visual, falling back to X rendering");
+      } else {
+        try {
+          m_shm = make_unique<shm_image>(m_connection, m_depth, m_bar.size.w, m_bar.size.h);
+          m_surface = make_unique<cairo::image_surface>(
+              m_shm->data(), m_shm->format(), m_bar.size.w, m_bar.size.h, m_shm->stride());
+          m_log.info("Rendering into shared memory");
+        } catch (const exception& err) {
+          m_log.warn("Failed to set up MIT-SHM, falling back to X rendering (%s)", err.what());
+        }
+      }
+    }
+#endif
+    if (!m_surface) {
+      m_surface = make_unique<cairo::xcb_surface>(m_connection, m_pixmap, m_visual, m_bar.size.w, m_bar.size.h);
+    }
     m_context = make_unique<cairo::context>(*m_surface, m_log);
   }
 
@@ -162,6 +183,9 @@ renderer::renderer(connection& conn, signal_emitter& sig, const config& conf, co
       m_log.notice("Loaded font \"%s\" (name=%s, offset=%i, file=%s)", pattern, font->name(), offset, font->file());
       *m_context << move(font);
     }
+
+    // Write the matches of all newly loaded fonts at once
+    cairo::font_match_cache().save();
   }
 
   m_pseudo_transparency = m_conf.get<bool>("settings", "pseudo-transparency", m_pseudo_transparency);
@@ -195,38 +219,56 @@ xcb_window_t renderer::window() const {
 }
 
 /**
- * Get completed action blocks
+ * Get the action index of the last completed frame
+ *
+ * It is replaced at the end of every frame, so this can be called from
+ * the event thread while the next frame is being drawn.
  */
-const vector<action_block> renderer::actions() const {
-  return m_actions;
+shared_ptr<const action_index> renderer::actions() const {
+  return std::atomic_load(&m_action_index);
 }
 
 /**
  * Begin render routine
+ *
+ * The contents are parsed twice per frame. The first pass only measures
+ * the blocks, layout() then positions them, so that the second pass can
+ * draw every block straight into the target at its final position.
  */
 void renderer::begin(xcb_rectangle_t rect) {
+  TRACE_SCOPE("renderer::begin");
   m_log.trace_x("renderer: begin (geom=%ix%i+%i+%i)", rect.width, rect.height, rect.x, rect.y);
 
   // Reset state
+  if (rect.x != m_rect.x || rect.y != m_rect.y || rect.width != m_rect.width || rect.height != m_rect.height) {
+    m_redraw_all = true;
+  }
   m_rect = rect;
-  m_actions.clear();
-  m_attr.reset();
-  m_align = alignment::NONE;
+  m_num_actions = 0;
+  m_run_widths.clear();
   m_anim_used = false;
+  m_measuring = true;
+  m_align = alignment::NONE;
+  for (auto&& b : m_blocks) {
+    b.second = alignment_block{};
+  }
+  m_layout = block_layout{};
+  reset_state();
 
-  // Reset colors
-  m_bg = "";
-  m_fg = "";
-  m_ul = "";
-  m_ol = "";
+#if WITH_XSHM
+  // The server may still be reading the previous frame
+  if (m_shm) {
+    m_shm->sync();
+  }
+#endif
 
   // Clear canvas
   m_context->save();
   m_context->clear();
 
-  // when pseudo-transparency is requested, render the bar into a new layer
-  // that will later be composited against the desktop background
-  if (m_pseudo_transparency) {
+  // A target without alpha channel can't be composited against the desktop
+  // background afterwards, render the bar into a new layer instead
+  if (m_pseudo_transparency && m_depth != 32) {
     m_context->push();
   }
 
@@ -258,114 +300,203 @@ void renderer::begin(xcb_rectangle_t rect) {
   // clang-format on
 }
 
+/**
+ * Position the measured blocks and start drawing them
+ */
+void renderer::layout() {
+  TRACE_SCOPE("renderer::layout");
+  m_log.trace_x("renderer: layout");
+
+  /*
+   * The center of the bar is relative to the very left of the bar (including border and tray), so it has to be
+   * compensated with m_rect.x
+   */
+  m_layout = block_layout{static_cast<double>(m_rect.width), m_blocks[alignment::LEFT].x,
+      m_blocks[alignment::CENTER].x, m_blocks[alignment::RIGHT].x, m_fixedcenter, m_bar.size.w / 2.0 - m_rect.x};
+
+  for (auto&& b : m_blocks) {
+    b.second = alignment_block{};
+  }
+
+  m_actions.resize(m_num_actions);
+  m_run = 0;
+
+  m_measuring = false;
+  m_align = alignment::NONE;
+  reset_state();
+
+  if (m_cornermask != nullptr) {
+    // Capture the block contents so that they can be masked with the corner pattern
+    m_context->push();
+  }
+
+  fill_background();
+}
+
 /**
  * End render routine
  */
 void renderer::end() {
+  TRACE_SCOPE("renderer::end");
   m_log.trace_x("renderer: end");
 
-  for (auto&& a : m_actions) {
-    a.start_x += block_x(a.align) + m_rect.x;
-    a.end_x += block_x(a.align) + m_rect.x;
+  if (m_measuring) {
+    // The contents couldn't be parsed, only draw the background
+    layout();
   }
 
   if (m_align != alignment::NONE) {
-    m_log.trace_x("renderer: pop(%i)", static_cast<int>(m_align));
-    m_context->pop(&m_blocks[m_align].pattern);
+    // Drop the clip of the last block
+    m_context->restore();
+  }
 
-    // Capture the concatenated block contents
-    // so that it can be masked with the corner pattern
-    m_context->push();
+  for (auto&& b : m_blocks) {
+    fill_falloff(b.first);
+  }
 
-    // Draw the background on the new layer to make up for
-    // the areas not covered by the alignment blocks
-    fill_background();
+  for (auto&& a : m_actions) {
+    a.start_x += block_x(a.align) + m_rect.x;
+    a.end_x += block_x(a.align) + m_rect.x;
+  }
 
-    for (auto&& b : m_blocks) {
-      flush(b.first);
-    }
+  /*
+   * Readers can only get the published index, so once the spare index is only
+   * referenced here nobody can access it anymore and it can be rebuilt in place
+   */
+  if (m_spare_index.use_count() == 1) {
+    std::atomic_thread_fence(std::memory_order_acquire);
+  } else {
+    m_spare_index = make_shared<action_index>();
+  }
+  m_spare_index->assign(m_actions.data(), m_actions.size());
+  auto previous = std::atomic_exchange(&m_action_index, shared_ptr<const action_index>{m_spare_index});
+  m_spare_index = std::const_pointer_cast<action_index>(previous);
 
+  if (m_cornermask != nullptr) {
     cairo_pattern_t* blockcontents{};
     m_context->pop(&blockcontents);
-
-    if (m_cornermask != nullptr) {
-      *m_context << blockcontents;
-      m_context->mask(m_cornermask);
-    } else {
-      *m_context << blockcontents;
-      m_context->paint();
-    }
-
+    *m_context << blockcontents;
+    m_context->mask(m_cornermask);
     m_context->destroy(&blockcontents);
-  } else {
-    fill_background();
   }
 
-  // For pseudo-transparency, capture the contents of the rendered bar and
-  // composite it against the desktop wallpaper. This way transparent parts of
-  // the bar will be filled by the wallpaper creating illusion of transparency.
-  if (m_pseudo_transparency) {
-    cairo_pattern_t* barcontents{};
+  cairo_pattern_t* barcontents{};
+  if (m_pseudo_transparency && m_depth != 32) {
     m_context->pop(&barcontents);  // corresponding push is in renderer::begin
+  }
 
+  m_context->restore();
+
+  // For pseudo-transparency, composite the desktop wallpaper underneath the
+  // rendered bar. The canvas was cleared in renderer::begin, so painting with
+  // DEST_OVER fills the transparent parts of the bar with the wallpaper in a
+  // single pass, without capturing the bar contents in an intermediate group.
+  //
+  // That only works if the target has an alpha channel. Otherwise the bar
+  // contents were captured, they are painted over the wallpaper instead.
+  if (m_pseudo_transparency) {
     auto root_bg = m_background->get_surface();
+#if WITH_XSHM
+    if (m_shm) {
+      root_bg = m_background->get_image_surface();
+    }
+#endif
+    m_context->save();
     if (root_bg != nullptr) {
       m_log.trace_x("renderer: root background");
+      *m_context << (barcontents != nullptr ? CAIRO_OPERATOR_SOURCE : CAIRO_OPERATOR_DEST_OVER);
       *m_context << *root_bg;
       m_context->paint();
+    }
+    if (barcontents != nullptr) {
       *m_context << CAIRO_OPERATOR_OVER;
+      *m_context << barcontents;
+      m_context->paint();
+      m_context->destroy(&barcontents);
     }
-    *m_context << barcontents;
-    m_context->paint();
-    m_context->destroy(&barcontents);
+    m_context->restore();
   }
 
-  m_context->restore();
   m_surface->flush();
 
-  flush();
+  update_damage();
+  flush(true);
 
   m_sig.emit(signals::ui::changed{});
 }
 
 /**
- * Flush contents of given alignment block
+ * Find the area of the bar that changed since the last frame
+ *
+ * Drawing is clipped to the blocks and everything outside of them is the
+ * same in every frame, so only blocks whose contents or placement changed
+ * have to be presented again, both where they are now and where they were.
  */
-void renderer::flush(alignment a) {
-  if (m_blocks[a].pattern == nullptr) {
-    return;
+void renderer::update_damage() {
+  double left{static_cast<double>(m_rect.width)};
+  double right{0.0};
+
+  for (auto a : {alignment::LEFT, alignment::CENTER, alignment::RIGHT}) {
+    const auto& p = m_layout.get(a);
+    auto& presented = m_presented[a];
+    if (presented.hash == m_blocks[a].hash && presented.x == p.x && presented.width == p.visible) {
+      continue;
+    }
+    if (presented.width > 0.0) {
+      left = std::min(left, presented.x);
+      right = std::max(right, presented.x + presented.width);
+    }
+    if (p.visible > 0.0) {
+      left = std::min(left, p.x);
+      right = std::max(right, p.x + p.visible);
+    }
+    presented = presented_block{m_blocks[a].hash, p.x, p.visible};
   }
 
-  m_context->save();
+  if (m_redraw_all) {
+    m_damage = xcb_rectangle_t{0, 0, static_cast<uint16_t>(m_bar.size.w), static_cast<uint16_t>(m_bar.size.h)};
+    m_redraw_all = false;
+  } else if (left < right) {
+    left = std::max(0.0, std::floor(left));
+    right = std::min(static_cast<double>(m_rect.width), std::ceil(right));
+    m_damage.x = static_cast<int16_t>(m_rect.x + left);
+    m_damage.y = m_rect.y;
+    m_damage.width = static_cast<uint16_t>(right - left);
+    m_damage.height = m_rect.height;
+  }
+}
 
-  double x = static_cast<int>(block_x(a) + 0.5);
+/**
+ * Reset the colors, font and attributes set by the contents
+ */
+void renderer::reset_state() {
+  m_bg = tag_color{};
+  m_fg = tag_color{};
+  m_ul = tag_color{};
+  m_ol = tag_color{};
+  m_font = 0;
+  m_attr.reset();
+}
+
+/**
+ * Paint the falloff gradient of a block that expands past the canvas
+ */
+void renderer::fill_falloff(alignment a) {
+  const auto& p = m_layout.get(a);
+  if (p.width == 0.0) {
+    return;
+  }
+
+  double x = p.x;
   double y = static_cast<int>(block_y(a) + 0.5);
-  double w = static_cast<int>(block_w(a) + 0.5);
+  double w = static_cast<int>(p.width + 0.5);
   double h = static_cast<int>(block_h(a) + 0.5);
   double xw = x + w;
-  bool fits{xw <= m_rect.width};
-
-  m_log.trace("renderer: flush(%i geom=%gx%g+%g+%g, falloff=%i)", static_cast<int>(a), w, h, x, y, !fits);
 
-  // Set block shape
-  *m_context << cairo::abspos{0.0, 0.0};
-  *m_context << cairo::rect{m_rect.x + x, m_rect.y + y, w, h};
+  m_log.trace_x("renderer: fill_falloff(%i geom=%gx%g+%g+%g, falloff=%i)", static_cast<int>(a), w, h, x, y,
+      p.overflows());
 
-  // Restrict drawing to the block rectangle
-  m_context->clip(true);
-
-  // Clear the area covered by the block
-  m_context->clear();
-
-  *m_context << cairo::translate{x, 0.0};
-  *m_context << m_blocks[a].pattern;
-  m_context->paint();
-
-  *m_context << cairo::abspos{0.0, 0.0};
-  m_context->destroy(&m_blocks[a].pattern);
-  m_context->restore();
-
-  if (!fits) {
+  if (p.overflows()) {
     // Paint falloff gradient at the end of the visible block
     // to indicate that the content expands past the canvas
 
@@ -393,8 +524,12 @@ void renderer::flush(alignment a) {
 
 /**
  * Flush pixmap contents onto the target window
+ *
+ * With damaged_only, only the area that changed since the last frame (see
+ * update_damage()) is copied. Everything else (e.g. expose events) copies
+ * the whole pixmap.
  */
-void renderer::flush() {
+void renderer::flush(bool damaged_only) {
   m_log.trace_x("renderer: flush");
 
   highlight_clickable_areas();
@@ -418,9 +553,27 @@ void renderer::flush() {
 #endif
 #endif
 
-  m_surface->flush();
-  m_connection.copy_area(m_pixmap, m_window, m_gcontext, 0, 0, 0, 0, m_bar.size.w, m_bar.size.h);
-  m_connection.flush();
+  {
+    TRACE_SCOPE("renderer::copy_area");
+    m_surface->flush();
+
+    xcb_rectangle_t area{0, 0, static_cast<uint16_t>(m_bar.size.w), static_cast<uint16_t>(m_bar.size.h)};
+    if (damaged_only) {
+      area = m_damage;
+    }
+#if WITH_XSHM
+    // Only upload the part of the frame that changed
+    if (m_shm && m_damage.width != 0 && m_damage.height != 0) {
+      m_shm->put(m_pixmap, m_gcontext, m_damage);
+    }
+#endif
+    m_damage = xcb_rectangle_t{0, 0, 0U, 0U};
+    if (area.width != 0 && area.height != 0) {
+      m_connection.copy_area(
+          m_pixmap, m_window, m_gcontext, area.x, area.y, area.x, area.y, area.width, area.height);
+    }
+    m_connection.flush();
+  }
 
   if (!m_snapshot_dst.empty()) {
     try {
@@ -439,83 +592,7 @@ void renderer::flush() {
  * The position is relative to m_rect.x (the left side of the bar w/o borders and tray)
  */
 double renderer::block_x(alignment a) const {
-  switch (a) {
-    case alignment::CENTER: {
-      // The leftmost x position this block can start at
-      double min_pos = block_w(alignment::LEFT);
-
-      if (min_pos != 0) {
-        min_pos += BLOCK_GAP;
-      }
-
-      double right_width = block_w(alignment::RIGHT);
-      /*
-       * The rightmost x position this block can end at
-       *
-       * We can't use block_x(alignment::RIGHT) because that would lead to infinite recursion
-       */
-      double max_pos = m_rect.width - right_width;
-
-      if (right_width != 0) {
-        max_pos -= BLOCK_GAP;
-      }
-
-      /*
-       * x position of the center of this block
-       *
-       * With fixed-center this will be the center of the bar unless it is pushed to the left by a large right block
-       * Without fixed-center this will be the middle between the end of the left and the start of the right block.
-       */
-      double base_pos{0.0};
-
-      if (m_fixedcenter) {
-        /*
-         * This is in the middle of the *bar*. Not just the middle of m_rect because this way we need to account for the
-         * tray.
-         *
-         * The resulting position is relative to the very left of the bar (including border and tray), so we need to
-         * compensate for that by subtracting m_rect.x
-         */
-        base_pos = m_bar.size.w / 2.0 - m_rect.x;
-
-        /*
-         * The center block can be moved to the left if the right block is too large
-         */
-        base_pos = std::min(base_pos, max_pos - block_w(a) / 2.0);
-      }
-      else {
-        base_pos = (min_pos + max_pos) / 2.0;
-      }
-
-      /*
-       * The left block always has priority (even with fixed-center = true)
-       */
-      return std::max(base_pos - block_w(a) / 2.0, min_pos);
-    }
-    case alignment::RIGHT: {
-      /*
-       * The block immediately to the left of this block
-       *
-       * Generally the center block unless it is empty.
-       */
-      alignment left_barrier = alignment::CENTER;
-
-      if (block_w(alignment::CENTER) == 0) {
-        left_barrier = alignment::LEFT;
-      }
-
-      // The minimum x position this block can start at
-      double min_pos = block_x(left_barrier) + block_w(left_barrier);
-
-      if (block_w(left_barrier) != 0) {
-        min_pos += BLOCK_GAP;
-      }
-
-      return std::max(m_rect.width - block_w(a), min_pos);
-    }
-    default:
-      return 0.0;
-  }
+  return m_layout.get(a).x;
 }
 
 /**
@@ -529,7 +606,7 @@ double renderer::block_y(alignment) const {
  * Get block width for given alignment
  */
 double renderer::block_w(alignment a) const {
-  return m_blocks.at(a).x;
+  return m_layout.get(a).width;
 }
 
 /**
@@ -665,41 +742,87 @@ void renderer::fill_borders() {
   m_context->restore();
 }
 
-unsigned int renderer::parse_color(const string& value, unsigned int fallback) {
-  if (value.compare(0, 5, "anim:") == 0) {
-    m_anim_used = true;
-    return parse_animated_color(m_conf, value.substr(5))->get(m_time);
-  }
-  if (!value.empty() && value[0] != '-') {
-		return color_util::parse(value, fallback);
+/**
+ * Get the current value of a tag color
+ *
+ * Animations are loaded the first time they are used
+ */
+unsigned int renderer::resolve_color(const tag_color& color, unsigned int fallback) {
+  switch (color.kind) {
+    case tag_color::type::PLAIN:
+      return color.value;
+    case tag_color::type::ANIMATED: {
+      m_anim_used = true;
+      auto& anim = m_animations[color.anim];
+      if (!anim) {
+        anim = parse_animated_color(m_conf, *color.anim);
+      }
+      return anim->get(m_time);
+    }
+    default:
+      return fallback;
   }
-  return fallback;
 }
 
 void renderer::draw_text(const string& contents) {
-  cairo::abspos origin{};
-  origin.x = m_rect.x + m_blocks[m_align].x;
-  origin.y = m_rect.y + m_rect.height / 2.0;
+  TRACE_SCOPE("renderer::draw_text");
+  auto& current = m_blocks[m_align];
 
   cairo::textblock block{};
   block.align = m_align;
-  block.contents = contents;
+  block.contents = &contents;
   block.font = m_font;
-  block.x_advance = &m_blocks[m_align].x;
-  block.y_advance = &m_blocks[m_align].y;
-	block.bg = parse_color(m_bg, m_bar.background);
+  block.x_advance = &current.x;
+  block.y_advance = &current.y;
+
+  if (m_measuring) {
+    double x = current.x;
+    block.measure_only = true;
+    *m_context << block;
+    m_run_widths.emplace_back(current.x - x);
+    return;
+  }
+
+  // Runs past the visible part of the block wouldn't show up anyway, they
+  // only have to advance the block like they did in the measure pass
+  double width = m_run < m_run_widths.size() ? m_run_widths[m_run] : 0.0;
+  m_run++;
+  if (current.x >= m_layout.get(m_align).visible) {
+    current.x += width;
+    return;
+  }
+
+  double offset = block_x(m_align);
+
+  cairo::abspos origin{};
+  origin.x = m_rect.x + offset + current.x;
+  origin.y = m_rect.y + m_rect.height / 2.0;
+
+	block.bg = resolve_color(m_bg, m_bar.background);
   // Only draw text background if the color differs from
   // the background color of the bar itself
   // Note: this means that if the user explicitly set text
   // background color equal to background-0 it will be ignored
   if (block.bg != m_bar.background) {
     block.bg_operator = m_comp_bg;
-    block.bg_rect.x = m_rect.x;
+    block.bg_rect.x = m_rect.x + offset;
     block.bg_rect.y = m_rect.y;
     block.bg_rect.h = m_rect.height;
   } else block.bg = 0;
 
-  unsigned int fg = parse_color(m_fg, m_bar.foreground);
+  unsigned int fg = resolve_color(m_fg, m_bar.foreground);
+  bool underline = m_bar.underline.size && m_attr.test(static_cast<int>(attribute::UNDERLINE));
+  bool overline = m_bar.overline.size && m_attr.test(static_cast<int>(attribute::OVERLINE));
+  unsigned int ul = underline ? resolve_color(m_ul, m_bar.underline.color) : 0;
+  unsigned int ol = overline ? resolve_color(m_ol, m_bar.overline.color) : 0;
+
+  // Remember what this run looks like, see update_damage()
+  auto& hash = current.hash;
+  for (size_t value : {static_cast<size_t>(string_util::hash(contents)), static_cast<size_t>(m_font),
+           static_cast<size_t>(block.bg), static_cast<size_t>(fg), static_cast<size_t>(ul), static_cast<size_t>(ol),
+           std::hash<double>()(current.x)}) {
+    hash ^= value + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+  }
   
 	m_context->save();
   *m_context << origin;
@@ -708,12 +831,12 @@ void renderer::draw_text(const string& contents) {
   *m_context << block;
   m_context->restore();
 
-  double dx = m_rect.x + m_blocks[m_align].x - origin.x;
+  double dx = m_rect.x + offset + current.x - origin.x;
   if (dx > 0.0) {
-  	if (m_bar.underline.size && m_attr.test(static_cast<int>(attribute::UNDERLINE)))
-    	fill_overline(origin.x, dx, parse_color(m_ul, m_bar.underline.color));
-  	if (m_bar.overline.size && m_attr.test(static_cast<int>(attribute::OVERLINE)))
-    	fill_underline(origin.x, dx, parse_color(m_ol, m_bar.overline.color));
+  	if (underline)
+    	fill_overline(origin.x, dx, ul);
+  	if (overline)
+    	fill_underline(origin.x, dx, ol);
   }
 }
 
@@ -758,36 +881,36 @@ bool renderer::on(const signals::ui::request_snapshot& evt) {
 }
 
 bool renderer::on(const signals::parser::change_background& evt) {
-  const auto color{evt.cast()};
+  const auto& color = evt.cast();
   if (color != m_bg) {
-    m_log.trace_x("renderer: change_background(%s)", color);
+    m_log.trace_x("renderer: change_background(#%08x)", color.value);
     m_bg = color;
   }
   return true;
 }
 
 bool renderer::on(const signals::parser::change_foreground& evt) {
-  const auto color{evt.cast()};
+  const auto& color = evt.cast();
   if (color != m_fg) {
-    m_log.trace_x("renderer: change_foreground(%s)", color);
+    m_log.trace_x("renderer: change_foreground(#%08x)", color.value);
     m_fg = color;
   }
   return true;
 }
 
 bool renderer::on(const signals::parser::change_underline& evt) {
-  const auto color{evt.cast()};
+  const auto& color = evt.cast();
   if (color != m_ul) {
-    m_log.trace_x("renderer: change_underline(%s)", color);
+    m_log.trace_x("renderer: change_underline(#%08x)", color.value);
     m_ul = color;
   }
   return true;
 }
 
 bool renderer::on(const signals::parser::change_overline& evt) {
-  const auto color{evt.cast()};
+  const auto& color = evt.cast();
   if (color != m_ol) {
-    m_log.trace_x("renderer: change_overline(%s)", color);
+    m_log.trace_x("renderer: change_overline(#%08x)", color.value);
     m_ol = color;
   }
   return true;
@@ -807,18 +930,25 @@ bool renderer::on(const signals::parser::change_alignment& evt) {
   if (align != m_align) {
     m_log.trace_x("renderer: change_alignment(%i)", static_cast<int>(align));
 
-    if (m_align != alignment::NONE) {
-      m_log.trace_x("renderer: pop(%i)", static_cast<int>(m_align));
-      m_context->pop(&m_blocks[m_align].pattern);
+    if (!m_measuring && m_align != alignment::NONE) {
+      m_context->restore();
     }
 
     m_align = align;
     m_blocks[m_align].x = 0.0;
     m_blocks[m_align].y = 0.0;
-    m_context->push();
-    m_log.trace_x("renderer: push(%i)", static_cast<int>(m_align));
 
-    fill_background();
+    if (!m_measuring) {
+      // Restrict drawing to the block rectangle
+      m_context->save();
+      // clang-format off
+      m_context->clip(cairo::rect{
+          m_rect.x + block_x(m_align),
+          m_rect.y + block_y(m_align),
+          m_layout.get(m_align).visible,
+          block_h(m_align)});
+      // clang-format on
+    }
   }
   return true;
 }
@@ -856,26 +986,35 @@ bool renderer::on(const signals::parser::attribute_toggle& evt) {
 }
 
 bool renderer::on(const signals::parser::action_begin& evt) {
-  auto a = evt.cast();
+  if (!m_measuring) {
+    return true;
+  }
+  const auto& a = evt.cast();
   m_log.trace_x("renderer: action_begin(btn=%i, command=%s)", static_cast<int>(a.button), a.command);
-  action_block action{};
+  if (m_num_actions == m_actions.size()) {
+    m_actions.emplace_back();
+  }
+  auto& action = m_actions[m_num_actions++];
   action.button = a.button == mousebtn::NONE ? mousebtn::LEFT : a.button;
   action.align = m_align;
   action.start_x = m_blocks.at(m_align).x;
+  action.end_x = 0.0;
   action.command = a.command;
   action.active = true;
-  m_actions.emplace_back(action);
   return true;
 }
 
 bool renderer::on(const signals::parser::action_end& evt) {
+  if (!m_measuring) {
+    return true;
+  }
   auto btn = evt.cast();
 
   /*
    * Iterate actions in reverse and find the FIRST active action that matches
    */
   m_log.trace_x("renderer: action_end(btn=%i)", static_cast<int>(btn));
-  for (auto action = m_actions.rbegin(); action != m_actions.rend(); action++) {
+  for (auto action = m_actions.rend() - m_num_actions; action != m_actions.rend(); action++) {
     if (action->active && action->align == m_align && action->button == btn) {
       action->end_x = m_blocks.at(action->align).x;
       action->active = false;
@@ -886,8 +1025,7 @@ bool renderer::on(const signals::parser::action_end& evt) {
 }
 
 bool renderer::on(const signals::parser::text& evt) {
-  auto text = evt.cast();
-  draw_text(text);
+  draw_text(evt.cast());
   return true;
 }
 
@@ -896,12 +1034,7 @@ bool renderer::on(const signals::parser::control& evt) {
 
   switch (ctrl) {
     case controltag::R:
-      m_bg = "";
-      m_fg = "";
-      m_ul = "";
-      m_ol = "";
-      m_font = 0;
-      m_attr.reset();
+      reset_state();
       break;
 
     case controltag::NONE:
@@ -911,4 +1044,9 @@ bool renderer::on(const signals::parser::control& evt) {
   return true;
 }
 
+bool renderer::on(const signals::ui::update_background&) {
+  m_redraw_all = true;
+  return false;
+}
+
 POLYBAR_NS_END
@@ -1,6 +1,8 @@
-#include <algorithm>
+#include <sys/timerfd.h>
+#include <unistd.h>
 
 #include "components/taskqueue.hpp"
+#include "errors.hpp"
 #include "utils/factory.hpp"
 
 POLYBAR_NS
@@ -9,102 +11,195 @@ taskqueue::make_type taskqueue::make() {
   return factory_util::unique<taskqueue>();
 }
 
-taskqueue::taskqueue() {
-  m_thread = std::thread([&] {
-    while (m_active) {
-      std::unique_lock<std::mutex> guard(m_lock);
-
-      if (m_deferred.empty()) {
-        m_hold.wait(guard);
-      } else {
-        auto now = deferred::clock::now();
-        auto wait = m_deferred.front()->now + m_deferred.front()->wait;
-        for (auto&& task : m_deferred) {
-          auto when = task->now + task->wait;
-          if (when < wait) {
-            wait = move(when);
-          }
-        }
-        if (wait > now) {
-          m_hold.wait_for(guard, wait - now);
-        }
-      }
-      if (!m_deferred.empty()) {
-        guard.unlock();
-        tick();
-      }
-    }
-  });
-}
-
-taskqueue::~taskqueue() {
-  if (m_active && m_thread.joinable()) {
-    m_active = false;
-    m_hold.notify_all();
-    m_thread.join();
+taskqueue::taskqueue() : m_timerfd(timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC)) {
+  if (!m_timerfd) {
+    throw system_error("Failed to create timerfd");
   }
 }
 
+/**
+ * Add a task, tasks with an existing id are kept
+ */
 void taskqueue::defer(
     string id, deferred::duration ms, deferred::callback fn, deferred::duration offset, size_t count) {
-  std::unique_lock<std::mutex> guard(m_lock);
+  std::lock_guard<std::mutex> guard(m_lock);
   deferred::timepoint now{chrono::time_point_cast<deferred::duration>(deferred::clock::now() + move(offset))};
-  m_deferred.emplace_back(make_unique<deferred>(move(id), move(now), move(ms), move(fn), move(count)));
-  guard.unlock();
-  m_hold.notify_one();
+  push(make_unique<deferred>(move(id), move(now), move(ms), move(fn), move(count)));
+  arm();
 }
 
+/**
+ * Add a task, replacing all tasks with the same id
+ */
 void taskqueue::defer_unique(
     string id, deferred::duration ms, deferred::callback fn, deferred::duration offset, size_t count) {
-  purge(id);
-  std::unique_lock<std::mutex> guard(m_lock);
+  std::lock_guard<std::mutex> guard(m_lock);
+  auto range = m_ids.equal_range(id);
+  while (range.first != range.second) {
+    remove((range.first++)->second->index);
+  }
   deferred::timepoint now{chrono::time_point_cast<deferred::duration>(deferred::clock::now() + move(offset))};
-  m_deferred.emplace_back(make_unique<deferred>(move(id), move(now), move(ms), move(fn), move(count)));
-  guard.unlock();
-  m_hold.notify_one();
+  push(make_unique<deferred>(move(id), move(now), move(ms), move(fn), move(count)));
+  arm();
 }
 
-void taskqueue::tick() {
-  if (!m_lock.try_lock()) {
-    return;
+bool taskqueue::exist(const string& id) {
+  std::lock_guard<std::mutex> guard(m_lock);
+  return m_ids.find(id) != m_ids.end();
+}
+
+/**
+ * Remove all tasks with the given id
+ *
+ * Returns false if there were none
+ */
+bool taskqueue::purge(const string& id) {
+  std::lock_guard<std::mutex> guard(m_lock);
+  auto range = m_ids.equal_range(id);
+  if (range.first == range.second) {
+    return false;
+  }
+  while (range.first != range.second) {
+    remove((range.first++)->second->index);
+  }
+  arm();
+  return true;
+}
+
+/**
+ * Descriptor that becomes readable once a task is due
+ */
+int taskqueue::get_file_descriptor() const {
+  return m_timerfd;
+}
+
+/**
+ * Run all tasks that are due
+ *
+ * Repeated tasks are rescheduled, all others are removed before their
+ * callback runs. Callbacks are called without holding the lock, so they
+ * may defer or purge tasks themselves.
+ */
+void taskqueue::process() {
+  uint64_t expirations;
+  if (read(m_timerfd, &expirations, sizeof(expirations)) == -1 && errno != EAGAIN) {
+    throw system_error("Failed to read timerfd");
   }
-  std::unique_lock<std::mutex> guard(m_lock, std::adopt_lock);
+
+  std::unique_lock<std::mutex> guard(m_lock);
   auto now = chrono::time_point_cast<deferred::duration>(deferred::clock::now());
   vector<pair<deferred::callback, size_t>> cbs;
-  for (auto it = m_deferred.rbegin(); it != m_deferred.rend(); ++it) {
-    auto& task = *it;
-    if (task->now + task->wait > now) {
+
+  while (!m_heap.empty() && m_heap.front()->deadline() <= now) {
+    auto& task = *m_heap.front();
+    if (task.count == 0) {
+      remove(0);
       continue;
-    } else if (task->count--) {
-      cbs.emplace_back(make_pair(task->func, task->count));
-      task->now = now;
+    }
+
+    cbs.emplace_back(make_pair(task.func, --task.count));
+    if (task.count > 0) {
+      task.now = now;
+      sift_down(0);
     } else {
-      m_deferred.erase(std::remove_if(m_deferred.begin(), m_deferred.end(),
-                           [&](const unique_ptr<deferred>& d) { return d == task; }),
-          m_deferred.end());
+      remove(0);
     }
   }
+
+  arm();
   guard.unlock();
+
   for (auto&& p : cbs) {
     p.first(p.second);
   }
 }
 
-bool taskqueue::purge(const string& id) {
-  std::lock_guard<std::mutex> guard(m_lock);
-  return m_deferred.erase(std::remove_if(m_deferred.begin(), m_deferred.end(),
-                              [id](const unique_ptr<deferred>& d) { return d->id == id; }),
-             m_deferred.end()) == m_deferred.end();
+/**
+ * Insert a task into the heap, the lock has to be held
+ */
+void taskqueue::push(unique_ptr<deferred>&& task) {
+  task->index = m_heap.size();
+  m_ids.emplace(task->id, task.get());
+  m_heap.emplace_back(move(task));
+  sift_up(m_heap.size() - 1);
 }
 
-bool taskqueue::exist(const string& id) {
-  std::lock_guard<std::mutex> guard(m_lock);
-  for (const auto& task : m_deferred) {
-    if (task->id == id) {
-      return true;
+/**
+ * Remove the task at the given heap position, the lock has to be held
+ */
+void taskqueue::remove(size_t index) {
+  auto range = m_ids.equal_range(m_heap[index]->id);
+  for (auto it = range.first; it != range.second; ++it) {
+    if (it->second == m_heap[index].get()) {
+      m_ids.erase(it);
+      break;
     }
   }
-  return false;
+
+  size_t last = m_heap.size() - 1;
+  if (index != last) {
+    swap(index, last);
+  }
+  m_heap.pop_back();
+
+  if (index < m_heap.size()) {
+    sift_up(index);
+    sift_down(index);
+  }
+}
+
+void taskqueue::sift_up(size_t index) {
+  while (index > 0) {
+    size_t parent = (index - 1) / 2;
+    if (m_heap[parent]->deadline() <= m_heap[index]->deadline()) {
+      break;
+    }
+    swap(parent, index);
+    index = parent;
+  }
+}
+
+void taskqueue::sift_down(size_t index) {
+  while (true) {
+    size_t smallest = index;
+    for (size_t child : {2 * index + 1, 2 * index + 2}) {
+      if (child < m_heap.size() && m_heap[child]->deadline() < m_heap[smallest]->deadline()) {
+        smallest = child;
+      }
+    }
+    if (smallest == index) {
+      break;
+    }
+    swap(smallest, index);
+    index = smallest;
+  }
+}
+
+void taskqueue::swap(size_t a, size_t b) {
+  std::swap(m_heap[a], m_heap[b]);
+  m_heap[a]->index = a;
+  m_heap[b]->index = b;
+}
+
+/**
+ * Set the timer to the earliest deadline, or disarm it if there are no tasks
+ */
+void taskqueue::arm() {
+  itimerspec spec{};
+
+  if (!m_heap.empty()) {
+    auto deadline = chrono::duration_cast<chrono::nanoseconds>(m_heap.front()->deadline().time_since_epoch());
+    // A zero value would disarm the timer
+    if (deadline.count() <= 0) {
+      deadline = 1ns;
+    }
+    spec.it_value.tv_sec = chrono::duration_cast<chrono::seconds>(deadline).count();
+    spec.it_value.tv_nsec = (deadline % 1s).count();
+  }
+
+  if (timerfd_settime(m_timerfd, TFD_TIMER_ABSTIME, &spec, nullptr) == -1) {
+    throw system_error("Failed to arm timerfd");
+  }
 }
 
 POLYBAR_NS_END
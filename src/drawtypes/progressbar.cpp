@@ -10,7 +10,38 @@ POLYBAR_NS
 
 namespace drawtypes {
   progressbar::progressbar(const bar_settings& bar, int width, string format)
-      : m_builder(factory_util::unique<builder>(bar)), m_format(move(format)), m_width(width) {}
+      : m_builder(factory_util::unique<builder>(bar)), m_width(width) {
+    // Split the format at its tokens once, so that output() can write
+    // every part straight into the builder
+    const std::pair<const char*, segment_type> tokens[]{
+        {"%fill%", segment_type::FILL}, {"%indicator%", segment_type::INDICATOR}, {"%empty%", segment_type::EMPTY}};
+
+    size_t pos{0};
+    while (pos < format.size()) {
+      size_t next{string::npos};
+      segment_type type{segment_type::TEXT};
+      size_t token_len{0};
+
+      for (auto&& token : tokens) {
+        size_t found = format.find(token.first, pos);
+        if (found < next) {
+          next = found;
+          type = token.second;
+          token_len = strlen(token.first);
+        }
+      }
+
+      if (next != pos) {
+        m_segments.emplace_back(segment{segment_type::TEXT, format.substr(pos, next - pos)});
+      }
+      if (next == string::npos) {
+        break;
+      }
+
+      m_segments.emplace_back(segment{type, {}});
+      pos = next + token_len;
+    }
+  }
 
   void progressbar::set_fill(label_t&& fill) {
     m_fill = forward<decltype(fill)>(fill);
@@ -38,26 +69,29 @@ namespace drawtypes {
   }
 
   string progressbar::output(float percentage) {
-    string output{m_format};
-
     // Get fill/empty widths based on percentage
     unsigned int perc = math_util::cap(percentage, 0.0f, 100.0f);
     unsigned int fill_width = math_util::percentage_to_value(perc, m_width);
     unsigned int empty_width = m_width - fill_width;
 
-    // Output fill icons
-    fill(perc, fill_width);
-    output = string_util::replace_all(output, "%fill%", m_builder->flush());
-
-    // Output indicator icon
-    m_builder->node(m_indicator);
-    output = string_util::replace_all(output, "%indicator%", m_builder->flush());
-
-    // Output empty icons
-    m_builder->node_repeat(m_empty, empty_width);
-    output = string_util::replace_all(output, "%empty%", m_builder->flush());
+    for (auto&& seg : m_segments) {
+      switch (seg.type) {
+        case segment_type::TEXT:
+          m_builder->append(seg.text);
+          break;
+        case segment_type::FILL:
+          fill(perc, fill_width);
+          break;
+        case segment_type::INDICATOR:
+          m_builder->node(m_indicator);
+          break;
+        case segment_type::EMPTY:
+          m_builder->node_repeat(m_empty, empty_width);
+          break;
+      }
+    }
 
-    return output;
+    return m_builder->flush();
   }
 
   void progressbar::fill(unsigned int perc, unsigned int fill_width) {
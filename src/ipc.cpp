@@ -1,10 +1,15 @@
 #include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
 #include <algorithm>
 #include <cstdlib>
 #include <cstring>
 #include <vector>
 
 #include "common.hpp"
+#include "components/ipc_msg.hpp"
 #include "utils/file.hpp"
 #include "utils/io.hpp"
 
@@ -14,13 +19,23 @@ using namespace std;
 #ifndef IPC_CHANNEL_PREFIX
 #define IPC_CHANNEL_PREFIX "/tmp/polybar_mqueue."
 #endif
+#ifndef IPC_SOCKET_PREFIX
+#define IPC_SOCKET_PREFIX "/tmp/polybar_ipc."
+#endif
+#ifndef IPC_SOCKET_SUFFIX
+#define IPC_SOCKET_SUFFIX ".sock"
+#endif
 
 void display(const string& msg) {
   fprintf(stdout, "%s\n", msg.c_str());
 }
 
-void log(int exit_code, const string& msg) {
+void error(const string& msg) {
   fprintf(stderr, "polybar-msg: %s\n", msg.c_str());
+}
+
+void log(int exit_code, const string& msg) {
+  error(msg);
   exit(exit_code);
 }
 
@@ -41,12 +56,88 @@ bool validate_type(const string& type) {
   return (type == "action" || type == "cmd" || type == "hook");
 }
 
+/**
+ * Extract the pid from a channel or socket path
+ */
+string channel_pid(const string& path) {
+  string name{path};
+  if (name.size() > strlen(IPC_SOCKET_SUFFIX) &&
+      name.compare(name.size() - strlen(IPC_SOCKET_SUFFIX), string::npos, IPC_SOCKET_SUFFIX) == 0) {
+    name.erase(name.size() - strlen(IPC_SOCKET_SUFFIX));
+  }
+  auto p = name.rfind('.');
+  return p == string::npos ? "" : name.substr(p + 1);
+}
+
+/**
+ * Read exactly len bytes, waiting at most timeout_ms for each chunk
+ */
+bool read_all(int fd, char* data, size_t len, int timeout_ms) {
+  size_t offset{0};
+  while (offset < len) {
+    struct pollfd pfd {
+      fd, POLLIN, 0
+    };
+    if (poll(&pfd, 1, timeout_ms) <= 0) {
+      return false;
+    }
+    ssize_t bytes = read(fd, data + offset, len - offset);
+    if (bytes == 0 || (bytes == -1 && errno != EINTR)) {
+      return false;
+    } else if (bytes > 0) {
+      offset += bytes;
+    }
+  }
+  return true;
+}
+
+/**
+ * Send all messages as a single request and wait for the acknowledgement
+ *
+ * \returns true if every message was handled
+ */
+bool send_request(const string& path, const vector<string>& messages, vector<string>& results) {
+  struct sockaddr_un addr {};
+  addr.sun_family = AF_UNIX;
+  strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+
+  file_descriptor fd(socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0));
+  if (connect(fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) == -1) {
+    throw std::runtime_error("Failed to connect to \"" + path + "\" (err: " + strerror(errno) + ")");
+  }
+
+  string frame{ipc_msg::encode(ipc_msg::type::REQUEST, messages)};
+  size_t offset{0};
+  while (offset < frame.size()) {
+    ssize_t bytes = send(fd, frame.data() + offset, frame.size() - offset, MSG_NOSIGNAL);
+    if (bytes == -1 && errno != EINTR) {
+      throw std::runtime_error("Failed to write to \"" + path + "\" (err: " + strerror(errno) + ")");
+    } else if (bytes > 0) {
+      offset += bytes;
+    }
+  }
+
+  ipc_msg::header hdr{};
+  if (!read_all(fd, reinterpret_cast<char*>(&hdr), sizeof(hdr), 5000) || !ipc_msg::valid(hdr)) {
+    throw std::runtime_error("No valid response from \"" + path + "\"");
+  }
+
+  string payload(hdr.size, '\0');
+  if (hdr.size > 0 && !read_all(fd, &payload[0], hdr.size, 5000)) {
+    throw std::runtime_error("Incomplete response from \"" + path + "\"");
+  }
+
+  results = ipc_msg::decode(payload);
+  return hdr.msg_type == ipc_msg::type::RESPONSE_OK;
+}
+
 int main(int argc, char** argv) {
   const int E_NO_CHANNELS{2};
   const int E_MESSAGE_TYPE{3};
   const int E_INVALID_PID{4};
   const int E_INVALID_CHANNEL{5};
   const int E_WRITE{6};
+  const int E_REJECTED{7};
 
   vector<string> args{argv + 1, argv + argc};
   string::size_type p;
@@ -69,61 +160,114 @@ int main(int argc, char** argv) {
   // Validate args
   auto help = find_if(args.begin(), args.end(), [](string a) { return a == "-h" || a == "--help"; }) != args.end();
   if (help || args.size() < 2) {
-    usage("<command=(action|cmd|hook)> <payload> [...]");
-  } else if (!validate_type(args[0])) {
-    log(E_MESSAGE_TYPE, "\"" + args[0] + "\" is not a valid type.");
+    usage("<command=(action|cmd|hook)> <payload> [...] [<command> <payload> [...]]...");
   }
 
-  string ipc_type{args[0]};
-  args.erase(args.begin());
-  string ipc_payload{args[0]};
-  args.erase(args.begin());
-
-  // Check hook specific args
-  if (ipc_type == "hook") {
-    if (args.size() != 1) {
-      usage("hook <module-name> <hook-index>");
-    } else if ((p = ipc_payload.find("module/")) != 0) {
-      ipc_payload = "module/" + ipc_payload + args[0];
-      args.erase(args.begin());
-    } else {
-      ipc_payload += args[0];
-      args.erase(args.begin());
+  // Several messages may be given, they are sent as one batch and processed in order
+  vector<string> messages;
+
+  while (!args.empty()) {
+    if (!validate_type(args[0])) {
+      log(E_MESSAGE_TYPE, "\"" + args[0] + "\" is not a valid type.");
+    } else if (args.size() < 2) {
+      usage("<command=(action|cmd|hook)> <payload> [...]");
     }
+
+    string ipc_type{args[0]};
+    args.erase(args.begin());
+    string ipc_payload{args[0]};
+    args.erase(args.begin());
+
+    // Check hook specific args
+    if (ipc_type == "hook") {
+      if (args.empty()) {
+        usage("hook <module-name> <hook-index>");
+      } else if ((p = ipc_payload.find("module/")) != 0) {
+        ipc_payload = "module/" + ipc_payload + args[0];
+        args.erase(args.begin());
+      } else {
+        ipc_payload += args[0];
+        args.erase(args.begin());
+      }
+    }
+
+    messages.emplace_back(ipc_type + ':' + ipc_payload);
   }
 
-  // Get availble channel pipes
+  // Get available sockets and channel pipes
+  auto sockets = file_util::glob(IPC_SOCKET_PREFIX + "*"s + IPC_SOCKET_SUFFIX);
   auto pipes = file_util::glob(IPC_CHANNEL_PREFIX + "*"s);
 
-  // Remove stale channel files without a running parent process
-  for (auto it = pipes.rbegin(); it != pipes.rend(); it++) {
-    if ((p = it->rfind('.')) == string::npos) {
-      continue;
-    } else if (!file_util::exists("/proc/" + it->substr(p + 1))) {
-      remove_pipe(*it);
-      pipes.erase(remove(pipes.begin(), pipes.end(), *it), pipes.end());
-    } else if (pid && to_string(pid) != it->substr(p + 1)) {
-      pipes.erase(remove(pipes.begin(), pipes.end(), *it), pipes.end());
+  // Remove stale files without a running parent process
+  for (auto* list : {&sockets, &pipes}) {
+    for (auto it = list->rbegin(); it != list->rend(); it++) {
+      string channel_owner{channel_pid(*it)};
+      if (channel_owner.empty()) {
+        continue;
+      } else if (!file_util::exists("/proc/" + channel_owner)) {
+        remove_pipe(*it);
+        list->erase(remove(list->begin(), list->end(), *it), list->end());
+      } else if (pid && to_string(pid) != channel_owner) {
+        list->erase(remove(list->begin(), list->end(), *it), list->end());
+      }
     }
   }
 
-  if (pipes.empty()) {
+  if (sockets.empty() && pipes.empty()) {
     log(E_NO_CHANNELS, "No active ipc channels");
   }
 
   int exit_status = 127;
 
-  // Write message to each available channel or match
-  // against pid if one was defined
+  // Send the messages to each socket and report the acknowledgements
+  for (auto&& path : sockets) {
+    try {
+      vector<string> results;
+      bool success = send_request(path, messages, results);
+      for (size_t i = 0; i < messages.size(); i++) {
+        string result{i < results.size() ? results[i] : "error:no response"};
+        display("\"" + messages[i] + "\" -> \"" + path + "\": " + result);
+      }
+      if (success) {
+        exit_status = exit_status == 127 ? 0 : exit_status;
+      } else {
+        exit_status = E_REJECTED;
+      }
+    } catch (const exception& err) {
+      // Keep going, the other instances may still be reachable
+      error(err.what());
+      exit_status = E_WRITE;
+    }
+  }
+
+  // Instances without a socket only have the fifo, which gives no feedback
   for (auto&& channel : pipes) {
+    string channel_owner{channel_pid(channel)};
+    bool has_socket = find_if(sockets.begin(), sockets.end(), [&](const string& s) {
+      return channel_pid(s) == channel_owner;
+    }) != sockets.end();
+
+    if (has_socket) {
+      continue;
+    }
+
     try {
       file_descriptor fd(channel, O_WRONLY | O_NONBLOCK);
-      string payload{ipc_type + ':' + ipc_payload};
-      if (write(fd, payload.c_str(), payload.size()) != -1) {
-        display("Successfully wrote \"" + payload + "\" to \"" + channel + "\"");
-        exit_status = 0;
+
+      // The bar splits the fifo input on newlines, send the whole batch at once
+      string batch;
+      for (auto&& payload : messages) {
+        batch += payload + '\n';
+      }
+
+      if (write(fd, batch.c_str(), batch.size()) == static_cast<ssize_t>(batch.size())) {
+        for (auto&& payload : messages) {
+          display("Successfully wrote \"" + payload + "\" to \"" + channel + "\"");
+        }
+        exit_status = exit_status == 127 ? 0 : exit_status;
       } else {
-        log(E_WRITE, "Failed to write \"" + payload + "\" to \"" + channel + "\" (err: " + strerror(errno) + ")");
+        error("Failed to write to \"" + channel + "\" (err: " + strerror(errno) + ")");
+        exit_status = E_WRITE;
       }
     } catch (const exception& err) {
       remove_pipe(channel);
@@ -29,8 +29,9 @@ namespace modules {
     if (m_formatter->has(TAG_DATE)) {
       m_log.warn("%s: The format tag `<date>` is deprecated, use `<label>` instead.", name());
 
-      m_formatter->get(DEFAULT_FORMAT)->value =
-          string_util::replace_all(m_formatter->get(DEFAULT_FORMAT)->value, TAG_DATE, TAG_LABEL);
+      auto format = m_formatter->get(DEFAULT_FORMAT);
+      format->value = string_util::replace_all(format->value, TAG_DATE, TAG_LABEL);
+      format->compile();
     }
 
     if (m_formatter->has(TAG_LABEL)) {
@@ -24,6 +24,8 @@ namespace modules {
     }
 
     m_interval = m_conf.get<decltype(m_interval)>(name(), "interval", 60s);
+    // Updates wait for the api request
+    m_blocking = true;
     m_empty_notifications = m_conf.get(name(), "empty-notifications", m_empty_notifications);
 
     m_formatter->add(DEFAULT_FORMAT, TAG_LABEL, {TAG_LABEL});
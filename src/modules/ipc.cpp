@@ -1,3 +1,5 @@
+#include <sys/wait.h>
+
 #include "modules/ipc.hpp"
 
 #include "components/ipc.hpp"
@@ -102,14 +104,19 @@ namespace modules {
    * Map received message hook to the ones
    * configured from the user config and
    * execute its command
+   *
+   * \returns true if a hook matched, result describes the hooks that failed
    */
-  void ipc_module::on_message(const string& message) {
+  bool ipc_module::on_message(const string& message, string& result) {
+    bool matched{false};
+
     for (auto&& hook : m_hooks) {
       if (hook->payload != message) {
         continue;
       }
 
       m_log.info("%s: Found matching hook (%s)", name(), hook->payload);
+      matched = true;
 
       try {
         // Clear the output in case the command produces no output
@@ -117,13 +124,23 @@ namespace modules {
         auto command = command_util::make_command<output_policy::REDIRECTED>(hook->command);
         command->exec(false);
         command->tail([this](string line) { m_output = line; });
+
+        int status = command->wait();
+        if (WIFSIGNALED(status)) {
+          result = hook->payload + ": hook command was killed by signal " + to_string(WTERMSIG(status));
+        } else if (WEXITSTATUS(status) != 0) {
+          result = hook->payload + ": hook command exited with status " + to_string(WEXITSTATUS(status));
+        }
       } catch (const exception& err) {
         m_log.err("%s: Failed to execute hook command (err: %s)", err.what());
         m_output.clear();
+        result = hook->payload + ": " + err.what();
       }
 
       broadcast();
     }
+
+    return matched;
   }
 }  // namespace modules
 
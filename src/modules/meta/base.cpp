@@ -9,6 +9,29 @@ POLYBAR_NS
 namespace modules {
   // module_format {{{
 
+  /**
+   * Split the format value into text and tags
+   *
+   * Has to be called again whenever the value is changed
+   */
+  void module_format::compile() {
+    ops.clear();
+
+    size_t pos{0};
+    size_t start, end;
+    while ((start = value.find('<', pos)) != string::npos && (end = value.find('>', start)) != string::npos) {
+      if (start > pos) {
+        string text{value.substr(pos, start - pos)};
+        string trimmed{string_util::ltrim(string{text}, ' ')};
+        ops.emplace_back(format_op{format_op::type::TEXT, move(text), move(trimmed)});
+      }
+      ops.emplace_back(format_op{format_op::type::TAG, value.substr(start, end - start + 1), {}});
+      pos = end + 1;
+    }
+
+    tail = value.substr(pos);
+  }
+
   string module_format::decorate(builder* builder, string output) {
     if (output.empty()) {
       builder->flush();
@@ -121,19 +144,15 @@ namespace modules {
     tag_collection.insert(tag_collection.end(), format->tags.begin(), format->tags.end());
     tag_collection.insert(tag_collection.end(), whitelist.begin(), whitelist.end());
 
-    size_t start, end;
-    string value{format->value};
-    while ((start = value.find('<')) != string::npos && (end = value.find('>', start)) != string::npos) {
-      if (start > 0) {
-        value.erase(0, start);
-        end -= start;
-        start = 0;
+    format->compile();
+
+    for (auto&& op : format->ops) {
+      if (op.kind != format_op::type::TAG) {
+        continue;
       }
-      string tag{value.substr(start, end + 1)};
-      if (find(tag_collection.begin(), tag_collection.end(), tag) == tag_collection.end()) {
-        throw undefined_format_tag(tag + " is not a valid format tag for \"" + name + "\"");
+      if (find(tag_collection.begin(), tag_collection.end(), op.value) == tag_collection.end()) {
+        throw undefined_format_tag(op.value + " is not a valid format tag for \"" + name + "\"");
       }
-      value.erase(0, tag.size());
     }
 
     m_formats.insert(make_pair(move(name), move(format)));
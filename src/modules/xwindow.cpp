@@ -43,19 +43,10 @@ namespace modules {
    * Get the title by returning the first non-empty value of:
    *  _NET_WM_NAME
    *  _NET_WM_VISIBLE_NAME
+   *  WM_NAME
    */
   string active_window::title() const {
-    string title;
-
-    if (!(title = ewmh_util::get_wm_name(m_window)).empty()) {
-      return title;
-    } else if (!(title = ewmh_util::get_visible_name(m_window)).empty()) {
-      return title;
-    } else if (!(title = icccm_util::get_wm_name(m_connection, m_window)).empty()) {
-      return title;
-    } else {
-      return "";
-    }
+    return ewmh_util::get_window_title(m_connection, m_window);
   }
 
   /**
@@ -106,9 +106,12 @@ namespace modules {
   void xworkspaces_module::handle(const evt::property_notify& evt) {
     std::lock_guard<std::mutex> lock(m_workspace_mutex);
 
-    if (evt->atom == m_ewmh->_NET_CLIENT_LIST || evt->atom == m_ewmh->_NET_WM_DESKTOP) {
+    if (evt->atom == m_ewmh->_NET_CLIENT_LIST) {
       rebuild_clientlist();
       rebuild_desktop_states();
+    } else if (evt->atom == m_ewmh->_NET_WM_DESKTOP) {
+      update_client_desktop(evt->window);
+      rebuild_desktop_states();
     } else if (evt->atom == m_ewmh->_NET_DESKTOP_NAMES || evt->atom == m_ewmh->_NET_NUMBER_OF_DESKTOPS) {
       m_desktop_names = get_desktop_names();
       rebuild_desktops();
@@ -138,17 +141,32 @@ namespace modules {
     vector<xcb_window_t> newclients = ewmh_util::get_client_list();
     std::sort(newclients.begin(), newclients.end());
 
+    // new clients: listen for changes (wm_hint or desktop)
+    vector<xcb_window_t> added;
     for (auto&& client : newclients) {
       if (m_clients.count(client) == 0) {
-        // new client: listen for changes (wm_hint or desktop)
-        m_connection.ensure_event_mask(client, XCB_EVENT_MASK_PROPERTY_CHANGE);
+        added.emplace_back(client);
       }
     }
+    if (!added.empty()) {
+      m_connection.ensure_event_mask(added, XCB_EVENT_MASK_PROPERTY_CHANGE);
+    }
 
-    // rebuild entire mapping of clients to desktops
+    // rebuild entire mapping of clients to desktops, the requests are pipelined
+    auto desktops = ewmh_util::get_desktops_from_windows(newclients);
     m_clients.clear();
-    for (auto&& client : newclients) {
-      m_clients[client] = ewmh_util::get_desktop_from_window(client);
+    for (size_t i = 0; i < newclients.size(); i++) {
+      m_clients.emplace_hint(m_clients.end(), newclients[i], desktops[i]);
+    }
+  }
+
+  /**
+   * Update the desktop of a single client after it was moved
+   */
+  void xworkspaces_module::update_client_desktop(xcb_window_t client) {
+    auto it = m_clients.find(client);
+    if (it != m_clients.end()) {
+      it->second = ewmh_util::get_desktop_from_window(client);
     }
   }
 
@@ -263,8 +281,10 @@ namespace modules {
   }
 
   vector<string> xworkspaces_module::get_desktop_names() {
-    vector<string> names = ewmh_util::get_desktop_names();
-    unsigned int desktops_number = ewmh_util::get_number_of_desktops();
+    auto names_cookie = ewmh_util::request_desktop_names();
+    auto number_cookie = ewmh_util::request_number_of_desktops();
+    vector<string> names = names_cookie.get();
+    unsigned int desktops_number = number_cookie.get();
     if (desktops_number == names.size()) {
       return names;
     } else if (desktops_number < names.size()) {
@@ -18,6 +18,7 @@ const char* const PATH_BATTERY{"@SETTING_PATH_BATTERY@"};
 const char* const PATH_CPU_INFO{"@SETTING_PATH_CPU_INFO@"};
 const char* const PATH_MEMORY_INFO{"@SETTING_PATH_MEMORY_INFO@"};
 const char* const PATH_MESSAGING_FIFO{"@SETTING_PATH_MESSAGING_FIFO@"};
+const char* const PATH_MESSAGING_SOCKET{"@SETTING_PATH_MESSAGING_SOCKET@"};
 const char* const PATH_TEMPERATURE_INFO{"@SETTING_PATH_TEMPERATURE_INFO@"};
 const char* const WIRELESS_LIB{"@WIRELESS_LIB@"};
 
@@ -43,13 +44,16 @@ void print_build_info(bool extended) {
     (ENABLE_XKEYBOARD  ? '+' : '-'));
   if (extended) {
     printf("\n");
-    printf("X extensions: %crandr (%cmonitors) %ccomposite %cxkb %cxrm %cxcursor\n",
+    printf("X extensions: %crandr (%cmonitors) %ccomposite %cxkb %cxrm %cxcursor %cshm\n",
       (WITH_XRANDR            ? '+' : '-'),
       (WITH_XRANDR_MONITORS   ? '+' : '-'),
       (WITH_XCOMPOSITE        ? '+' : '-'),
       (WITH_XKB               ? '+' : '-'),
       (WITH_XRM               ? '+' : '-'),
-      (WITH_XCURSOR           ? '+' : '-'));
+      (WITH_XCURSOR           ? '+' : '-'),
+      (WITH_XSHM              ? '+' : '-'));
+    printf("Font rendering: %charfbuzz\n",
+      (WITH_HARFBUZZ          ? '+' : '-'));
     printf("\n");
     printf("Build type: @CMAKE_BUILD_TYPE@\n");
     printf("Compiler: @CMAKE_CXX_COMPILER@\n");
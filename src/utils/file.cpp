@@ -3,7 +3,9 @@
 #include <dirent.h>
 #include <fcntl.h>
 #include <glob.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
+#include <unistd.h>
 
 #include <cstdio>
 #include <cstdlib>
@@ -104,6 +106,55 @@ void file_descriptor::close() {
   m_fd = -1;
 }
 
+// }}}
+// implementation of mapped_file {{{
+
+mapped_file::mapped_file(const string& path) {
+  int raw_fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (raw_fd == -1) {
+    throw system_error("Failed to open " + path);
+  }
+  file_descriptor fd(raw_fd);
+
+  struct stat st {};
+  if (fstat(fd, &st) == -1) {
+    throw system_error("Failed to stat " + path);
+  }
+
+  if (S_ISREG(st.st_mode) && st.st_size > 0) {
+    m_size = static_cast<size_t>(st.st_size);
+    m_map = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (m_map != MAP_FAILED) {
+      return;
+    }
+    m_map = nullptr;
+  }
+
+  char buffer[BUFSIZ];
+  ssize_t bytes;
+  while ((bytes = read(fd, buffer, sizeof(buffer))) > 0) {
+    m_buffer.append(buffer, bytes);
+  }
+  if (bytes == -1) {
+    throw system_error("Failed to read " + path);
+  }
+  m_size = m_buffer.size();
+}
+
+mapped_file::~mapped_file() {
+  if (m_map != nullptr) {
+    munmap(m_map, m_size);
+  }
+}
+
+const char* mapped_file::data() const {
+  return m_map != nullptr ? static_cast<const char*>(m_map) : m_buffer.data();
+}
+
+size_t mapped_file::size() const {
+  return m_size;
+}
+
 // }}}
 // implementation of file_streambuf {{{
 
@@ -8,7 +8,6 @@
 #include "utils/string.hpp"
 #include "x11/connection.hpp"
 #include "x11/ewmh.hpp"
-#include "x11/icccm.hpp"
 
 POLYBAR_NS
 
@@ -43,19 +42,9 @@ namespace i3_util {
    */
   xcb_window_t root_window(connection& conn) {
     auto children = conn.query_tree(conn.screen()->root).children();
-    const auto wm_name = [&](xcb_connection_t* conn, xcb_window_t win) -> string {
-      string title;
-      if (!(title = ewmh_util::get_wm_name(win)).empty()) {
-        return title;
-      } else if (!(title = icccm_util::get_wm_name(conn, win)).empty()) {
-        return title;
-      } else {
-        return "";
-      }
-    };
 
     for (auto it = children.begin(); it != children.end(); it++) {
-      if (wm_name(conn, *it) == "i3") {
+      if (ewmh_util::get_window_title(conn, *it, false) == "i3") {
         return *it;
       }
     }
@@ -59,6 +59,26 @@ namespace process_util {
     }
   }
 
+  /**
+   * Run command using shell in its own process group, without waiting for it
+   *
+   * The output is discarded. The caller is responsible for reaping the child
+   */
+  pid_t spawn_sh(const string& cmd) {
+    pid_t pid = fork();
+    if (pid == -1) {
+      throw system_error("Failed to fork process");
+    }
+
+    if (in_forked_process(pid)) {
+      setpgid(0, 0);
+      redirect_process_output_to_dev_null();
+      exec_sh(cmd.c_str());
+    }
+
+    return pid;
+  }
+
   /**
    * Wait for child process
    */
@@ -0,0 +1,375 @@
+#include "utils/trace.hpp"
+
+#include <unistd.h>
+
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <new>
+#include <sstream>
+
+#include "utils/concurrency.hpp"
+
+#ifdef DEBUG_ALLOCATIONS
+namespace {
+  /**
+   * Number of allocations made by the current thread,
+   * incremented by the replaced global operator new
+   */
+  thread_local uint64_t g_allocations{0};
+}  // namespace
+#endif
+
+POLYBAR_NS
+
+namespace trace_util {
+  // class : histogram {{{
+
+  /**
+   * Add a sample
+   */
+  void histogram::record(uint64_t ns) {
+    m_buckets[index(ns)].fetch_add(1, std::memory_order_relaxed);
+    m_count.fetch_add(1, std::memory_order_relaxed);
+
+    auto current = m_max.load(std::memory_order_relaxed);
+    while (ns > current && !m_max.compare_exchange_weak(current, ns, std::memory_order_relaxed)) {
+    }
+  }
+
+  /**
+   * Forget all samples
+   */
+  void histogram::reset() {
+    for (auto&& bucket : m_buckets) {
+      bucket.store(0, std::memory_order_relaxed);
+    }
+    m_count.store(0, std::memory_order_relaxed);
+    m_max.store(0, std::memory_order_relaxed);
+  }
+
+  uint64_t histogram::count() const {
+    return m_count.load(std::memory_order_relaxed);
+  }
+
+  uint64_t histogram::max() const {
+    return m_max.load(std::memory_order_relaxed);
+  }
+
+  /**
+   * Get the value below which the given fraction (0..1) of samples fall
+   */
+  uint64_t histogram::percentile(double p) const {
+    auto total = count();
+    if (total == 0) {
+      return 0;
+    }
+
+    auto rank = static_cast<uint64_t>(p * total + 0.5);
+    rank = std::max<uint64_t>(1, std::min(rank, total));
+
+    uint64_t seen{0};
+    for (size_t i = 0; i < BUCKETS; i++) {
+      seen += m_buckets[i].load(std::memory_order_relaxed);
+      if (seen >= rank) {
+        return std::min(upper_bound(i), max());
+      }
+    }
+
+    return max();
+  }
+
+  size_t histogram::index(uint64_t ns) {
+    if (ns < SUB_BUCKETS) {
+      return ns;
+    }
+    size_t msb = 63 - __builtin_clzll(ns);
+    size_t shift = msb - SUB_BITS;
+    size_t sub = (ns >> shift) & (SUB_BUCKETS - 1);
+    return (shift + 1) * SUB_BUCKETS + sub;
+  }
+
+  uint64_t histogram::upper_bound(size_t index) {
+    if (index < SUB_BUCKETS) {
+      return index;
+    }
+    size_t shift = index / SUB_BUCKETS - 1;
+    size_t sub = index % SUB_BUCKETS;
+    return ((SUB_BUCKETS + sub + 1) << shift) - 1;
+  }
+
+  // }}}
+
+  namespace {
+    /**
+     * Completed span as written to the chrome trace
+     */
+    struct span {
+      const stage* source;
+      size_t tid;
+      clock::time_point start;
+      clock::time_point end;
+    };
+
+    constexpr size_t CAPTURE_SIZE{1 << 16};
+
+    mutex g_stages_lock;
+    std::map<string, unique_ptr<stage>> g_stages;
+
+    std::atomic<bool> g_capturing{false};
+    // Number of threads currently writing a span
+    std::atomic<size_t> g_writers{0};
+    std::atomic<size_t> g_next_span{0};
+    clock::time_point g_capture_start;
+    vector<span> g_spans;
+
+    /**
+     * Stop capturing and wait for the spans still being written
+     */
+    void stop_writers() {
+      g_capturing = false;
+      while (g_writers.load(std::memory_order_acquire) != 0) {
+        this_thread::yield();
+      }
+    }
+
+    /**
+     * Escape a string for use in a JSON string literal
+     */
+    string json_escape(const string& value) {
+      std::stringstream ss;
+      for (unsigned char c : value) {
+        if (c == '"' || c == '\\') {
+          ss << '\\' << c;
+        } else if (c < 0x20) {
+          ss << "\\u" << std::hex << std::setw(4) << std::setfill('0') << static_cast<int>(c) << std::dec;
+        } else {
+          ss << c;
+        }
+      }
+      return ss.str();
+    }
+  }  // namespace
+
+  /**
+   * Get the measuring point with the given name,
+   * creating it on first use
+   *
+   * The returned reference stays valid for the lifetime of the process
+   */
+  stage& get_stage(const string& name) {
+    std::lock_guard<mutex> guard(g_stages_lock);
+    auto& s = g_stages[name];
+    if (!s) {
+      s = make_unique<stage>(name);
+    }
+    return *s;
+  }
+
+  /**
+   * Get the number of heap allocations made by the calling thread
+   *
+   * Always 0 unless built with DEBUG_ALLOCATIONS
+   */
+  uint64_t allocations() {
+#ifdef DEBUG_ALLOCATIONS
+    return g_allocations;
+#else
+    return 0;
+#endif
+  }
+
+  /**
+   * Record a finished span in the stage histogram and,
+   * while capturing, in the trace buffer
+   */
+  void record(stage& s, clock::time_point start, clock::time_point end, uint64_t allocs) {
+    s.hist.record(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
+    if (allocs > 0) {
+      s.allocations.fetch_add(allocs, std::memory_order_relaxed);
+    }
+
+    if (g_capturing.load(std::memory_order_relaxed)) {
+      /*
+       * Announce the write before checking again, so that stop_writers()
+       * either sees this thread or this thread sees the capture stopped
+       */
+      g_writers.fetch_add(1);
+      if (g_capturing.load()) {
+        static thread_local size_t tid{concurrency_util::thread_id(this_thread::get_id())};
+        auto slot = g_next_span.fetch_add(1, std::memory_order_relaxed);
+        if (slot < CAPTURE_SIZE) {
+          g_spans[slot] = span{&s, tid, start, end};
+        }
+      }
+      g_writers.fetch_sub(1, std::memory_order_release);
+    }
+  }
+
+  /**
+   * Start collecting spans for the chrome trace
+   *
+   * Collection stops by itself once the buffer is full
+   */
+  void start_capture() {
+    std::lock_guard<mutex> guard(g_stages_lock);
+    stop_writers();
+    if (g_spans.empty()) {
+      // Allocated once, so that late writers never see a reallocated buffer
+      g_spans.resize(CAPTURE_SIZE);
+    }
+    g_next_span = 0;
+    g_capture_start = clock::now();
+    g_capturing = true;
+  }
+
+  void stop_capture() {
+    stop_writers();
+  }
+
+  bool capturing() {
+    return g_capturing;
+  }
+
+  /**
+   * Write the captured spans in the chrome trace event format
+   *
+   * The file can be loaded in chrome://tracing or perfetto
+   */
+  bool dump(const string& path) {
+    stop_capture();
+
+    std::ofstream out(path);
+    if (!out) {
+      return false;
+    }
+
+    auto count = std::min(g_next_span.load(), CAPTURE_SIZE);
+    auto pid = getpid();
+
+    bool first{true};
+
+    out << "{\"traceEvents\":[";
+    for (size_t i = 0; i < count; i++) {
+      const auto& s = g_spans[i];
+      if (s.source == nullptr) {
+        continue;
+      }
+      auto ts = std::chrono::duration_cast<std::chrono::microseconds>(s.start - g_capture_start).count();
+      auto dur = std::chrono::duration_cast<std::chrono::microseconds>(s.end - s.start).count();
+      out << (first ? "\n" : ",\n");
+      first = false;
+      out << "{\"name\":\"" << json_escape(s.source->name) << "\",\"cat\":\"polybar\",\"ph\":\"X\",\"ts\":" << ts
+          << ",\"dur\":" << dur << ",\"pid\":" << pid << ",\"tid\":" << s.tid << "}";
+    }
+    out << "\n]}\n";
+
+    return static_cast<bool>(out);
+  }
+
+  /**
+   * Get a table with the latency percentiles of all stages
+   *
+   * When built with DEBUG_ALLOCATIONS, the average number of heap
+   * allocations per run of the stage is added as the last column
+   */
+  string summary() {
+    std::lock_guard<mutex> guard(g_stages_lock);
+    std::stringstream ss;
+
+    const auto us = [](uint64_t ns) { return static_cast<double>(ns) / 1000.0; };
+
+    ss << std::left << std::setw(40) << "stage" << std::right << std::setw(10) << "count" << std::setw(12) << "p50 us"
+       << std::setw(12) << "p90 us" << std::setw(12) << "p99 us" << std::setw(12) << "max us";
+#ifdef DEBUG_ALLOCATIONS
+    ss << std::setw(12) << "allocs";
+#endif
+    ss << "\n";
+    ss << std::fixed << std::setprecision(1);
+
+    for (const auto& entry : g_stages) {
+      const auto& hist = entry.second->hist;
+      if (hist.count() == 0) {
+        continue;
+      }
+      ss << std::left << std::setw(40) << entry.first << std::right << std::setw(10) << hist.count() << std::setw(12)
+         << us(hist.percentile(0.5)) << std::setw(12) << us(hist.percentile(0.9)) << std::setw(12)
+         << us(hist.percentile(0.99)) << std::setw(12) << us(hist.max());
+#ifdef DEBUG_ALLOCATIONS
+      ss << std::setw(12) << static_cast<double>(entry.second->allocations) / hist.count();
+#endif
+      ss << "\n";
+    }
+
+    return ss.str();
+  }
+
+  /**
+   * Reset the histograms of all stages
+   */
+  void reset() {
+    std::lock_guard<mutex> guard(g_stages_lock);
+    for (auto&& entry : g_stages) {
+      entry.second->hist.reset();
+      entry.second->allocations = 0;
+    }
+  }
+}  // namespace trace_util
+
+POLYBAR_NS_END
+
+#ifdef DEBUG_ALLOCATIONS
+// Replaced global allocation functions {{{
+
+void* operator new(std::size_t size) {
+  g_allocations++;
+  if (size == 0) {
+    size = 1;
+  }
+  while (true) {
+    if (void* ptr = std::malloc(size)) {
+      return ptr;
+    }
+    auto handler = std::get_new_handler();
+    if (handler == nullptr) {
+      throw std::bad_alloc();
+    }
+    handler();
+  }
+}
+
+void* operator new[](std::size_t size) {
+  return operator new(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+  try {
+    return operator new(size);
+  } catch (const std::bad_alloc&) {
+    return nullptr;
+  }
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+  return operator new(size, std::nothrow);
+}
+
+void operator delete(void* ptr) noexcept {
+  std::free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept {
+  std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept {
+  std::free(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t) noexcept {
+  std::free(ptr);
+}
+
+// }}}
+#endif
@@ -47,7 +47,8 @@ std::shared_ptr<bg_slice> background_manager::observe(xcb_rectangle_t rect, xcb_
   }
 
   m_slices.push_back(slice);
-  fetch_root_pixmap();
+  // only the new slice needs to be filled
+  fetch_root_pixmap(false);
   return slice;
 }
 
@@ -72,41 +73,82 @@ void background_manager::free_resources() {
   m_visual = nullptr;
 }
 
-void background_manager::fetch_root_pixmap() {
+/**
+ * Copy the root pixmap into all observed slices
+ *
+ * Unless force is set, slices that were already filled from the same root
+ * pixmap at the same position are left alone. The position lookups for all
+ * slices are pipelined and the copies are not checked, so this costs a single
+ * round trip on top of finding the root pixmap.
+ *
+ * Returns true if any slice was updated.
+ */
+bool background_manager::fetch_root_pixmap(bool force) {
   m_log.trace("background_manager: Fetching pixmap");
 
   int pixmap_depth;
   xcb_pixmap_t pixmap;
   xcb_rectangle_t pixmap_geom;
+  bool changed{false};
 
   try {
     if (!m_connection.root_pixmap(&pixmap, &pixmap_depth, &pixmap_geom)) {
-      return m_log.warn("background_manager: Failed to get root pixmap, default to black (is there a wallpaper?)");
+      m_log.warn("background_manager: Failed to get root pixmap, default to black (is there a wallpaper?)");
+      return false;
     };
     m_log.trace("background_manager: root pixmap (%d:%d) %dx%d+%d+%d", pixmap, pixmap_depth,
                 pixmap_geom.width, pixmap_geom.height, pixmap_geom.x, pixmap_geom.y);
 
     if (pixmap_depth == 1 && pixmap_geom.width == 1 && pixmap_geom.height == 1) {
-      return m_log.err("background_manager: Cannot find root pixmap, try a different tool to set the desktop background");
+      m_log.err("background_manager: Cannot find root pixmap, try a different tool to set the desktop background");
+      return false;
     }
 
+    vector<std::shared_ptr<bg_slice>> slices;
+    vector<xcb_translate_coordinates_cookie_t> cookies;
     for (auto it = m_slices.begin(); it != m_slices.end(); ) {
       auto slice = it->lock();
       if (!slice) {
         it = m_slices.erase(it);
         continue;
       }
+      cookies.emplace_back(xcb_translate_coordinates(
+          m_connection, slice->m_window, m_connection.screen()->root, slice->m_rect.x, slice->m_rect.y));
+      slices.emplace_back(move(slice));
+      it++;
+    }
+
+    for (size_t i = 0; i < slices.size(); i++) {
+      auto& slice = slices[i];
+      auto translated = xcb_translate_coordinates_reply(m_connection, cookies[i], nullptr);
+      if (translated == nullptr) {
+        m_log.err("background_manager: Failed to translate coordinates of slice");
+        continue;
+      }
+      xcb_point_t root_pos{translated->dst_x, translated->dst_y};
+      free(translated);
+
+      if (!force && slice->m_source == pixmap && slice->m_source_pos.x == root_pos.x &&
+          slice->m_source_pos.y == root_pos.y) {
+        continue;
+      }
 
       // fill the slice
-      auto translated = m_connection.translate_coordinates(slice->m_window, m_connection.screen()->root, slice->m_rect.x, slice->m_rect.y);
-      auto src_x = math_util::cap(translated->dst_x, pixmap_geom.x, int16_t(pixmap_geom.x + pixmap_geom.width));
-      auto src_y = math_util::cap(translated->dst_y, pixmap_geom.y, int16_t(pixmap_geom.y + pixmap_geom.height));
+      auto src_x = math_util::cap(root_pos.x, pixmap_geom.x, int16_t(pixmap_geom.x + pixmap_geom.width));
+      auto src_y = math_util::cap(root_pos.y, pixmap_geom.y, int16_t(pixmap_geom.y + pixmap_geom.height));
       auto w = math_util::cap(slice->m_rect.width, uint16_t(0), uint16_t(pixmap_geom.width - (src_x - pixmap_geom.x)));
       auto h = math_util::cap(slice->m_rect.height, uint16_t(0), uint16_t(pixmap_geom.height - (src_y - pixmap_geom.y)));
       m_log.trace("background_manager: Copying from root pixmap (%d:%d) %dx%d+%d+%d", pixmap, pixmap_depth, w, h, src_x, src_y);
-      m_connection.copy_area_checked(pixmap, slice->m_pixmap, slice->m_gcontext, src_x, src_y, 0, 0, w, h);
+      m_connection.copy_area(pixmap, slice->m_pixmap, slice->m_gcontext, src_x, src_y, 0, 0, w, h);
+      slice->m_surface->dirty();
+      slice->m_image.reset();
+      slice->m_source = pixmap;
+      slice->m_source_pos = root_pos;
+      changed = true;
+    }
 
-      it++;
+    if (changed) {
+      m_connection.flush();
     }
 
     // if there are no active slices, deactivate
@@ -120,6 +162,7 @@ void background_manager::fetch_root_pixmap() {
     throw;
   }
 
+  return changed;
 }
 
 void background_manager::handle(const evt::property_notify& evt) {
@@ -128,9 +171,11 @@ void background_manager::handle(const evt::property_notify& evt) {
     return;
   }
 
+  // the wallpaper may have been redrawn into the same pixmap, so always copy it again
   if (evt->atom == _XROOTPMAP_ID || evt->atom == _XSETROOT_ID || evt->atom == ESETROOT_PMAP_ID) {
-    fetch_root_pixmap();
-    m_sig.emit(signals::ui::update_background());
+    if (fetch_root_pixmap(true)) {
+      m_sig.emit(signals::ui::update_background());
+    }
   }
 }
 
@@ -140,8 +185,9 @@ bool background_manager::on(const signals::ui::update_geometry&) {
     return false;
   }
 
-  fetch_root_pixmap();
-  m_sig.emit(signals::ui::update_background());
+  if (fetch_root_pixmap(false)) {
+    m_sig.emit(signals::ui::update_background());
+  }
   return false;
 }
 
@@ -162,6 +208,18 @@ bg_slice::~bg_slice() {
   free_resources();
 }
 
+cairo::surface* bg_slice::get_image_surface() {
+  if (!m_image && m_surface) {
+    m_image = make_unique<cairo::image_surface>(CAIRO_FORMAT_ARGB32, m_rect.width, m_rect.height);
+    cairo_t* cr = cairo_create(*m_image);
+    cairo_set_operator(cr, CAIRO_OPERATOR_SOURCE);
+    cairo_set_source_surface(cr, *m_surface, 0.0, 0.0);
+    cairo_paint(cr);
+    cairo_destroy(cr);
+  }
+  return m_image.get();
+}
+
 void bg_slice::allocate_resources(const logger& log, xcb_visualtype_t* visual) {
   if(m_pixmap == XCB_NONE) {
     log.trace("background_manager: Allocating pixmap");
@@ -189,7 +247,8 @@ void bg_slice::allocate_resources(const logger& log, xcb_visualtype_t* visual) {
 }
 
 void bg_slice::free_resources() {
-  m_surface.release();
+  m_image.reset();
+  m_surface.reset();
 
   if(m_pixmap != XCB_NONE) {
     m_connection.free_pixmap(m_pixmap);
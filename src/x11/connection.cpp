@@ -97,6 +97,31 @@ void connection::ensure_event_mask(xcb_window_t win, unsigned int event) {
   change_window_attributes(win, XCB_CW_EVENT_MASK, &attributes->your_event_mask);
 }
 
+/**
+ * Add given event to the event mask of all windows
+ *
+ * All attribute requests are sent before the first reply is read,
+ * so this costs a single round trip
+ */
+void connection::ensure_event_mask(const vector<xcb_window_t>& windows, unsigned int event) {
+  vector<xcb_get_window_attributes_cookie_t> cookies;
+  cookies.reserve(windows.size());
+  for (auto&& win : windows) {
+    cookies.emplace_back(xcb_get_window_attributes(*this, win));
+  }
+
+  for (size_t i = 0; i < windows.size(); i++) {
+    auto reply = xcb_get_window_attributes_reply(*this, cookies[i], nullptr);
+    if (reply == nullptr) {
+      // The window is already gone
+      continue;
+    }
+    unsigned int mask = reply->your_event_mask | event;
+    free(reply);
+    xcb_change_window_attributes(*this, windows[i], XCB_CW_EVENT_MASK, &mask);
+  }
+}
+
 /**
  * Clear event mask for the given window
  */
@@ -5,6 +5,7 @@
 #include "x11/atoms.hpp"
 #include "x11/connection.hpp"
 #include "x11/ewmh.hpp"
+#include "x11/icccm.hpp"
 
 POLYBAR_NS
 
@@ -35,30 +36,15 @@ namespace ewmh_util {
   }
 
   string get_wm_name(xcb_window_t win) {
-    auto conn = initialize().get();
-    xcb_ewmh_get_utf8_strings_reply_t utf8_reply{};
-    if (xcb_ewmh_get_wm_name_reply(conn, xcb_ewmh_get_wm_name(conn, win), &utf8_reply, nullptr)) {
-      return get_reply_string(&utf8_reply);
-    }
-    return "";
+    return request_wm_name(win).get();
   }
 
   string get_visible_name(xcb_window_t win) {
-    auto conn = initialize().get();
-    xcb_ewmh_get_utf8_strings_reply_t utf8_reply{};
-    if (xcb_ewmh_get_wm_visible_name_reply(conn, xcb_ewmh_get_wm_visible_name(conn, win), &utf8_reply, nullptr)) {
-      return get_reply_string(&utf8_reply);
-    }
-    return "";
+    return request_visible_name(win).get();
   }
 
   string get_icon_name(xcb_window_t win) {
-    auto conn = initialize().get();
-    xcb_ewmh_get_utf8_strings_reply_t utf8_reply{};
-    if (xcb_ewmh_get_wm_icon_name_reply(conn, xcb_ewmh_get_wm_icon_name(conn, win), &utf8_reply, nullptr)) {
-      return get_reply_string(&utf8_reply);
-    }
-    return "";
+    return request_icon_name(win).get();
   }
 
   string get_reply_string(xcb_ewmh_get_utf8_strings_reply_t* reply) {
@@ -71,17 +57,11 @@ namespace ewmh_util {
   }
 
   unsigned int get_current_desktop(int screen) {
-    auto conn = initialize().get();
-    unsigned int desktop = XCB_NONE;
-    xcb_ewmh_get_current_desktop_reply(conn, xcb_ewmh_get_current_desktop(conn, screen), &desktop, nullptr);
-    return desktop;
+    return request_current_desktop(screen).get();
   }
 
   unsigned int get_number_of_desktops(int screen) {
-    auto conn = initialize().get();
-    unsigned int desktops = XCB_NONE;
-    xcb_ewmh_get_number_of_desktops_reply(conn, xcb_ewmh_get_number_of_desktops(conn, screen), &desktops, nullptr);
-    return desktops;
+    return request_number_of_desktops(screen).get();
   }
 
   vector<position> get_desktop_viewports(int screen) {
@@ -98,19 +78,11 @@ namespace ewmh_util {
   }
 
   vector<string> get_desktop_names(int screen) {
-    auto conn = initialize().get();
-    xcb_ewmh_get_utf8_strings_reply_t reply{};
-    if (xcb_ewmh_get_desktop_names_reply(conn, xcb_ewmh_get_desktop_names(conn, screen), &reply, nullptr)) {
-      return string_util::split(string(reply.strings, reply.strings_len), '\0');
-    }
-    return {};
+    return request_desktop_names(screen).get();
   }
 
   xcb_window_t get_active_window(int screen) {
-    auto conn = initialize().get();
-    unsigned int win = XCB_NONE;
-    xcb_ewmh_get_active_window_reply(conn, xcb_ewmh_get_active_window(conn, screen), &win, nullptr);
-    return win;
+    return request_active_window(screen).get();
   }
 
   void change_current_desktop(unsigned int desktop) {
@@ -120,10 +92,29 @@ namespace ewmh_util {
   }
 
   unsigned int get_desktop_from_window(xcb_window_t window) {
+    return request_desktop_from_window(window).get();
+  }
+
+  /**
+   * Get the desktops of all given windows
+   *
+   * All requests are sent before the first reply is read,
+   * so this costs a single round trip
+   */
+  vector<unsigned int> get_desktops_from_windows(const vector<xcb_window_t>& windows) {
     auto conn = initialize().get();
-    unsigned int desktop = XCB_NONE;
-    xcb_ewmh_get_wm_desktop_reply(conn, xcb_ewmh_get_wm_desktop(conn, window), &desktop, nullptr);
-    return desktop;
+
+    vector<xcb_get_property_cookie_t> cookies;
+    cookies.reserve(windows.size());
+    for (auto&& window : windows) {
+      cookies.emplace_back(xcb_ewmh_get_wm_desktop(conn, window));
+    }
+
+    vector<unsigned int> desktops(windows.size(), XCB_NONE);
+    for (size_t i = 0; i < cookies.size(); i++) {
+      xcb_ewmh_get_wm_desktop_reply(conn, cookies[i], &desktops[i], nullptr);
+    }
+    return desktops;
   }
 
   void set_wm_window_type(xcb_window_t win, vector<xcb_atom_t> types) {
@@ -176,10 +167,120 @@ namespace ewmh_util {
     auto conn = initialize().get();
     xcb_ewmh_get_windows_reply_t reply;
     if (xcb_ewmh_get_client_list_reply(conn, xcb_ewmh_get_client_list(conn, screen), &reply, nullptr)) {
-      return {reply.windows, reply.windows + reply.windows_len};
+      vector<xcb_window_t> windows{reply.windows, reply.windows + reply.windows_len};
+      xcb_ewmh_get_windows_reply_wipe(&reply);
+      return windows;
     }
     return {};
   }
+
+  namespace {
+    using utf8_request_t = xcb_get_property_cookie_t (*)(xcb_ewmh_connection_t*, xcb_window_t);
+    using utf8_reply_t = uint8_t (*)(
+        xcb_ewmh_connection_t*, xcb_get_property_cookie_t, xcb_ewmh_get_utf8_strings_reply_t*, xcb_generic_error_t**);
+    using cardinal_reply_t =
+        uint8_t (*)(xcb_ewmh_connection_t*, xcb_get_property_cookie_t, uint32_t*, xcb_generic_error_t**);
+
+    cookie_future<string> request_utf8(xcb_window_t win, utf8_request_t request, utf8_reply_t reply_fn) {
+      auto conn = initialize().get();
+      auto cookie = request(conn, win);
+      return cookie_future<string>(conn->connection, cookie.sequence, [=](unsigned int sequence) -> string {
+        xcb_ewmh_get_utf8_strings_reply_t reply{};
+        if (reply_fn(conn, xcb_get_property_cookie_t{sequence}, &reply, nullptr)) {
+          return get_reply_string(&reply);
+        }
+        return "";
+      });
+    }
+
+    cookie_future<unsigned int> request_cardinal(xcb_get_property_cookie_t cookie, cardinal_reply_t reply_fn) {
+      auto conn = initialize().get();
+      return cookie_future<unsigned int>(conn->connection, cookie.sequence, [=](unsigned int sequence) {
+        unsigned int value = XCB_NONE;
+        reply_fn(conn, xcb_get_property_cookie_t{sequence}, &value, nullptr);
+        return value;
+      });
+    }
+  }  // namespace
+
+  cookie_future<string> request_wm_name(xcb_window_t win) {
+    return request_utf8(win, xcb_ewmh_get_wm_name, xcb_ewmh_get_wm_name_reply);
+  }
+
+  cookie_future<string> request_visible_name(xcb_window_t win) {
+    return request_utf8(win, xcb_ewmh_get_wm_visible_name, xcb_ewmh_get_wm_visible_name_reply);
+  }
+
+  cookie_future<string> request_icon_name(xcb_window_t win) {
+    return request_utf8(win, xcb_ewmh_get_wm_icon_name, xcb_ewmh_get_wm_icon_name_reply);
+  }
+
+  cookie_future<vector<string>> request_desktop_names(int screen) {
+    auto conn = initialize().get();
+    auto cookie = xcb_ewmh_get_desktop_names(conn, screen);
+    return cookie_future<vector<string>>(conn->connection, cookie.sequence, [=](unsigned int sequence) {
+      xcb_ewmh_get_utf8_strings_reply_t reply{};
+      if (xcb_ewmh_get_desktop_names_reply(conn, xcb_get_property_cookie_t{sequence}, &reply, nullptr)) {
+        return string_util::split(get_reply_string(&reply), '\0');
+      }
+      return vector<string>{};
+    });
+  }
+
+  cookie_future<unsigned int> request_current_desktop(int screen) {
+    auto conn = initialize().get();
+    return request_cardinal(xcb_ewmh_get_current_desktop(conn, screen), xcb_ewmh_get_current_desktop_reply);
+  }
+
+  cookie_future<unsigned int> request_number_of_desktops(int screen) {
+    auto conn = initialize().get();
+    return request_cardinal(xcb_ewmh_get_number_of_desktops(conn, screen), xcb_ewmh_get_number_of_desktops_reply);
+  }
+
+  cookie_future<xcb_window_t> request_active_window(int screen) {
+    auto conn = initialize().get();
+    auto cookie = xcb_ewmh_get_active_window(conn, screen);
+    return cookie_future<xcb_window_t>(conn->connection, cookie.sequence, [=](unsigned int sequence) {
+      xcb_window_t win = XCB_NONE;
+      xcb_ewmh_get_active_window_reply(conn, xcb_get_property_cookie_t{sequence}, &win, nullptr);
+      return win;
+    });
+  }
+
+  cookie_future<unsigned int> request_desktop_from_window(xcb_window_t window) {
+    auto conn = initialize().get();
+    return request_cardinal(xcb_ewmh_get_wm_desktop(conn, window), xcb_ewmh_get_wm_desktop_reply);
+  }
+
+  /**
+   * Get the title of a window by returning the first non-empty value of:
+   *  _NET_WM_NAME
+   *  _NET_WM_VISIBLE_NAME (unless visible_name is false)
+   *  WM_NAME
+   *
+   * All properties are requested up front, so the lookup costs a single
+   * round trip no matter which one ends up being used. The replies of
+   * the unused requests are discarded.
+   */
+  string get_window_title(xcb_connection_t* conn, xcb_window_t win, bool visible_name) {
+    auto wm_name = request_wm_name(win);
+    vector<cookie_future<string>> fallbacks;
+    fallbacks.reserve(2);
+    if (visible_name) {
+      fallbacks.emplace_back(request_visible_name(win));
+    }
+    fallbacks.emplace_back(icccm_util::request_wm_name(conn, win));
+
+    if (!wm_name.get().empty()) {
+      return wm_name.get();
+    }
+    for (auto&& fallback : fallbacks) {
+      if (!fallback.get().empty()) {
+        return fallback.get();
+      }
+    }
+    return "";
+  }
 }
 
 POLYBAR_NS_END
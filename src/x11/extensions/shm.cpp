@@ -0,0 +1,143 @@
+#include "x11/extensions/shm.hpp"
+
+#include <sys/ipc.h>
+#include <sys/shm.h>
+
+#include "errors.hpp"
+#include "x11/connection.hpp"
+
+POLYBAR_NS
+
+namespace shm_util {
+  /**
+   * Query for the MIT-SHM extension
+   */
+  bool query_extension(connection& conn) {
+    auto ext = xcb_get_extension_data(conn, &xcb_shm_id);
+    if (ext == nullptr || !ext->present) {
+      return false;
+    }
+    auto version = xcb_shm_query_version_reply(conn, xcb_shm_query_version(conn), nullptr);
+    if (version == nullptr) {
+      return false;
+    }
+    free(version);
+    return true;
+  }
+
+  /**
+   * Check if images in the given visual use the same
+   * pixel layout as cairo's native 32bpp formats
+   */
+  bool compatible(connection& conn, xcb_visualtype_t* visual, int depth) {
+    if (depth != 24 && depth != 32) {
+      return false;
+    }
+    if (visual->red_mask != 0xff0000 || visual->green_mask != 0xff00 || visual->blue_mask != 0xff) {
+      return false;
+    }
+
+    auto setup = xcb_get_setup(conn);
+    const uint16_t probe{1};
+    const bool lsb_first{*reinterpret_cast<const uint8_t*>(&probe) == 1};
+    if ((setup->image_byte_order == XCB_IMAGE_ORDER_LSB_FIRST) != lsb_first) {
+      return false;
+    }
+
+    auto formats = xcb_setup_pixmap_formats(setup);
+    auto formats_len = xcb_setup_pixmap_formats_length(setup);
+    for (int i = 0; i < formats_len; i++) {
+      if (formats[i].depth == depth) {
+        return formats[i].bits_per_pixel == 32;
+      }
+    }
+    return false;
+  }
+}
+
+/**
+ * Allocate a shared segment large enough for a width x height image
+ * and attach it to the X server
+ */
+shm_image::shm_image(connection& conn, int depth, unsigned int width, unsigned int height)
+    : m_connection(conn), m_depth(depth), m_width(width), m_height(height) {
+  m_stride = cairo_format_stride_for_width(format(), m_width);
+  size_t size = static_cast<size_t>(m_stride) * m_height;
+
+  if ((m_shmid = shmget(IPC_PRIVATE, size, IPC_CREAT | 0600)) == -1) {
+    throw system_error("Failed to allocate shared memory segment");
+  }
+
+  void* data = shmat(m_shmid, nullptr, 0);
+  if (data == reinterpret_cast<void*>(-1)) {
+    shmctl(m_shmid, IPC_RMID, nullptr);
+    throw system_error("Failed to attach shared memory segment");
+  }
+  m_data = static_cast<unsigned char*>(data);
+
+  m_segment = m_connection.generate_id();
+  auto err = xcb_request_check(m_connection, xcb_shm_attach_checked(m_connection, m_segment, m_shmid, true));
+
+  // Once both sides are attached, marking the segment as removed
+  // makes sure it goes away when we exit, even if we crash
+  shmctl(m_shmid, IPC_RMID, nullptr);
+
+  if (err != nullptr) {
+    free(err);
+    m_segment = XCB_NONE;
+    shmdt(m_data);
+    throw application_error("X server failed to attach shared memory segment");
+  }
+}
+
+shm_image::~shm_image() {
+  sync();
+
+  if (m_segment != XCB_NONE) {
+    xcb_shm_detach(m_connection, m_segment);
+    xcb_flush(m_connection);
+  }
+  if (m_data != nullptr) {
+    shmdt(m_data);
+  }
+}
+
+unsigned char* shm_image::data() const {
+  return m_data;
+}
+
+cairo_format_t shm_image::format() const {
+  return m_depth == 32 ? CAIRO_FORMAT_ARGB32 : CAIRO_FORMAT_RGB24;
+}
+
+int shm_image::stride() const {
+  return m_stride;
+}
+
+/**
+ * Copy the given area of the image into the same area of dst
+ */
+void shm_image::put(xcb_drawable_t dst, xcb_gcontext_t gc, const xcb_rectangle_t& rect) {
+  xcb_shm_put_image(m_connection, dst, gc, m_width, m_height, rect.x, rect.y, rect.width, rect.height, rect.x, rect.y,
+      m_depth, XCB_IMAGE_FORMAT_Z_PIXMAP, false, m_segment, 0);
+
+  // Requests are processed in order, so once this reply arrives
+  // the server has finished reading the segment
+  m_fence = xcb_get_input_focus(m_connection);
+  m_pending = true;
+}
+
+/**
+ * Block until the server is done reading the image
+ *
+ * This is usually immediate, since the reply arrives while the next frame
+ * is being prepared.
+ */
+void shm_image::sync() {
+  if (m_pending) {
+    free(xcb_get_input_focus_reply(m_connection, m_fence, nullptr));
+    m_pending = false;
+  }
+}
+
+POLYBAR_NS_END
@@ -5,11 +5,7 @@ POLYBAR_NS
 
 namespace icccm_util {
   string get_wm_name(xcb_connection_t* c, xcb_window_t w) {
-    xcb_icccm_get_text_property_reply_t reply{};
-    if (xcb_icccm_get_wm_name_reply(c, xcb_icccm_get_wm_name(c, w), &reply, nullptr)) {
-      return get_reply_string(&reply);
-    }
-    return "";
+    return request_wm_name(c, w).get();
   }
 
   string get_reply_string(xcb_icccm_get_text_property_reply_t* reply) {
@@ -31,12 +27,29 @@ namespace icccm_util {
   }
 
   bool get_wm_urgency(xcb_connection_t* c, xcb_window_t w) {
-    xcb_icccm_wm_hints_t hints;
-    if (xcb_icccm_get_wm_hints_reply(c, xcb_icccm_get_wm_hints(c, w), &hints, NULL)) {
-      if(xcb_icccm_wm_hints_get_urgency(&hints) == XCB_ICCCM_WM_HINT_X_URGENCY)
-        return true;
-    }
-    return false;
+    return request_wm_urgency(c, w).get();
+  }
+
+  cookie_future<string> request_wm_name(xcb_connection_t* c, xcb_window_t w) {
+    auto cookie = xcb_icccm_get_wm_name(c, w);
+    return cookie_future<string>(c, cookie.sequence, [c](unsigned int sequence) -> string {
+      xcb_icccm_get_text_property_reply_t reply{};
+      if (xcb_icccm_get_wm_name_reply(c, xcb_get_property_cookie_t{sequence}, &reply, nullptr)) {
+        return get_reply_string(&reply);
+      }
+      return "";
+    });
+  }
+
+  cookie_future<bool> request_wm_urgency(xcb_connection_t* c, xcb_window_t w) {
+    auto cookie = xcb_icccm_get_wm_hints(c, w);
+    return cookie_future<bool>(c, cookie.sequence, [c](unsigned int sequence) {
+      xcb_icccm_wm_hints_t hints;
+      if (xcb_icccm_get_wm_hints_reply(c, xcb_get_property_cookie_t{sequence}, &hints, nullptr)) {
+        return xcb_icccm_wm_hints_get_urgency(&hints) == XCB_ICCCM_WM_HINT_X_URGENCY;
+      }
+      return false;
+    });
   }
 }
 
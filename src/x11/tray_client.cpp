@@ -27,12 +27,14 @@ unsigned int tray_client::height() const {
   return m_height;
 }
 
-void tray_client::clear_window() const {
-  try {
-    m_connection.clear_area_checked(1, window(), 0, 0, width(), height());
-  } catch (const xpp::x::error::window& err) {
-    // ignore
-  }
+/**
+ * Clear the client window, generating an expose event
+ *
+ * The request is checked, but it is up to the caller to collect the
+ * result. This allows clearing all clients in a single round trip.
+ */
+xcb_void_cookie_t tray_client::clear_window() const {
+  return xcb_clear_area_checked(m_connection, 1, window(), 0, 0, width(), height());
 }
 
 /**
@@ -70,6 +72,35 @@ xembed_data* tray_client::xembed() const {
   return m_xembed.get();
 }
 
+/**
+ * Get position assigned by the tray layout
+ */
+int tray_client::x() const {
+  return m_x;
+}
+
+int tray_client::y() const {
+  return m_y;
+}
+
+/**
+ * Assign a new position, the window is only moved by configure()
+ */
+void tray_client::place(int x, int y) {
+  if (x != m_x || y != m_y) {
+    m_x = x;
+    m_y = y;
+    m_placed = false;
+  }
+}
+
+/**
+ * Check if the window is at the position assigned by the tray layout
+ */
+bool tray_client::placed() const {
+  return m_placed;
+}
+
 /**
  * Make sure that the window mapping state is correct
  */
@@ -98,6 +129,26 @@ void tray_client::reconfigure(int x, int y) const {
   m_connection.configure_window_checked(window(), configure_mask, configure_values);
 }
 
+/**
+ * Move and resize the window to its assigned position
+ *
+ * Like clear_window(), the caller has to collect the result.
+ */
+xcb_void_cookie_t tray_client::configure() {
+  unsigned int configure_mask = 0;
+  unsigned int configure_values[7];
+  xcb_params_configure_window_t configure_params{};
+
+  XCB_AUX_ADD_PARAM(&configure_mask, &configure_params, width, m_width);
+  XCB_AUX_ADD_PARAM(&configure_mask, &configure_params, height, m_height);
+  XCB_AUX_ADD_PARAM(&configure_mask, &configure_params, x, m_x);
+  XCB_AUX_ADD_PARAM(&configure_mask, &configure_params, y, m_y);
+
+  connection::pack_values(configure_mask, &configure_params, configure_values);
+  m_placed = true;
+  return xcb_configure_window_checked(m_connection, window(), configure_mask, configure_values);
+}
+
 /**
  * Respond to client resize requests
  */
@@ -251,6 +251,7 @@ void tray_manager::deactivate(bool clear_selection) {
 
   m_log.trace("tray: Unembed clients");
   m_clients.clear();
+  m_mapped_clients = 0;
 
   if (m_tray) {
     m_log.trace("tray: Destroy window");
@@ -337,14 +338,16 @@ void tray_manager::reconfigure_window() {
   }
 
   auto width = calculate_w();
+  auto height = calculate_h();
   auto x = calculate_x(width);
 
-  if (m_opts.transparent) {
-    xcb_rectangle_t rect{0, 0, calculate_w(), calculate_h()};
+  // Only observe a new slice of the background if the window size changed
+  if (m_opts.transparent && (width != m_prevwidth || height != m_prevheight)) {
+    xcb_rectangle_t rect{0, 0, width, height};
     m_bg_slice = m_background_manager.observe(rect, m_tray);
   }
 
-  if (width > 0) {
+  if (width > 0 && (width != m_prevwidth || x != m_opts.configured_x)) {
     m_log.trace("tray: New window values, width=%d, x=%d", width, x);
 
     unsigned int mask = 0;
@@ -357,6 +360,8 @@ void tray_manager::reconfigure_window() {
     m_connection.configure_window_checked(m_tray, mask, values);
   }
 
+  m_prevwidth = width;
+  m_prevheight = height;
   m_opts.configured_w = width;
   m_opts.configured_x = x;
 }
@@ -367,20 +372,36 @@ void tray_manager::reconfigure_window() {
 void tray_manager::reconfigure_clients() {
   m_log.trace("tray: Reconfigure clients");
 
-  int x = m_opts.spacing;
+  update_layout();
 
-  for (auto it = m_clients.rbegin(); it != m_clients.rend(); it++) {
-    auto client = *it;
+  vector<xcb_window_t> failed;
+  vector<std::pair<xcb_window_t, xcb_void_cookie_t>> requests;
 
+  // Only clients that moved are configured. All requests are sent before
+  // the first one is checked, so this costs a single round trip.
+  for (auto&& client : m_clients) {
     try {
       client->ensure_state();
-      client->reconfigure(x, calculate_client_y());
-
-      x += m_opts.width + m_opts.spacing;
     } catch (const xpp::x::error::window& err) {
-      remove_client(client, false);
+      failed.emplace_back(client->window());
+      continue;
+    }
+    if (!client->placed()) {
+      requests.emplace_back(client->window(), client->configure());
+    }
+  }
+
+  for (auto&& request : requests) {
+    auto err = xcb_request_check(m_connection, request.second);
+    if (err != nullptr) {
+      free(err);
+      failed.emplace_back(request.first);
     }
   }
+
+  for (auto&& win : failed) {
+    remove_client(win, false);
+  }
 }
 
 /**
@@ -435,8 +456,15 @@ void tray_manager::refresh_window() {
 
   m_connection.clear_area(0, m_tray, 0, 0, width, height);
 
+  vector<xcb_void_cookie_t> requests;
+  requests.reserve(m_clients.size());
   for (auto&& client : m_clients) {
-    client->clear_window();
+    requests.emplace_back(client->clear_window());
+  }
+
+  // Errors from clients that went away in the meantime are not important
+  for (auto&& request : requests) {
+    free(xcb_request_check(m_connection, request));
   }
 
   m_connection.flush();
@@ -732,6 +760,7 @@ void tray_manager::process_docking_request(xcb_window_t win) {
 
   m_clients.emplace_back(factory_util::shared<tray_client>(m_connection, win, m_opts.width, m_opts.height));
   auto& client = m_clients.back();
+  update_layout();
 
   try {
     m_log.trace("tray: Get client _XEMBED_INFO");
@@ -799,15 +828,8 @@ int tray_manager::calculate_y(bool abspos) const {
  * Calculate width of tray window
  */
 unsigned short int tray_manager::calculate_w() const {
-  unsigned int width = m_opts.spacing;
-  unsigned int count{0};
-  for (auto&& client : m_clients) {
-    if (client->mapped()) {
-      count++;
-      width += m_opts.spacing + m_opts.width;
-    }
-  }
-  return count ? width : 0;
+  unsigned int count{mapped_clients()};
+  return count ? m_opts.spacing + count * (m_opts.spacing + m_opts.width) : 0;
 }
 
 /**
@@ -821,12 +843,8 @@ unsigned short int tray_manager::calculate_h() const {
  * Calculate x position of client window
  */
 int tray_manager::calculate_client_x(const xcb_window_t& win) {
-  for (unsigned int i = 0; i < m_clients.size(); i++) {
-    if (m_clients[i]->match(win)) {
-      return m_opts.spacing + m_opts.width * i;
-    }
-  }
-  return m_opts.spacing;
+  auto client = find_client(win);
+  return client ? client->x() : m_opts.spacing;
 }
 
 /**
@@ -836,6 +854,23 @@ int tray_manager::calculate_client_y() {
   return (m_opts.height_fill - m_opts.height) / 2;
 }
 
+/**
+ * Assign a position to every client
+ *
+ * Clients are placed from the most recently docked one onwards, so each
+ * offset is the running sum of the slots before it. Clients only get
+ * reconfigured if their position changed.
+ */
+void tray_manager::update_layout() {
+  int x = m_opts.spacing;
+  int y = calculate_client_y();
+
+  for (auto it = m_clients.rbegin(); it != m_clients.rend(); it++) {
+    (*it)->place(x, y);
+    x += m_opts.width + m_opts.spacing;
+  }
+}
+
 /**
  * Check if the given window is embedded
  */
@@ -867,8 +902,14 @@ void tray_manager::remove_client(shared_ptr<tray_client>& client, bool reconfigu
  * Remove tray client by window
  */
 void tray_manager::remove_client(xcb_window_t win, bool reconfigure) {
-  m_clients.erase(std::remove_if(
-      m_clients.begin(), m_clients.end(), [win](shared_ptr<tray_client> client) { return client->match(win); }));
+  auto it = std::remove_if(
+      m_clients.begin(), m_clients.end(), [win](shared_ptr<tray_client> client) { return client->match(win); });
+  for (auto removed = it; removed != m_clients.end(); removed++) {
+    if ((*removed)->mapped()) {
+      m_mapped_clients--;
+    }
+  }
+  m_clients.erase(it, m_clients.end());
 
   if (reconfigure) {
     tray_manager::reconfigure();
@@ -879,15 +920,7 @@ void tray_manager::remove_client(xcb_window_t win, bool reconfigure) {
  * Get number of mapped clients
  */
 unsigned int tray_manager::mapped_clients() const {
-  unsigned int mapped_clients = 0;
-
-  for (auto&& client : m_clients) {
-    if (client->mapped()) {
-      mapped_clients++;
-    }
-  }
-
-  return mapped_clients;
+  return m_mapped_clients;
 }
 
 /**
@@ -1079,7 +1112,11 @@ void tray_manager::handle(const evt::map_notify& evt) {
   } else if (is_embedded(evt->window)) {
     m_log.trace("tray: Received map_notify");
     m_log.trace("tray: Set client mapped");
-    find_client(evt->window)->mapped(true);
+    auto client = find_client(evt->window);
+    if (!client->mapped()) {
+      client->mapped(true);
+      m_mapped_clients++;
+    }
     unsigned int clientcount{mapped_clients()};
     if (clientcount > m_opts.configured_slots) {
       reconfigure();
@@ -1099,7 +1136,11 @@ void tray_manager::handle(const evt::unmap_notify& evt) {
   } else if (m_activated && is_embedded(evt->window)) {
     m_log.trace("tray: Received unmap_notify");
     m_log.trace("tray: Set client unmapped");
-    find_client(evt->window)->mapped(false);
+    auto client = find_client(evt->window);
+    if (client->mapped()) {
+      client->mapped(false);
+      m_mapped_clients--;
+    }
     m_sig.emit(signals::ui_tray::mapped_clients{mapped_clients()});
   }
 }
@@ -0,0 +1,42 @@
+/**
+ * Measures the time needed to render a 40 segment gradient progressbar
+ *
+ * Run with: make benchmark.progressbar && ./tests/benchmark.progressbar [iterations]
+ */
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+#include "components/builder.hpp"
+#include "drawtypes/label.hpp"
+#include "drawtypes/progressbar.hpp"
+
+using namespace polybar;
+using namespace polybar::drawtypes;
+
+int main(int argc, char** argv) {
+  size_t iterations = argc > 1 ? strtoul(argv[1], nullptr, 10) : 100000;
+
+  bar_settings bar{};
+  auto pbar = make_shared<progressbar>(bar, 40, "%fill%%indicator%%empty%");
+  pbar->set_gradient(true);
+  pbar->set_colors({"#55aa55", "#557755", "#f5a70a", "#ff5555"});
+  pbar->set_fill(make_shared<label>("─"));
+  pbar->set_indicator(make_shared<label>("|"));
+  pbar->set_empty(make_shared<label>("─", "#444444"));
+
+  size_t bytes{0};
+  auto start = std::chrono::steady_clock::now();
+
+  for (size_t i = 0; i < iterations; i++) {
+    bytes += pbar->output(static_cast<float>(i % 101)).size();
+  }
+
+  auto elapsed = std::chrono::steady_clock::now() - start;
+  auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+
+  printf("progressbar (40 segments, gradient): %zu iterations, %.1f ns/op, %zu bytes\n", iterations,
+      static_cast<double>(ns) / iterations, bytes);
+
+  return 0;
+}
@@ -0,0 +1,153 @@
+#include "cairo/utils.hpp"
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <fstream>
+
+#include "common/test.hpp"
+#include "utils/file.hpp"
+
+using namespace polybar;
+using namespace polybar::cairo::utils;
+
+/**
+ * \brief Fixture class
+ */
+class FontCache : public ::testing::Test {
+ protected:
+  string dir;
+  string path;
+  string font_file;
+
+  void SetUp() override {
+    char tmpl[] = "/tmp/polybar-fonts-XXXXXX";
+    ASSERT_NE(nullptr, mkdtemp(tmpl));
+    dir = tmpl;
+    path = dir + "/cache/fonts";
+    // Matches are only valid while their font file exists
+    font_file = dir + "/font.ttf";
+    std::ofstream(font_file) << "";
+  }
+
+  void TearDown() override {
+    unlink(path.c_str());
+    rmdir((dir + "/cache").c_str());
+    unlink(font_file.c_str());
+    rmdir(dir.c_str());
+  }
+
+  FcPattern* make_match() const {
+    FcPattern* match = FcPatternCreate();
+    FcPatternAddString(match, FC_FAMILY, reinterpret_cast<const FcChar8*>("Test Sans"));
+    FcPatternAddString(match, FC_FILE, reinterpret_cast<const FcChar8*>(font_file.c_str()));
+    FcPatternAddDouble(match, FC_PIXEL_SIZE, 12.0);
+    return match;
+  }
+
+  static string family(FcPattern* match) {
+    FcChar8* value;
+    if (match == nullptr || FcPatternGetString(match, FC_FAMILY, 0, &value) != FcResultMatch) {
+      return "";
+    }
+    return reinterpret_cast<const char*>(value);
+  }
+
+  /**
+   * Stamp of the current fontconfig setup, taken from a written cache
+   */
+  string stamp() {
+    {
+      font_cache cache{path};
+      FcPattern* match = make_match();
+      cache.put("stamp", 96, 96, match);
+      FcPatternDestroy(match);
+    }
+    string contents{file_util::contents(path)};
+    return contents.substr(0, contents.find('\t'));
+  }
+};
+
+TEST_F(FontCache, roundtrip) {
+  {
+    font_cache cache{path};
+    EXPECT_EQ(nullptr, cache.get("Test Sans:size=12", 96, 96));
+
+    FcPattern* match = make_match();
+    cache.put("Test Sans:size=12", 96, 96, match);
+    FcPatternDestroy(match);
+
+    // Nothing is written until the cache is saved
+    EXPECT_FALSE(file_util::exists(path));
+    cache.save();
+    EXPECT_TRUE(file_util::exists(path));
+  }
+
+  font_cache cache{path};
+  FcPattern* match = cache.get("Test Sans:size=12", 96, 96);
+  EXPECT_EQ("Test Sans", family(match));
+  FcPatternDestroy(match);
+
+  // The dpi is part of the key
+  EXPECT_EQ(nullptr, cache.get("Test Sans:size=12", 120, 120));
+}
+
+TEST_F(FontCache, savedOnDestruction) {
+  {
+    font_cache cache{path};
+    FcPattern* match = make_match();
+    cache.put("Test Sans", 96, 96, match);
+    FcPatternDestroy(match);
+  }
+
+  font_cache cache{path};
+  FcPattern* match = cache.get("Test Sans", 96, 96);
+  EXPECT_EQ("Test Sans", family(match));
+  FcPatternDestroy(match);
+}
+
+TEST_F(FontCache, stampMismatch) {
+  string current{stamp()};
+  string line{"\tTest Sans@96.000000x96.000000\tTest Sans:file=" + font_file + "\n"};
+
+  std::ofstream(path) << "0" << line;
+  EXPECT_EQ(nullptr, font_cache{path}.get("Test Sans", 96, 96));
+
+  std::ofstream(path) << current << line;
+  FcPattern* match = font_cache{path}.get("Test Sans", 96, 96);
+  EXPECT_EQ("Test Sans", family(match));
+  FcPatternDestroy(match);
+}
+
+TEST_F(FontCache, missingFontFile) {
+  {
+    font_cache cache{path};
+    FcPattern* match = make_match();
+    cache.put("Test Sans", 96, 96, match);
+    FcPatternDestroy(match);
+  }
+  unlink(font_file.c_str());
+
+  EXPECT_EQ(nullptr, font_cache{path}.get("Test Sans", 96, 96));
+}
+
+TEST_F(FontCache, missingOrCorruptFile) {
+  EXPECT_EQ(nullptr, font_cache{dir + "/missing/fonts"}.get("Test Sans", 96, 96));
+
+  mkdir((dir + "/cache").c_str(), 0700);
+  std::ofstream(path) << "garbage\n\t\t\nno tabs at all\n" << string(16, '\0') << "\n";
+
+  font_cache cache{path};
+  EXPECT_EQ(nullptr, cache.get("Test Sans", 96, 96));
+  EXPECT_EQ(nullptr, cache.get("garbage", 96, 96));
+
+  // A corrupt file is replaced by the next save
+  FcPattern* match = make_match();
+  cache.put("Test Sans", 96, 96, match);
+  FcPatternDestroy(match);
+  cache.save();
+
+  match = font_cache{path}.get("Test Sans", 96, 96);
+  EXPECT_EQ("Test Sans", family(match));
+  FcPatternDestroy(match);
+}
@@ -0,0 +1,91 @@
+#include "components/action_index.hpp"
+
+#include "common/test.hpp"
+#include "utils/trace.hpp"
+
+using namespace polybar;
+
+namespace {
+  action_block make_action(mousebtn button, double start, double end, string command, bool active = false) {
+    action_block a{};
+    a.button = button;
+    a.command = move(command);
+    a.start_x = start;
+    a.end_x = end;
+    a.active = active;
+    return a;
+  }
+}
+
+TEST(ActionIndex, empty) {
+  action_index index{};
+  EXPECT_EQ(nullptr, index.find(0));
+  EXPECT_EQ(nullptr, index.find(mousebtn::LEFT, 0));
+  EXPECT_FALSE(index.has_double_click());
+}
+
+TEST(ActionIndex, regions) {
+  action_index index{{make_action(mousebtn::LEFT, 10, 20, "a"), make_action(mousebtn::SCROLL_UP, 30, 40.5, "b")}};
+
+  EXPECT_EQ(nullptr, index.find(9));
+  EXPECT_EQ(nullptr, index.find(20));
+  EXPECT_EQ(nullptr, index.find(25));
+  EXPECT_EQ(nullptr, index.find(40));
+
+  auto r = index.find(10);
+  ASSERT_NE(nullptr, r);
+  EXPECT_TRUE(r->click);
+  EXPECT_FALSE(r->scroll);
+  EXPECT_EQ(r, index.find(19));
+
+  r = index.find(39);
+  ASSERT_NE(nullptr, r);
+  EXPECT_FALSE(r->click);
+  EXPECT_TRUE(r->scroll);
+}
+
+TEST(ActionIndex, nestedActionsPreferInnermost) {
+  action_index index{{make_action(mousebtn::LEFT, 0, 100, "outer"), make_action(mousebtn::LEFT, 40, 60, "inner"),
+      make_action(mousebtn::RIGHT, 50, 70, "right")}};
+
+  EXPECT_EQ("outer", index.find(mousebtn::LEFT, 39)->command);
+  EXPECT_EQ("inner", index.find(mousebtn::LEFT, 40)->command);
+  EXPECT_EQ("inner", index.find(mousebtn::LEFT, 59)->command);
+  EXPECT_EQ("outer", index.find(mousebtn::LEFT, 60)->command);
+  EXPECT_EQ("right", index.find(mousebtn::RIGHT, 65)->command);
+  EXPECT_EQ(nullptr, index.find(mousebtn::RIGHT, 45));
+  EXPECT_EQ(nullptr, index.find(mousebtn::MIDDLE, 50));
+  EXPECT_NE(index.find(45), index.find(55));
+}
+
+TEST(ActionIndex, unclosedActions) {
+  action_index index{{make_action(mousebtn::DOUBLE_LEFT, 0, 0, "a", true)}};
+
+  EXPECT_EQ(nullptr, index.find(0));
+  EXPECT_TRUE(index.has_double_click());
+}
+
+TEST(ActionIndex, reassign) {
+  vector<action_block> actions{make_action(mousebtn::LEFT, 0, 100, "a command that doesn't fit into a small string"),
+      make_action(mousebtn::RIGHT, 40, 60, "another command that doesn't fit into a small string"),
+      make_action(mousebtn::DOUBLE_LEFT, 120, 130, "c")};
+
+  action_index index{actions};
+  EXPECT_TRUE(index.has_double_click());
+
+  actions.pop_back();
+  actions[0].end_x = 50;
+  index.assign(actions.data(), actions.size());
+  EXPECT_FALSE(index.has_double_click());
+  EXPECT_EQ(nullptr, index.find(125));
+  EXPECT_EQ(nullptr, index.find(mousebtn::LEFT, 50));
+  EXPECT_EQ(actions[1].command, index.find(mousebtn::RIGHT, 50)->command);
+
+  // The storage is reused for the same set of actions
+#ifdef DEBUG_ALLOCATIONS
+  auto before = trace_util::allocations();
+  index.assign(actions.data(), actions.size());
+  EXPECT_EQ(0, trace_util::allocations() - before);
+#endif
+  EXPECT_EQ(actions[0].command, index.find(mousebtn::LEFT, 10)->command);
+}
@@ -0,0 +1,61 @@
+#include "components/block_layout.hpp"
+
+#include "common/test.hpp"
+
+using namespace polybar;
+
+TEST(BlockLayout, empty) {
+  block_layout layout{1000.0, 0.0, 0.0, 0.0};
+
+  for (auto a : {alignment::NONE, alignment::LEFT, alignment::CENTER, alignment::RIGHT}) {
+    EXPECT_EQ(0.0, layout.get(a).width);
+    EXPECT_EQ(0.0, layout.get(a).visible);
+  }
+}
+
+TEST(BlockLayout, fitting) {
+  block_layout layout{1000.0, 100.0, 200.0, 300.0};
+
+  EXPECT_EQ(0.0, layout.get(alignment::LEFT).x);
+  // Centered between the end of the left and the start of the right block
+  EXPECT_EQ(300.0, layout.get(alignment::CENTER).x);
+  EXPECT_EQ(700.0, layout.get(alignment::RIGHT).x);
+
+  for (auto a : {alignment::LEFT, alignment::CENTER, alignment::RIGHT}) {
+    EXPECT_FALSE(layout.get(a).overflows());
+    EXPECT_EQ(layout.get(a).width, layout.get(a).visible);
+  }
+}
+
+TEST(BlockLayout, fixedCenter) {
+  EXPECT_EQ(400.0, block_layout(1000.0, 100.0, 200.0, 300.0, true, 500.0).get(alignment::CENTER).x);
+  // Pushed to the left by the right block
+  EXPECT_EQ(330.0, block_layout(1000.0, 100.0, 200.0, 450.0, true, 500.0).get(alignment::CENTER).x);
+  // But never into the left block
+  EXPECT_EQ(420.0, block_layout(1000.0, 400.0, 200.0, 450.0, true, 500.0).get(alignment::CENTER).x);
+}
+
+TEST(BlockLayout, overflow) {
+  block_layout layout{1000.0, 400.0, 200.0, 450.0, true, 500.0};
+
+  // The right block is pushed past the canvas
+  const auto& right = layout.get(alignment::RIGHT);
+  EXPECT_EQ(640.0, right.x);
+  EXPECT_EQ(360.0, right.visible);
+  EXPECT_TRUE(right.overflows());
+
+  // Without a center block the left block is the barrier
+  EXPECT_EQ(920.0, block_layout(1000.0, 900.0, 0.0, 200.0).get(alignment::RIGHT).x);
+  EXPECT_EQ(80.0, block_layout(1000.0, 900.0, 0.0, 200.0).get(alignment::RIGHT).visible);
+
+  // Blocks starting past the canvas aren't visible at all
+  EXPECT_EQ(0.0, block_layout(1000.0, 1200.0, 0.0, 200.0).get(alignment::RIGHT).visible);
+  EXPECT_EQ(1000.0, block_layout(1000.0, 1200.0, 0.0, 200.0).get(alignment::LEFT).visible);
+}
+
+TEST(BlockLayout, rounding) {
+  block_layout layout{1000.0, 100.4, 0.0, 99.6};
+
+  EXPECT_EQ(900.0, layout.get(alignment::RIGHT).x);
+  EXPECT_EQ(100.0, layout.get(alignment::RIGHT).visible);
+}
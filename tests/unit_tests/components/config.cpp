@@ -0,0 +1,95 @@
+#include "components/config.hpp"
+
+#include "common/test.hpp"
+#include "components/logger.hpp"
+
+using namespace polybar;
+
+/**
+ * \brief Fixture class
+ */
+class Config : public ::testing::Test {
+ protected:
+  logger m_log{loglevel::NONE};
+  config m_conf{m_log, "", "test"};
+
+  void SetUp() override {
+    sectionmap_t sections;
+    sections["bar/test"] = {{"width", "100"}, {"height", "${self.width}"}, {"color", "${colors.fg}"}};
+    sections["colors"] = {{"fg", "#ff0000"}, {"unset", "${env:POLYBAR_TEST_UNSET_VARIABLE}"}};
+    sections["list"] = {{"item-0", "a"}, {"item-1", "${colors.fg}"}};
+    sections["typed"] = {{"flag", "Yes"}, {"number", "-42"}, {"unsigned", "42"}, {"real", "1.5"},
+        {"interval", "${self.unsigned}"}, {"env", "${env:POLYBAR_TEST_CONFIG_VARIABLE}"}};
+    sections["derived"] = {{"half", "${color:colors.fg:alpha=0.5}"}, {"half-again", "${color:#ff0000:alpha=0.5}"},
+        {"chained", "${color:colors.fg:lum*1:alpha=0.5}"}, {"invalid", "${color:colors.fg:foo=1}"}};
+    m_conf.set_sections(move(sections));
+    setenv("POLYBAR_TEST_CONFIG_VARIABLE", "before", 1);
+    m_conf.compile();
+  }
+};
+
+TEST_F(Config, resolvesReferences) {
+  EXPECT_EQ(100, m_conf.get<int>("bar/test", "width"));
+  EXPECT_EQ(100, m_conf.get<int>("bar/test", "height"));
+  EXPECT_EQ("#ff0000", m_conf.get("bar/test", "color"));
+  EXPECT_EQ("#ff0000", m_conf.get<string>("bar/test", "color", "#000000"));
+}
+
+TEST_F(Config, missing) {
+  EXPECT_THROW(m_conf.get("bar/test", "missing"), key_error);
+  EXPECT_THROW(m_conf.get("missing", "width"), key_error);
+  EXPECT_EQ(5, m_conf.get<int>("bar/test", "missing", 5));
+}
+
+TEST_F(Config, unresolvableReferenceThrowsOnAccess) {
+  EXPECT_THROW(m_conf.get("colors", "unset"), value_error);
+}
+
+TEST_F(Config, list) {
+  vector<string> expected{"a", "#ff0000"};
+  EXPECT_EQ(expected, m_conf.get_list("list", "item"));
+  EXPECT_EQ(vector<string>{"x"}, m_conf.get_list<string>("list", "missing", {"x"}));
+}
+
+TEST_F(Config, derivedColors) {
+  EXPECT_EQ("#80ff0000", m_conf.get("derived", "half"));
+  EXPECT_EQ(m_conf.get("derived", "half"), m_conf.get("derived", "half-again"));
+  EXPECT_EQ(m_conf.get("derived", "half"), m_conf.get("derived", "chained"));
+  EXPECT_THROW(m_conf.get("derived", "invalid"), value_error);
+}
+
+TEST_F(Config, setOverridesResolvedValue) {
+  m_conf.set("colors", "fg", "#00ff00");
+  EXPECT_EQ("#00ff00", m_conf.get("colors", "fg"));
+  EXPECT_EQ("#00ff00", m_conf.get("bar/test", "color"));
+  m_conf.set("bar/test", "new", "${colors.fg}");
+  EXPECT_EQ("#00ff00", m_conf.get("bar/test", "new"));
+}
+
+TEST_F(Config, typedValues) {
+  EXPECT_TRUE(m_conf.get<bool>("typed", "flag"));
+  EXPECT_FALSE(m_conf.get<bool>("typed", "number"));
+  EXPECT_EQ(-42, m_conf.get<int>("typed", "number"));
+  EXPECT_EQ(-42L, m_conf.get<long>("typed", "number"));
+  EXPECT_EQ(42U, m_conf.get<unsigned int>("typed", "unsigned"));
+  EXPECT_EQ(42UL, m_conf.get<unsigned long>("typed", "interval"));
+  EXPECT_DOUBLE_EQ(1.5, m_conf.get<double>("typed", "real"));
+  EXPECT_EQ(chrono::milliseconds{42}, m_conf.get("typed", "interval", chrono::milliseconds{0}));
+  EXPECT_EQ(chrono::duration<double>{1.5}, m_conf.get("typed", "real", chrono::duration<double>{0}));
+  EXPECT_EQ(-42, m_conf.get<int>("typed", "missing", -42));
+}
+
+TEST_F(Config, setResolvesDependentsOnly) {
+  m_conf.set("bar/test", "chained", "${bar/test.color}");
+  setenv("POLYBAR_TEST_CONFIG_VARIABLE", "after", 1);
+
+  m_conf.set("colors", "fg", "#0000ff");
+  EXPECT_EQ("#0000ff", m_conf.get("bar/test", "chained"));
+  EXPECT_EQ("#800000ff", m_conf.get("derived", "half"));
+
+  // Parameters unrelated to the change keep their resolved value
+  EXPECT_EQ("before", m_conf.get("typed", "env"));
+
+  m_conf.set("typed", "unsigned", "7");
+  EXPECT_EQ(7U, m_conf.get<unsigned int>("typed", "interval"));
+}
@@ -1,5 +1,10 @@
 #include "components/config_parser.hpp"
 
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <fstream>
+
 #include "common/test.hpp"
 #include "components/logger.hpp"
 
@@ -26,6 +31,12 @@ class TestableConfigParser : public config_parser {
 
  public:
   using config_parser::m_files;
+
+ public:
+  using config_parser::parse_file;
+
+ public:
+  using config_parser::create_sectionmap;
 };
 
 /**
@@ -33,8 +44,8 @@ class TestableConfigParser : public config_parser {
  */
 class ConfigParser : public ::testing::Test {
  protected:
-  unique_ptr<TestableConfigParser> parser =
-      make_unique<TestableConfigParser>(logger(loglevel::NONE), "/dev/zero", "TEST");
+  logger m_log{loglevel::NONE};
+  unique_ptr<TestableConfigParser> parser = make_unique<TestableConfigParser>(m_log, "/dev/zero", "TEST");
 };
 
 // ParseLineTest {{{
@@ -236,3 +247,81 @@ TEST_F(ParseHeaderTest, throwsSyntaxError) {
   EXPECT_THROW(parser->parse_header("[root]"), syntax_error);
 }
 // }}}
+
+// ParseFileTest {{{
+
+/**
+ * \brief Fixture for tests on parse_file, creates a config tree in a temporary directory
+ */
+class ParseFileTest : public ConfigParser {
+ protected:
+  string dir;
+  vector<string> created;
+
+  void SetUp() override {
+    char tmpl[] = "/tmp/polybar-config-XXXXXX";
+    ASSERT_NE(nullptr, mkdtemp(tmpl));
+    dir = tmpl;
+    mkdir((dir + "/fragments").c_str(), 0700);
+  }
+
+  void TearDown() override {
+    for (auto it = created.rbegin(); it != created.rend(); ++it) {
+      unlink(it->c_str());
+    }
+    rmdir((dir + "/fragments").c_str());
+    rmdir(dir.c_str());
+  }
+
+  string write(const string& name, const string& contents) {
+    string path = dir + "/" + name;
+    std::ofstream(path) << contents;
+    created.emplace_back(path);
+    return path;
+  }
+};
+
+TEST_F(ParseFileTest, includesInOrder) {
+  string main = write("main.ini", "[a]\nx = 1\ninclude-directory = " + dir + "/fragments\ny = 2\ninclude-file = " + dir +
+                                      "/last.ini\n[e]\nk = 4\n");
+  write("fragments/02.ini", "[c]\nk = 2\n");
+  write("fragments/01.ini", "[b]\nk = 1\n");
+  // No trailing newline
+  write("last.ini", "[d]\n; comment\nk = 3");
+
+  parser->parse_file(main, {});
+  sectionmap_t sections = parser->create_sectionmap();
+
+  vector<string> expected_files{main, dir + "/fragments/01.ini", dir + "/fragments/02.ini", dir + "/last.ini"};
+  EXPECT_EQ(expected_files, parser->m_files);
+
+  // y comes after the included section headers and so belongs to [c]
+  EXPECT_EQ(1, sections["a"].size());
+  EXPECT_EQ("1", sections["b"]["k"]);
+  EXPECT_EQ("2", sections["c"]["k"]);
+  EXPECT_EQ("2", sections["c"]["y"]);
+  EXPECT_EQ("3", sections["d"]["k"]);
+  EXPECT_EQ("4", sections["e"]["k"]);
+}
+
+TEST_F(ParseFileTest, errorsInIncludedFiles) {
+  string main = write("main.ini", "[a]\ninclude-file = " + dir + "/broken.ini\n");
+  write("broken.ini", "[b]\n\nunknown\n");
+
+  try {
+    parser->parse_file(main, {});
+    FAIL() << "Expected syntax_error";
+  } catch (const syntax_error& err) {
+    EXPECT_EQ(dir + "/broken.ini:3: Unknown line type: unknown", string{err.what()});
+  }
+
+  EXPECT_THROW(parser->parse_file(dir + "/missing.ini", {}), application_error);
+}
+
+TEST_F(ParseFileTest, dependencyCycle) {
+  string main = write("main.ini", "[a]\ninclude-file = " + dir + "/other.ini\n");
+  write("other.ini", "[b]\ninclude-file = " + main + "\n");
+
+  EXPECT_THROW(parser->parse_file(main, {}), application_error);
+}
+// }}}
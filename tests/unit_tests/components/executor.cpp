@@ -0,0 +1,90 @@
+#include "components/executor.hpp"
+
+#include <future>
+
+#include "common/test.hpp"
+#include "components/logger.hpp"
+
+using namespace polybar;
+
+/**
+ * \brief Fixture class
+ */
+class Executor : public ::testing::Test {
+ protected:
+  logger m_log{loglevel::NONE};
+  executor m_exec{m_log, 2, 1};
+};
+
+TEST_F(Executor, runsPostedTasks) {
+  executor::group g{"test", executor::pool::CPU};
+  std::promise<void> done;
+  std::atomic<int> count{0};
+
+  for (int i = 0; i < 100; i++) {
+    m_exec.post(g, [&] {
+      if (++count == 100) {
+        done.set_value();
+      }
+    });
+  }
+
+  EXPECT_EQ(std::future_status::ready, done.get_future().wait_for(5s));
+  m_exec.cancel(g);
+}
+
+TEST_F(Executor, timedTasksInDeadlineOrder) {
+  executor::group g{"test", executor::pool::IO};
+  std::promise<void> done;
+  std::atomic<bool> late{false};
+
+  // A task with an earlier deadline is not held up by one posted before it
+  auto now = executor::clock::now();
+  m_exec.post_at(g, now + 1h, [&] { late = true; });
+  m_exec.post_at(g, now, [&] { done.set_value(); });
+
+  EXPECT_EQ(std::future_status::ready, done.get_future().wait_for(5s));
+  EXPECT_FALSE(late);
+  m_exec.cancel(g);
+}
+
+TEST_F(Executor, cancelDropsPendingTasks) {
+  executor::group g{"test", executor::pool::CPU};
+  std::atomic<bool> ran{false};
+
+  m_exec.post_at(g, executor::clock::now() + 50ms, [&] { ran = true; });
+  m_exec.cancel(g);
+  m_exec.post(g, [&] { ran = true; });
+
+  // cancel() waits for all tasks the group still has
+  m_exec.cancel(g);
+  EXPECT_FALSE(ran);
+}
+
+TEST_F(Executor, cancelFromOwnTask) {
+  executor::group g{"test", executor::pool::CPU};
+  std::promise<void> done;
+
+  m_exec.post(g, [&] {
+    m_exec.cancel(g);
+    done.set_value();
+  });
+
+  EXPECT_EQ(std::future_status::ready, done.get_future().wait_for(5s));
+  m_exec.cancel(g);
+}
+
+TEST_F(Executor, slowGroupsAreMoved) {
+  // Every task takes longer than this
+  executor::group g{"test", executor::pool::CPU, 1ns};
+
+  for (int i = 0; i < 3; i++) {
+    std::promise<void> done;
+    m_exec.post(g, [&] { done.set_value(); });
+    done.get_future().wait();
+  }
+
+  // The group is updated before its task counts as finished
+  m_exec.cancel(g);
+  EXPECT_TRUE(g.slow());
+}
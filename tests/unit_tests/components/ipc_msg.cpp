@@ -0,0 +1,32 @@
+#include "common/test.hpp"
+#include "components/ipc_msg.hpp"
+
+using namespace polybar;
+
+TEST(IpcMsg, roundtrip) {
+  vector<string> messages{"cmd:toggle", "hook:module/demo1", "", "action:#demo.send.a b"};
+  string frame{ipc_msg::encode(ipc_msg::type::REQUEST, messages)};
+
+  ipc_msg::header hdr{};
+  ASSERT_GE(frame.size(), sizeof(hdr));
+  memcpy(&hdr, frame.data(), sizeof(hdr));
+
+  EXPECT_TRUE(ipc_msg::valid(hdr));
+  EXPECT_EQ(ipc_msg::type::REQUEST, hdr.msg_type);
+  EXPECT_EQ(frame.size() - sizeof(hdr), hdr.size);
+  EXPECT_EQ(messages, ipc_msg::decode(frame.substr(sizeof(hdr))));
+}
+
+TEST(IpcMsg, invalidHeader) {
+  string frame{ipc_msg::encode(ipc_msg::type::REQUEST, {"cmd:quit"})};
+
+  ipc_msg::header hdr{};
+  memcpy(&hdr, frame.data(), sizeof(hdr));
+
+  hdr.magic[0] = 'x';
+  EXPECT_FALSE(ipc_msg::valid(hdr));
+
+  memcpy(&hdr, frame.data(), sizeof(hdr));
+  hdr.size = ipc_msg::MAX_SIZE + 1;
+  EXPECT_FALSE(ipc_msg::valid(hdr));
+}
@@ -1,9 +1,51 @@
 #include "common/test.hpp"
+#include "events/signal.hpp"
 #include "events/signal_emitter.hpp"
+#include "components/action_index.hpp"
+#include "components/block_layout.hpp"
+#include "components/builder.hpp"
 #include "components/parser.hpp"
+#include "utils/trace.hpp"
 
 using namespace polybar;
 
+#ifndef DEBUG_ALLOCATIONS
+/*
+ * Without DEBUG_ALLOCATIONS polybar doesn't count heap allocations,
+ * so this test replaces the global operator new itself
+ */
+namespace {
+  thread_local uint64_t g_allocations{0};
+}
+
+void* operator new(std::size_t size) {
+  g_allocations++;
+  if (void* ptr = std::malloc(size == 0 ? 1 : size)) {
+    return ptr;
+  }
+  throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept {
+  std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept {
+  std::free(ptr);
+}
+#endif
+
+/**
+ * Heap allocations made by the calling thread
+ */
+static uint64_t allocations() {
+#ifdef DEBUG_ALLOCATIONS
+  return trace_util::allocations();
+#else
+  return g_allocations;
+#endif
+}
+
 class TestableParser : public parser {
   using parser::parser;
   public: using parser::parse_action_cmd;
@@ -35,3 +77,187 @@ TEST_P(ParseActionCmd, correctness) {
   auto result = m_parser.parse_action_cmd(std::move(input));
   EXPECT_EQ(GetParam().first, result);
 }
+
+/**
+ * Keeps the values of the signals the way the renderer does
+ */
+class TextSink : public signal_receiver<0, signals::parser::change_background, signals::parser::text,
+                     signals::parser::action_begin> {
+ public:
+  bool on(const signals::parser::change_background& evt) override {
+    background = evt.cast();
+    return true;
+  }
+  bool on(const signals::parser::text& evt) override {
+    text = evt.cast();
+    return true;
+  }
+  bool on(const signals::parser::action_begin& evt) override {
+    command = evt.cast().command;
+    return true;
+  }
+
+  tag_color background;
+  string text;
+  string command;
+};
+
+TEST_F(Parser, steadyStateWithoutAllocations) {
+  const string contents{
+      "%{l}%{B#ff112233 F#ffeeddcc}%{A1:notify-send \\:hello world\\::}text of the first module%{A}"
+      "%{r}%{+u}%{T2}text of the second module%{T-}%{-u}%{B- F-}"};
+
+  TextSink sink;
+  signal_emitter::make().attach(&sink);
+
+  // Buffers grow on the first frame
+  m_parser.parse(contents);
+
+  auto before = allocations();
+  m_parser.parse(contents);
+  EXPECT_EQ(0, allocations() - before);
+
+  EXPECT_EQ("notify-send :hello world:", sink.command);
+  EXPECT_EQ("text of the second module", sink.text);
+
+  signal_emitter::make().detach(&sink);
+}
+
+/**
+ * Lays out the blocks and collects the actions of a frame the way the
+ * renderer does, with every character taking up 10 pixels
+ */
+class FrameSink : public signal_receiver<0, signals::parser::change_alignment, signals::parser::text,
+                      signals::parser::action_begin, signals::parser::action_end> {
+ public:
+  bool on(const signals::parser::change_alignment& evt) override {
+    align = evt.cast();
+    return true;
+  }
+  bool on(const signals::parser::text& evt) override {
+    widths[static_cast<int>(align)] += 10.0 * evt.cast().size();
+    return true;
+  }
+  bool on(const signals::parser::action_begin& evt) override {
+    if (num_actions == actions.size()) {
+      actions.emplace_back();
+    }
+    auto& action = actions[num_actions++];
+    action.button = evt.cast().button;
+    action.command = evt.cast().command;
+    action.align = align;
+    action.start_x = widths[static_cast<int>(align)];
+    action.active = true;
+    return true;
+  }
+  bool on(const signals::parser::action_end&) override {
+    for (size_t i = num_actions; i > 0; i--) {
+      auto& action = actions[i - 1];
+      if (action.active && action.align == align) {
+        action.end_x = widths[static_cast<int>(align)];
+        action.active = false;
+        break;
+      }
+    }
+    return true;
+  }
+
+  void begin() {
+    align = alignment::NONE;
+    std::fill(std::begin(widths), std::end(widths), 0.0);
+    num_actions = 0;
+  }
+
+  void end() {
+    layout = block_layout{1000.0, widths[static_cast<int>(alignment::LEFT)],
+        widths[static_cast<int>(alignment::CENTER)], widths[static_cast<int>(alignment::RIGHT)]};
+    for (size_t i = 0; i < num_actions; i++) {
+      actions[i].start_x += layout.get(actions[i].align).x;
+      actions[i].end_x += layout.get(actions[i].align).x;
+    }
+    index.assign(actions.data(), num_actions);
+  }
+
+  alignment align{alignment::NONE};
+  double widths[4]{};
+  vector<action_block> actions;
+  size_t num_actions{0};
+  block_layout layout{};
+  action_index index{};
+};
+
+TEST_F(Parser, frameWithoutAllocations) {
+  bar_settings bar{};
+  builder b{bar};
+  FrameSink sink;
+  signal_emitter::make().attach(&sink);
+
+  // Modules keep their texts and commands between updates
+  const string first_cmd{"notify-send :hello world: from the first module"};
+  const string first_text{"text of the first module"};
+  const string second_text{"text of the second module"};
+  string contents;
+
+  auto frame = [&] {
+    contents.clear();
+    contents += "%{l}";
+    b.background("#ff112233");
+    b.cmd(mousebtn::LEFT, first_cmd);
+    b.node(first_text);
+    b.cmd_close();
+    b.flush(contents);
+    contents += "%{r}";
+    b.underline("#ffeeddcc");
+    b.font(2);
+    b.node(second_text);
+    b.flush(contents);
+
+    sink.begin();
+    m_parser.parse(contents);
+    sink.end();
+  };
+
+  // Buffers grow on the first frame
+  frame();
+
+  auto before = allocations();
+  frame();
+  EXPECT_EQ(0, allocations() - before);
+
+  EXPECT_DOUBLE_EQ(250.0, sink.layout.get(alignment::RIGHT).width);
+  EXPECT_EQ(750.0, sink.layout.get(alignment::RIGHT).x);
+  ASSERT_NE(nullptr, sink.index.find(mousebtn::LEFT, 100));
+  EXPECT_EQ("notify-send :hello world: from the first module", sink.index.find(mousebtn::LEFT, 100)->command);
+  EXPECT_EQ(nullptr, sink.index.find(mousebtn::LEFT, 300));
+
+  signal_emitter::make().detach(&sink);
+}
+
+TEST_F(Parser, colors) {
+  TextSink sink;
+  signal_emitter::make().attach(&sink);
+
+  m_parser.parse("%{B#f00}");
+  EXPECT_EQ(tag_color::type::PLAIN, sink.background.kind);
+  EXPECT_EQ(0xFFFF0000, sink.background.value);
+
+  m_parser.parse("%{B#80112233}");
+  EXPECT_EQ(0x80112233, sink.background.value);
+
+  m_parser.parse("%{B-}");
+  EXPECT_EQ(tag_color::type::NONE, sink.background.kind);
+
+  m_parser.parse("%{Banim:gradient:2}");
+  EXPECT_EQ(tag_color::type::ANIMATED, sink.background.kind);
+  ASSERT_NE(nullptr, sink.background.anim);
+  EXPECT_EQ("gradient:2", *sink.background.anim);
+
+  // Animations are interned
+  auto anim = sink.background.anim;
+  m_parser.parse("%{B#fff}%{Banim:gradient:2}");
+  EXPECT_EQ(anim, sink.background.anim);
+
+  EXPECT_THROW(m_parser.parse("%{B#12345}"), unrecognized_token);
+
+  signal_emitter::make().detach(&sink);
+}
@@ -0,0 +1,82 @@
+#include "components/taskqueue.hpp"
+
+#include <poll.h>
+
+#include "common/test.hpp"
+
+using namespace polybar;
+
+namespace {
+  /**
+   * Wait for the queue to become ready and run its due tasks
+   */
+  bool wait_and_process(taskqueue& queue, int timeout_ms = 1000) {
+    pollfd fd{queue.get_file_descriptor(), POLLIN, 0};
+    if (poll(&fd, 1, timeout_ms) != 1) {
+      return false;
+    }
+    queue.process();
+    return true;
+  }
+}
+
+TEST(Taskqueue, runsInDeadlineOrder) {
+  taskqueue queue;
+  vector<string> order;
+
+  queue.defer("c", 30ms, [&](size_t) { order.emplace_back("c"); });
+  queue.defer("a", 10ms, [&](size_t) { order.emplace_back("a"); });
+  queue.defer("b", 20ms, [&](size_t) { order.emplace_back("b"); });
+
+  while (order.size() < 3 && wait_and_process(queue)) {
+  }
+
+  EXPECT_EQ((vector<string>{"a", "b", "c"}), order);
+  EXPECT_FALSE(queue.exist("a"));
+}
+
+TEST(Taskqueue, repeatedTasks) {
+  taskqueue queue;
+  vector<size_t> remaining;
+
+  queue.defer("repeat", 5ms, [&](size_t r) { remaining.emplace_back(r); }, 0ms, 3);
+
+  while (remaining.size() < 3 && wait_and_process(queue)) {
+  }
+
+  EXPECT_EQ((vector<size_t>{2, 1, 0}), remaining);
+  EXPECT_FALSE(queue.exist("repeat"));
+}
+
+TEST(Taskqueue, uniqueAndPurge) {
+  taskqueue queue;
+  int calls{0};
+
+  queue.defer("task", 10ms, [&](size_t) { calls += 1; });
+  queue.defer("task", 10ms, [&](size_t) { calls += 1; });
+  queue.defer_unique("task", 10ms, [&](size_t) { calls += 10; });
+  queue.defer("other", 1000ms, [&](size_t) { calls += 100; });
+  EXPECT_TRUE(queue.exist("task"));
+
+  EXPECT_TRUE(wait_and_process(queue));
+  EXPECT_EQ(10, calls);
+  EXPECT_FALSE(queue.exist("task"));
+
+  EXPECT_TRUE(queue.purge("other"));
+  EXPECT_FALSE(queue.purge("other"));
+  EXPECT_FALSE(wait_and_process(queue, 50));
+}
+
+TEST(Taskqueue, callbackCanDefer) {
+  taskqueue queue;
+  int calls{0};
+
+  queue.defer("first", 0ms, [&](size_t) {
+    calls++;
+    queue.defer_unique("second", 0ms, [&](size_t) { calls++; });
+  });
+
+  EXPECT_TRUE(wait_and_process(queue));
+  EXPECT_TRUE(wait_and_process(queue));
+  EXPECT_EQ(2, calls);
+}
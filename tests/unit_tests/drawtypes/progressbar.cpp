@@ -0,0 +1,67 @@
+#include "common/test.hpp"
+#include "components/builder.hpp"
+#include "drawtypes/label.hpp"
+#include "drawtypes/progressbar.hpp"
+#include "utils/math.hpp"
+#include "utils/string.hpp"
+
+using namespace polybar;
+using namespace polybar::drawtypes;
+
+class Progressbar : public ::testing::Test {
+ protected:
+  /**
+   * Builds the output the way it is described in the documentation:
+   * every token is rendered on its own and substituted in the format
+   */
+  string reference(const string& format, unsigned int width, float percentage, const vector<string>& colors) {
+    builder b{m_bar};
+    unsigned int perc = math_util::cap(percentage, 0.0f, 100.0f);
+    unsigned int fill_width = math_util::percentage_to_value(perc, width);
+    size_t colorstep = colors.empty() ? 1 : width / colors.size();
+
+    auto fill = make_shared<label>("=");
+    size_t color = 0;
+    for (size_t i = 0; i < fill_width; i++) {
+      if (i % colorstep == 0 && color < colors.size()) {
+        fill->m_foreground = colors[color++];
+      }
+      b.node(fill);
+    }
+    string output = string_util::replace_all(format, "%fill%", b.flush());
+    b.node_repeat(make_shared<label>("-"), width - fill_width);
+    return string_util::replace_all(output, "%empty%", b.flush());
+  }
+
+  progressbar_t make(const string& format, unsigned int width, vector<string> colors) {
+    auto pbar = make_shared<progressbar>(m_bar, width, format);
+    pbar->set_gradient(true);
+    pbar->set_colors(move(colors));
+    pbar->set_fill(make_shared<label>("="));
+    pbar->set_empty(make_shared<label>("-"));
+    return pbar;
+  }
+
+  bar_settings m_bar{};
+};
+
+TEST_F(Progressbar, plain) {
+  auto pbar = make("%fill%%empty%", 10, {});
+  EXPECT_EQ("=====-----", pbar->output(50));
+  EXPECT_EQ("----------", pbar->output(0));
+  EXPECT_EQ("==========", pbar->output(100));
+}
+
+TEST_F(Progressbar, surroundingText) {
+  auto pbar = make("[%fill%|%empty%] %fill%", 4, {});
+  EXPECT_EQ("[==|--] ==", pbar->output(50));
+}
+
+TEST_F(Progressbar, gradient) {
+  vector<string> colors{"#ff0000", "#00ff00", "#0000ff", "#ffffff"};
+  auto pbar = make("%fill%%empty%", 40, colors);
+
+  for (float perc : {0.0f, 10.0f, 33.0f, 50.0f, 87.5f, 100.0f}) {
+    EXPECT_EQ(reference("%fill%%empty%", 40, perc, colors), pbar->output(perc));
+  }
+}
@@ -0,0 +1,38 @@
+#include "modules/meta/base.hpp"
+
+#include "common/test.hpp"
+#include "drawtypes/label.hpp"
+
+using namespace polybar;
+using namespace modules;
+
+TEST(ModuleFormat, compile) {
+  module_format format;
+  format.value = " <label> - <bar-load>%<ramp";
+  format.compile();
+
+  ASSERT_EQ(4, format.ops.size());
+  EXPECT_EQ(format_op::type::TEXT, format.ops[0].kind);
+  EXPECT_EQ(" ", format.ops[0].value);
+  EXPECT_EQ("", format.ops[0].trimmed);
+  EXPECT_EQ(format_op::type::TAG, format.ops[1].kind);
+  EXPECT_EQ("<label>", format.ops[1].value);
+  EXPECT_EQ(format_op::type::TEXT, format.ops[2].kind);
+  EXPECT_EQ(" - ", format.ops[2].value);
+  EXPECT_EQ("- ", format.ops[2].trimmed);
+  EXPECT_EQ(format_op::type::TAG, format.ops[3].kind);
+  EXPECT_EQ("<bar-load>", format.ops[3].value);
+  EXPECT_EQ("%<ramp", format.tail);
+}
+
+TEST(ModuleFormat, recompile) {
+  module_format format;
+  format.value = "<date>";
+  format.compile();
+  format.value = "<label> text";
+  format.compile();
+
+  ASSERT_EQ(1, format.ops.size());
+  EXPECT_EQ("<label>", format.ops[0].value);
+  EXPECT_EQ(" text", format.tail);
+}
@@ -0,0 +1,62 @@
+#include "common/test.hpp"
+#include "utils/concurrency.hpp"
+
+using namespace polybar;
+
+TEST(MpscRing, fifo) {
+  mpsc_ring<int, 4> ring;
+  int value{0};
+
+  EXPECT_FALSE(ring.pop(value));
+
+  for (int i = 0; i < 4; i++) {
+    EXPECT_TRUE(ring.push(i));
+  }
+  EXPECT_FALSE(ring.push(4));
+
+  for (int i = 0; i < 4; i++) {
+    EXPECT_TRUE(ring.pop(value));
+    EXPECT_EQ(i, value);
+  }
+  EXPECT_FALSE(ring.pop(value));
+
+  // Wrap around
+  EXPECT_TRUE(ring.push(5));
+  EXPECT_TRUE(ring.pop(value));
+  EXPECT_EQ(5, value);
+}
+
+TEST(MpscRing, concurrentProducers) {
+  mpsc_ring<size_t, 64> ring;
+  const size_t producers{4};
+  const size_t per_producer{10000};
+
+  vector<thread> threads;
+  for (size_t p = 0; p < producers; p++) {
+    threads.emplace_back([&, p] {
+      for (size_t i = 0; i < per_producer; i++) {
+        while (!ring.push(p * per_producer + i)) {
+          this_thread::yield();
+        }
+      }
+    });
+  }
+
+  // Values of each producer have to arrive in order
+  vector<size_t> next(producers, 0);
+  size_t received{0};
+  size_t value;
+  while (received < producers * per_producer) {
+    if (!ring.pop(value)) {
+      this_thread::yield();
+      continue;
+    }
+    size_t p = value / per_producer;
+    ASSERT_EQ(next[p]++, value % per_producer);
+    received++;
+  }
+
+  for (auto&& t : threads) {
+    t.join();
+  }
+}
@@ -0,0 +1,118 @@
+#include <unistd.h>
+
+#include <cstdio>
+#include <fstream>
+
+#include "common/test.hpp"
+#include "utils/concurrency.hpp"
+#include "utils/trace.hpp"
+
+using namespace polybar;
+
+TEST(Histogram, empty) {
+  trace_util::histogram hist;
+  EXPECT_EQ(0, hist.count());
+  EXPECT_EQ(0, hist.percentile(0.5));
+  EXPECT_EQ(0, hist.max());
+}
+
+TEST(Histogram, exactSmallValues) {
+  trace_util::histogram hist;
+  for (uint64_t i = 0; i < 8; i++) {
+    hist.record(i);
+  }
+  EXPECT_EQ(8, hist.count());
+  EXPECT_EQ(3, hist.percentile(0.5));
+  EXPECT_EQ(7, hist.percentile(1.0));
+}
+
+TEST(Histogram, relativeError) {
+  for (uint64_t value : {9ULL, 100ULL, 12345ULL, 1000000ULL, 987654321ULL}) {
+    trace_util::histogram hist;
+    hist.record(value);
+    hist.record(value * 4);
+
+    auto p50 = hist.percentile(0.5);
+    EXPECT_GE(p50, value);
+    EXPECT_LE(p50, value + value / trace_util::histogram::SUB_BUCKETS);
+    EXPECT_EQ(value * 4, hist.percentile(1.0));
+  }
+}
+
+TEST(Histogram, reset) {
+  trace_util::histogram hist;
+  hist.record(1000);
+  hist.reset();
+  EXPECT_EQ(0, hist.count());
+  EXPECT_EQ(0, hist.max());
+}
+
+TEST(Trace, stagesAreShared) {
+  auto& a = trace_util::get_stage("test:stage");
+  auto& b = trace_util::get_stage("test:stage");
+  EXPECT_EQ(&a, &b);
+
+  { trace_util::scope s{a}; }
+  EXPECT_EQ(1, b.hist.count());
+}
+
+TEST(Trace, countsAllocations) {
+#ifndef DEBUG_ALLOCATIONS
+  GTEST_SKIP() << "Allocations are only counted when built with DEBUG_ALLOCATIONS";
+#endif
+  auto& s = trace_util::get_stage("test:allocations");
+  {
+    trace_util::scope scope{s};
+    auto value = make_unique<int>(1);
+    auto values = make_unique<int[]>(2);
+  }
+  EXPECT_EQ(2, s.allocations);
+
+  trace_util::reset();
+  EXPECT_EQ(0, s.allocations);
+}
+
+TEST(Trace, captureWhileRecording) {
+  char tmpl[] = "/tmp/polybar-trace-XXXXXX";
+  int fd = mkstemp(tmpl);
+  ASSERT_NE(-1, fd);
+  close(fd);
+  string path{tmpl};
+
+  auto& s = trace_util::get_stage("test:\"quoted\"\\stage");
+  std::atomic<bool> running{true};
+  std::atomic<size_t> spans{0};
+
+  vector<thread> threads;
+  for (int i = 0; i < 4; i++) {
+    threads.emplace_back([&] {
+      while (running) {
+        {
+          trace_util::scope scope{s};
+        }
+        spans++;
+      }
+    });
+  }
+
+  for (int i = 0; i < 10; i++) {
+    trace_util::start_capture();
+    // Wait until spans were recorded during the capture
+    size_t start{spans};
+    while (spans < start + 8) {
+      this_thread::yield();
+    }
+    EXPECT_TRUE(trace_util::dump(path));
+  }
+
+  running = false;
+  for (auto&& t : threads) {
+    t.join();
+  }
+
+  std::ifstream in(path);
+  string contents{std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()};
+  std::remove(path.c_str());
+
+  EXPECT_NE(string::npos, contents.find(R"("name":"test:\"quoted\"\\stage")"));
+}